@@ -13,34 +13,65 @@
 #include <stdlib.h>
 #include <cstring>
 #include <string>
+#include <string_view>
+#include <memory_resource>
 #include <cmath>
-#include "sqlite3.h"
+#include "database.h"
+#include "changeLog.h"
+#include "ledger.h"
+#include "currency.h"
+#include "idempotencyStore.h"
+#include "holdBook.h"
+#include "balanceCheckpoints.h"
+
+// The types of account a customer can open. Stored in the accounts table by name.
+enum class accountKind
+{
+    chequing,
+    savings
+};
+
+const int accountKindCount = 2; // The number of values in accountKind
+
+bool parseAccountKind(std::string_view name, accountKind &kind); // Turns a stored account type into an accountKind
+std::string_view accountKindName(accountKind kind);             // Returns the name an accountKind is stored under
 
 class account
 {
 private:
-    sqlite3 *DB;
-    char *errorMessage;
-    std::string sql;
-    std::string username;
-    std::string accountType;
+    database *DB; // Shared with the customer that owns the account, never closed by the account
+    int userID;                // The ID of the user the account belongs to
+    std::pmr::string username; // Allocated from the memory resource the account is built with
+    std::pmr::string currency; // The code of the currency the balance is held in
+    accountKind kind;
     double balance;
     int accountID;
-    int rc, step;
 
 public:
-    account(std::string accountType, std::string username, double initialMoney); // For creating an account
-    account(std::string accountType, std::string username);                      // For storing existing accounts
+    account(database *DB, accountKind kind, int userID, std::string_view username, double initialMoney, std::string_view currency = baseCurrency,
+            std::pmr::memory_resource *resource = std::pmr::get_default_resource()); // For creating an account
+    account(database *DB, int accountID, accountKind kind, int userID, std::string_view username, double balance,
+            std::string_view currency = baseCurrency, std::pmr::memory_resource *resource = std::pmr::get_default_resource()); // For storing existing accounts
+    account(const account &) = default;
+    account(account &&) noexcept = default;
+    account &operator=(const account &) = default;
+    account &operator=(account &&) noexcept = default;
     ~account();
     double getBalance(); // Returns balance for this account
+    double getAvailableBalance();                         // Returns the balance less the funds held for card authorizations
+    long long authorize(double amount, int seconds = 0); // Holds funds for a card authorization, returns the hold's ID or -1
+    std::optional<double> getBalanceAsOf(std::string_view timestamp); // Returns the balance at a past time, from the nearest checkpoint
     bool applyForLoan(double amount);
-    int getID();                  // Returns accountID for this account
-    std::string getUserName();    // Returns the username the account belongs to
-    std::string getAccountType(); // Returns the accountType for this account
-    bool withdraw(double amount); // Withdraws money from the account
-    bool deposit(double amount);  // Deposits money into the account
-    void storeValues();           // Resets values for accountID, balance, and accountType
-    void refreshBalance();        // Refreshes value for balance
+    int getID() const;                          // Returns accountID for this account
+    int getUserID() const;                      // Returns the ID of the user the account belongs to
+    std::string_view getUserName() const;       // Returns the username the account belongs to
+    std::string_view getAccountType() const;    // Returns the accountType for this account
+    std::string_view getCurrency() const;       // Returns the code of the currency the balance is held in
+    accountKind getAccountKind() const;         // Returns the accountType for this account as an accountKind
+    bool withdraw(double amount, std::string_view idempotencyKey = {}); // Withdraws money from the account, once per key
+    bool deposit(double amount, std::string_view idempotencyKey = {});  // Deposits money into the account, once per key
+    void storeValues();                         // Resets values for balance and accountType
+    void refreshBalance();                      // Refreshes value for balance
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,49 @@
+/** @brief Provides the templace for accountPurger
+ *
+ *  Defines the variables and functions used by the accountPurger class
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file accountPurger.h
+ */
+
+#ifndef ACCOUNT_PURGER_H
+#define ACCOUNT_PURGER_H
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "database.h"
+#include "bankConfig.h"
+#include "ledger.h"
+
+bool createPurgeQueue(database &db); // Creates the table of deleted accounts whose journal entries are still to be detached
+
+class accountPurger
+{
+private:
+    database DB;
+    std::mutex databaseLock; // The background thread and callers share the connection
+    int batchSize;
+    std::chrono::milliseconds pause; // Time left between batches, so other writers get the lock
+    std::chrono::milliseconds idle;  // Time between checks of an empty queue
+    std::thread worker;
+    std::mutex stateLock;
+    std::condition_variable wakeUp;
+    bool stopping;
+    bool woken;
+
+    void work();
+
+public:
+    accountPurger(const bankConfig &config = bankSettings(), bool background = true);
+    accountPurger(const accountPurger &) = delete;
+    accountPurger &operator=(const accountPurger &) = delete;
+    ~accountPurger();
+    int purgeBatch(); // Detaches up to batchSize entries of the oldest deleted account, returns the entries detached or -1
+    int getPending(); // Returns the number of deleted accounts not yet purged
+    void wake();      // Starts on the queue now rather than at the next check
+};
+
+#endif
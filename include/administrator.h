@@ -9,20 +9,57 @@
 #define ADMINISTRATOR_H
 
 #include <iostream>
+#include <functional>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <chrono>
 #include "user.h"
 #include "analytics.h"
-#include "sqlite3.h"
+#include "database.h"
+#include "accountPurger.h"
+#include "changeLog.h"
+#include "currency.h"
+#include "bankConfig.h"
+#include "ledger.h"
+#include "userDirectory.h"
+#include "existenceFilter.h"
+
+// Everything an administrator sees about a user, read in one query
+struct userProfile {
+	int userID;
+	std::string username;
+	std::string name;
+	int creditScore;
+	double loanDebt;
+	std::string userType;
+	static auto columns() {
+		return std::make_tuple(&userProfile::userID, &userProfile::username, &userProfile::name, &userProfile::creditScore,
+							   &userProfile::loanDebt, &userProfile::userType);
+	}
+};
 
 class administrator : public user {
 	private:
-		sqlite3 *db;
-		char *errorMessage;
-		int rc, step, empty;
-		std::string sql, user;
+		// A profile, and when it was read
+		struct cachedProfile {
+			userProfile profile;
+			std::chrono::steady_clock::time_point readAt;
+		};
+
+		database db;
+		std::unordered_map<std::string, cachedProfile> profiles; // Recently read profiles, by username
+		size_t profileCapacity;
+		std::chrono::milliseconds profileLifetime;
 		bool userExists(std::string);
 		bool accountExists(int);
+		const userProfile *findCachedProfile(const std::string &username);
+		void cacheProfile(const userProfile &profile);
+		std::function<void(std::string)> userChanged;
 	public:
-		administrator();
+		administrator(const bankConfig &config = bankSettings());
+		std::optional<userProfile> getUserProfile(std::string);                                      // One query, or none if it is cached
+		std::vector<std::optional<userProfile>> getUserProfiles(const std::vector<std::string> &);   // One query for every uncached user
 		std::string getName(std::string);
 		int getUserCreditScore(std::string);
 		double getUserLoanDebt(std::string);
@@ -31,6 +68,7 @@ class administrator : public user {
 		void removeUser(std::string);
 		void giveLoan(int, double);
 		void createUser(std::string, std::string, std::string);
+		void onUserChanged(std::function<void(std::string)>);
 };
 
 #endif
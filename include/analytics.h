@@ -12,20 +12,31 @@
 #include <iomanip>
 #include <math.h>
 #include <string>
-#include "sqlite3.h"
+#include <vector>
+#include <memory_resource>
+#include "database.h"
+#include "currency.h"
+#include "bankConfig.h"
+#include "ledger.h"
+#include "userDirectory.h"
 
 class analytics {
     private:
-    	sqlite3 *db;
-        std::string sql;
-        char *errorMessage;
-        int totalTransactions, rc, step, empty;
+    	database db;
+        std::pmr::memory_resource *resource; // What each call's working lists are allocated from
+        int totalTransactions;
         double averageCredit, averageBalance;
+        bool inSnapshot;
+        bool openSnapshot();
+        void closeSnapshot(bool);
         void calculateAverageBalance();
         void calculateAverageCreditScore();
         bool userExists(std::string);
     public:
-        analytics();
+        analytics(std::pmr::memory_resource *resource = std::pmr::get_default_resource(), const bankConfig &config = bankSettings());
+        ~analytics();
+        bool beginSnapshot();
+        void endSnapshot();
         int getNumUsers();
         double getBalance(std::string);
         double getAverageBalance();
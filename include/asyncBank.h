@@ -0,0 +1,54 @@
+/** @brief Provides the templace for asyncBank
+ *
+ *  Defines the variables and functions used by the asyncBank class
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file asyncBank.h
+ */
+
+#ifndef ASYNC_BANK_H
+#define ASYNC_BANK_H
+
+#include <iostream>
+#include <string>
+#include "ioPool.h"
+#include "task.h"
+#include "currency.h"
+#include "bankConfig.h"
+#include "ledger.h"
+#include "changeLog.h"
+#include "userDirectory.h"
+#include "idempotencyStore.h"
+#include "holdBook.h"
+#include "fraudScoring.h"
+
+class asyncBank
+{
+private:
+    ioPool pool;
+
+public:
+    asyncBank(const bankConfig &config = bankSettings());
+    ioPool &getPool(); // The pool the tasks run on, for waiting on them
+
+    // account
+    task<double> getBalanceAsync(int accountID);
+    task<bool> depositAsync(int accountID, double amount, std::string idempotencyKey = "");
+    task<bool> withdrawAsync(int accountID, double amount, std::string idempotencyKey = "");
+
+    // customer
+    task<double> getMoneyAsync(std::string username);
+    task<bool> transferAsync(std::string username, int senderAccountID, int receiverAccountID, double amount, std::string idempotencyKey = "");
+
+    // budgeting
+    task<double> getSpendingAsync(std::string username);
+    task<double> getGainedAsync(std::string username);
+
+    // administrator
+    task<int> getCreditScoreAsync(std::string username);
+    task<bool> updateCreditScoreAsync(std::string username, int creditScore);
+
+    // analytics
+    task<double> getAverageBalanceAsync();
+};
+
+#endif
@@ -0,0 +1,50 @@
+/** @brief Provides the functions balances are checkpointed and read back at a past time with
+ *
+ *  A checkpoint is every account's balance at the end of one day, as the journal left it. The balance at any time is the nearest
+ *  checkpoint before it plus the journal entries between the two, so a past balance is read without replaying the account's history.
+ *  Times are given like the journal's entryTime, as YYYY-MM-DD HH:MM:SS in UTC, and a date alone means the start of that day.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file balanceCheckpoints.h
+ */
+
+#ifndef BALANCE_CHECKPOINTS_H
+#define BALANCE_CHECKPOINTS_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "database.h"
+#include "bankConfig.h"
+
+bool createBalanceCheckpoints(database &db); // Creates the table checkpoints are kept in, if it doesn't exist
+
+// Writes the end of day balance of every account for each day after the last checkpoint, up to throughDay (default: yesterday).
+// Returns the number of days written, or -1.
+int writeBalanceCheckpoints(database &db, std::string throughDay = "");
+// Returns an account's balance at a past time, or nothing if it can't be worked out from the checkpoints and the live journal
+std::optional<double> balanceAsOf(database &db, int accountID, std::string_view timestamp);
+
+class checkpointWriter
+{
+private:
+    database DB;
+    std::thread worker;
+    std::mutex stateLock;
+    std::condition_variable wakeUp;
+    bool stopping;
+
+    void work();
+
+public:
+    checkpointWriter(const bankConfig &config = bankSettings(), bool background = true);
+    checkpointWriter(const checkpointWriter &) = delete;
+    checkpointWriter &operator=(const checkpointWriter &) = delete;
+    ~checkpointWriter();
+};
+
+#endif
@@ -0,0 +1,77 @@
+/** @brief Provides the templace for bankConfig
+ *
+ *  Defines the settings every part of the bank is built from: the database file, the SQLite pragmas each connection is opened with,
+ *  and the sizes of pools, caches and batches.
+ *
+ *  Settings start at the defaults below, are then read from the config file, and then from the environment, so one deployment can be
+ *  tuned without rebuilding. The file has one setting per line, by the name of its member, and lines starting with # are ignored:
+ *
+ *      # Faster writes, at the cost of the last commits if the machine loses power
+ *      synchronous = OFF
+ *      cacheSize = -65536
+ *
+ *  Each setting is also read from an environment variable named BANK_ and the member name in capitals split at each word, so
+ *  BANK_SYNCHRONOUS and BANK_CACHE_SIZE set the two above. BANK_CONFIG names the config file, which is bank.conf by default.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file bankConfig.h
+ */
+
+#ifndef BANK_CONFIG_H
+#define BANK_CONFIG_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include "database.h"
+
+struct bankConfig
+{
+    // The database
+    std::string databasePath = "bankDatabase.db"; // The file every user, account and transaction is kept in
+    std::string journalMode = "WAL";              // DELETE, TRUNCATE, PERSIST, MEMORY, WAL or OFF
+    std::string synchronous = "NORMAL";           // OFF, NORMAL, FULL or EXTRA
+    long long cacheSize = -2000;                  // Pages, or KiB if negative, cached by each connection
+    long long mmapSize = 0;                       // Bytes of the file each connection reads through a memory map
+    int busyTimeout = 5000;                       // Milliseconds a connection waits on another's lock before failing
+
+    // Pools and caches
+    int ioThreads = 4;          // Connections in the pool coroutines run on
+    int analyticsThreads = 0;   // Threads a columnar scan may use, or 0 for one per core
+    int filterThreads = 0;      // Threads the existence filters are rebuilt on, or 0 for one per core
+    int sessionCapacity = 1024; // Most sessions kept at once
+    int sessionIdleSeconds = 900;
+    int sessionArenaBytes = 262144;      // Memory a session's customer may use before it is rebuilt in a fresh arena
+    int profileCacheSize = 1024;         // Most user profiles an administrator keeps
+    int profileCacheMilliseconds = 2000; // How long a kept profile is used before it is read again
+    int idempotencyCacheSize = 65536;    // Most idempotency keys kept in memory
+    int idempotencyKeySeconds = 86400;   // How long a key answers retries with the result of its first call
+
+    // Batching
+    int purgeBatchSize = 500; // Most journal entries of a deleted account detached in one database transaction
+    int purgePauseMilliseconds = 20;
+    int purgeIdleMilliseconds = 1000;
+    int schedulerHorizon = 3600; // Seconds of scheduled payments kept in memory
+    int schedulerBatchSize = 5000;
+    int schedulerMaxAttempts = 3;
+    int schedulerRetrySeconds = 3600;
+    int interestChunkSize = 50000;
+    int holdBatchSize = 256;   // Card authorization holds placed before they are written to the table together
+    int holdSeconds = 604800;  // How long a hold reserves its funds, unless it is given its own time
+
+    // Other files
+    std::string changeLogDirectory = "changes";
+    long long changeLogSegmentSize = 16 << 20;
+    std::string partitionDirectory = "."; // Where sealed months of transactions are written
+    std::string ratesPath = "rates.txt";
+
+    bool set(std::string_view name, std::string_view value); // Sets a setting by its member name, returns false if it's unknown or invalid
+    bool load(const std::string &path);                      // Reads settings from a file, returns false if a line is bad
+    bool loadEnvironment();                                  // Reads settings from BANK_ environment variables
+    bool apply(database &db) const;                          // Sets the pragmas on a connection
+    bool open(database &db) const;                           // Opens the database file and sets the pragmas
+};
+
+const bankConfig &bankSettings(); // The settings this process runs with, read from the config file and environment once
+
+#endif
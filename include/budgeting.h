@@ -12,23 +12,27 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
-#include "sqlite3.h"
+#include <memory_resource>
+#include "database.h"
+#include "bankConfig.h"
+#include "userDirectory.h"
 
 class budgeting
 {
 private:
-    sqlite3 *DB;
-    char *errorMessage;
-    std::string sql;
-    std::string username;
+    database DB;
+    std::pmr::string username;
+    int userID; // The ID the user's accounts refer to them by, or -1
     double spending;
     double moneyGained;
     double initialBalance;
-    int rc, step;
+
+    void loadTotals(); // Reads spending and moneyGained together
 
 public:
-    budgeting(std::string username);
-    budgeting();
+    budgeting(std::string username, std::pmr::memory_resource *resource = std::pmr::get_default_resource(),
+              const bankConfig &config = bankSettings());
+    budgeting(std::pmr::memory_resource *resource = std::pmr::get_default_resource());
     ~budgeting();
     double getSpending();
     double getGained();
@@ -0,0 +1,146 @@
+/** @brief Provides the templace for changeLog and changeLogReader
+ *
+ *  Defines the variables and functions used by the changeLog and changeLogReader classes, and the changes they write and read.
+ *
+ *  The log is a directory of fixed size segment files, each named after the offset of its first byte. A segment is laid out as:
+ *
+ *      header      "BKCL", version, segment size, offset of the segment
+ *      records     one after another, each 8 byte aligned: length, crc32, offset, commit time, type, accounts, amount and username
+ *
+ *  A record's length is written last, so a length of 0 means nothing has been written there yet. A length of 0xFFFFFFFF means the
+ *  rest of the segment is unused and the log carries on in the next one.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file changeLog.h
+ */
+
+#ifndef CHANGE_LOG_H
+#define CHANGE_LOG_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include "zlib.h"
+#include "database.h"
+#include "bankConfig.h"
+
+// The kinds of committed write the log records
+enum class changeType : unsigned char
+{
+    accountOpened = 1,
+    accountClosed,
+    deposit,
+    withdraw,
+    transfer,
+    loanGiven,
+    userCreated,
+    userRemoved,
+    creditScoreChanged
+};
+
+std::string_view changeTypeName(changeType type); // Returns the name a changeType is printed under
+
+// One committed write, as it is handed to the log
+struct changeEvent
+{
+    changeType type;
+    int accountID = 0;      // The account written, or the sending account of a transfer
+    int otherAccountID = 0; // The receiving account of a transfer
+    double amount = 0;      // The money moved, or the new credit score
+    std::string username;   // The user the write belongs to
+};
+
+// One committed write, as it is read back. username points into the log file and is only valid until the reader's next call to next.
+struct changeRecord
+{
+    unsigned long long offset; // Where the record starts in the log
+    long long commitTime;      // Microseconds since 1970
+    changeType type;
+    int accountID;
+    int otherAccountID;
+    double amount;
+    std::string_view username;
+};
+
+// One segment file, mapped into memory
+class logSegment
+{
+public:
+    unsigned long long base; // The log offset of the file's first byte
+    int fd;
+    unsigned char *data;
+    size_t size;
+
+    logSegment();
+    logSegment(const logSegment &) = delete;
+    logSegment &operator=(const logSegment &) = delete;
+    ~logSegment();
+    bool open(const std::string &directory, unsigned long long base, bool writable);
+    void close();
+    bool isOpen() const;
+
+    static std::string path(const std::string &directory, unsigned long long base);
+    static std::vector<unsigned long long> list(const std::string &directory); // Returns the offsets of the segments in a directory, in order
+};
+
+class changeLog
+{
+private:
+    std::string directory;
+    size_t segmentSize;
+    int lockFD;             // Locked across each commit and append, so every process writing the directory appends in commit order
+    std::mutex writeLock;   // Does the same for the threads of this process
+    logSegment segment;     // The segment being appended to
+    size_t position;        // The first unused byte of segment
+    std::atomic<unsigned long long> lostHere{0}; // Commits of this process whose records could not be appended
+
+    bool createSegment(unsigned long long base);
+    bool openSegment(unsigned long long base);
+    bool catchUp(); // Moves past records other processes have appended since this one last wrote
+    bool append(const changeEvent &event, long long commitTime);
+    void markLost(); // Counts a commit whose records could not be appended, where every process can see it
+    void setPending(bool pending); // Marks a commit as made but not yet appended, or clears the mark
+    void recoverPending();         // Counts a commit left marked by a writer that died before appending as lost
+
+public:
+    changeLog(std::string directory = "changes", size_t segmentSize = 16 << 20);
+    changeLog(const changeLog &) = delete;
+    changeLog &operator=(const changeLog &) = delete;
+    ~changeLog();
+
+    // Commits the transaction open on db, then appends events for it. Rolls back and returns false if the commit fails.
+    bool commit(database &db, const std::vector<changeEvent> &events);
+    unsigned long long getEndOffset();                // Returns the offset the next record will be written at
+    unsigned long long getLostCount();                // Returns a count that grows whenever any process loses a commit
+    void flush();                                     // Writes the segment being appended to out to disk
+    int removeSegmentsBefore(unsigned long long offset); // Deletes segments every consumer has read past, returns how many
+};
+
+class changeLogReader
+{
+private:
+    std::string directory;
+    logSegment segment;
+    size_t position; // Where in segment the next record starts, or the offset to open next while no segment is open
+
+    bool openAt(unsigned long long offset);
+
+public:
+    changeLogReader(std::string directory = "changes", unsigned long long offset = 0);
+    bool next(changeRecord &record);                                 // Reads the next record, or returns false if there isn't one yet
+    bool next(changeRecord &record, std::chrono::milliseconds wait); // Waits up to wait for the next record
+    unsigned long long getOffset() const;                            // Returns the offset to resume from later
+};
+
+changeLog &changeFeed(); // The log the accounts, customers and administrators of this process publish their writes to
+
+#endif
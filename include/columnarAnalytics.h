@@ -0,0 +1,87 @@
+/** @brief Provides the templace for columnarAnalytics.
+ *
+ *  Defines the variables and functions used by the columnarAnalytics class.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file columnarAnalytics.h
+*/
+
+#ifndef COLUMNAR_ANALYTICS_H
+#define COLUMNAR_ANALYTICS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <unordered_map>
+#include <thread>
+#include "database.h"
+#include "bankConfig.h"
+#include "currency.h"
+#include "userDirectory.h"
+
+class columnarAnalytics {
+    private:
+        database db;
+        unsigned int numThreads;
+
+        // Dictionaries, mapping each code used in the columns back to its string
+        std::vector<std::string> usernames;
+        std::vector<bool> regularUsers;
+        std::unordered_map<std::string, int> usernameCodes;
+        std::unordered_map<int, int> userIDCodes; // The code of each userID
+        std::vector<std::string> transactionTypes;
+        std::unordered_map<std::string, int> typeCodes;
+        std::vector<std::string> currencies;
+        std::unordered_map<std::string, int> currencyCodes;
+
+        // Account columns, one row per account
+        std::vector<int> accountIDs;
+        std::vector<int> accountUsers;
+        std::vector<double> balances;         // In each account's own currency
+        std::vector<int> accountCurrencies;
+        std::unordered_map<int, int> accountUserCodes;
+
+        // Transaction columns, one row per side of each journal entry on a customer account
+        std::vector<int> transactionAccounts;
+        std::vector<int> transactionUsers;
+        std::vector<int> types;
+        std::vector<double> amounts;
+        std::vector<long long> timestamps;
+        std::vector<int> days;
+        long long lastTransactionID; // The last journal entry read
+        size_t sealedRows;           // Rows holding the totals of sealed months, one per account and type
+        long long sealedSides;       // The journal entry sides those rows total
+        long long sealedEntries;     // Entries sealed out of the journal when the totals were read
+
+        int usernameCode(const std::string &);
+        int typeCode(const std::string &);
+        void loadUsers();
+        void loadAccounts();
+        double toBaseCurrency(const std::vector<double> &currencyTotals);
+        bool appendTransaction(int accountID, const std::string &type, double amount, long long timestamp);
+        int loadTransactions();
+        void loadSealedTotals();
+        long long countSealedEntries();
+        double sumTransactions(int userCode, const std::vector<std::string> &wantedTypes);
+        std::vector<double> groupTransactions(const std::vector<int> &keys, size_t numKeys, int typeFilter);
+    public:
+        columnarAnalytics(const bankConfig &config = bankSettings());
+        ~columnarAnalytics();
+        void load();
+        int refresh();
+        int getNumUsers();
+        int getNumTransactions();
+        double getBalance(std::string);
+        double getAverageBalance();
+        double getSpending(std::string);
+        double getGained(std::string);
+        double getTotalAmount(std::string);
+        std::map<std::string, double> getTotalByType();
+        std::map<std::string, double> getTotalByUser(std::string);
+        std::map<std::string, double> getTotalByDay(std::string);
+};
+
+#endif
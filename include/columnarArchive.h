@@ -0,0 +1,117 @@
+/** @brief Provides the templace for columnarArchive
+ *
+ *  Defines the variables and functions used by the columnarArchive class, and the rows it reads and writes.
+ *
+ *  An archive file is laid out as:
+ *
+ *      header      "BKCA", version, number of types, number of blocks, number of rows
+ *      types       each transaction type's name, in code order
+ *      index       for each block: offset, sizes, rows, and the min/max of its IDs, times and accounts
+ *      blocks      each block's columns, zlib compressed: IDs and times as varint deltas, sender and receiver accounts as varints,
+ *                  type codes as one byte each, amounts as varint cents, and the amount credited to the receiver as varint cents
+ *                  less the amount, which is 0 unless the receiver holds another currency. Version 1 files have no credited column.
+ *
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file columnarArchive.h
+ */
+
+#ifndef COLUMNAR_ARCHIVE_H
+#define COLUMNAR_ARCHIVE_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "zlib.h"
+
+// One row of the transactions table, wherever it is stored
+struct transactionRecord
+{
+    long long transactionID;
+    int senderAccountID;
+    int receiverAccountID;
+    std::string transactionType;
+    double amount;       // Taken from the sender, in the sender's currency
+    double creditAmount; // Given to the receiver, in the receiver's currency
+    std::string transactionTime;
+
+    static auto columns()
+    {
+        return std::make_tuple(&transactionRecord::transactionID, &transactionRecord::senderAccountID, &transactionRecord::receiverAccountID,
+                               &transactionRecord::transactionType, &transactionRecord::amount, &transactionRecord::creditAmount,
+                               &transactionRecord::transactionTime);
+    }
+};
+
+// One row being written to an archive, with its time in seconds since 1970
+struct archivedTransaction
+{
+    long long transactionID;
+    int senderAccountID;
+    int receiverAccountID;
+    std::string transactionType;
+    double amount;
+    double creditAmount;
+    long long timestamp;
+
+    static auto columns()
+    {
+        return std::make_tuple(&archivedTransaction::transactionID, &archivedTransaction::senderAccountID, &archivedTransaction::receiverAccountID,
+                               &archivedTransaction::transactionType, &archivedTransaction::amount, &archivedTransaction::creditAmount,
+                               &archivedTransaction::timestamp);
+    }
+};
+
+class columnarArchive
+{
+private:
+    // Where a block is in the file, and the range of values in it, so reads can skip it
+    struct blockInfo
+    {
+        unsigned long long offset;
+        unsigned int compressedSize;
+        unsigned int rawSize;
+        unsigned int rows;
+        long long minID, maxID;
+        long long minTime, maxTime;
+        int minAccount, maxAccount;
+    };
+
+    int fd;
+    const unsigned char *data; // The whole file, mapped read-only
+    size_t size;
+    unsigned long long rowCount;
+    unsigned int version; // Version 1 files have no credited amounts
+    std::vector<std::string> types;
+    std::vector<blockInfo> blocks;
+
+public:
+    columnarArchive();
+    columnarArchive(const columnarArchive &) = delete;
+    columnarArchive &operator=(const columnarArchive &) = delete;
+    ~columnarArchive();
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const;
+    unsigned long long getRowCount() const;
+    size_t getBlockCount() const;
+
+    // Reads the rows in [fromTime, toTime), sent from or received into one account, or from every account if accountID is -1
+    bool forEach(long long fromTime, long long toTime, int accountID, const std::function<void(const transactionRecord &)> &visit);
+
+    static bool write(const std::string &path, const std::vector<archivedTransaction> &rows, unsigned int blockRows = 4096);
+};
+
+long long parseTime(std::string_view time); // Turns YYYY-MM-DD HH:MM:SS in UTC into seconds since 1970
+std::string formatTime(long long seconds);  // Turns seconds since 1970 into YYYY-MM-DD HH:MM:SS in UTC
+
+#endif
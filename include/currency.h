@@ -0,0 +1,98 @@
+/** @brief Provides the templace for rateTable and exchangeRates
+ *
+ *  Defines the variables and functions used by the rateTable and exchangeRates classes, which convert amounts between the currencies
+ *  accounts are held in.
+ *
+ *  The rates file has one currency per line: its three letter code, then what one unit of it is worth in the base currency. Lines
+ *  starting with # are ignored. The file is replaced by writing a new one and renaming it over the old, so it is never read half written.
+ *
+ *      # CAD is the base currency
+ *      USD 1.37
+ *      EUR 1.49
+ *
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file currency.h
+ */
+
+#ifndef CURRENCY_H
+#define CURRENCY_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <sys/stat.h>
+#include "database.h"
+#include "bankConfig.h"
+
+const std::string_view baseCurrency = "CAD"; // The currency every rate is given in, and totals are reported in
+
+bool addCurrencyColumn(database &db); // Gives the accounts table its currency column, if it doesn't have one
+
+// An amount of money in one currency
+struct currencyAmount
+{
+    std::string currency;
+    double amount;
+
+    static auto columns()
+    {
+        return std::make_tuple(&currencyAmount::currency, &currencyAmount::amount);
+    }
+};
+
+// One set of rates. Never changed once it is published, so any number of threads can read it.
+class rateTable
+{
+private:
+    std::vector<unsigned int> codes; // Each currency code packed into an integer, so a lookup compares one word
+    std::vector<double> rates;       // What one unit of each currency is worth in the base currency
+
+    static unsigned int pack(std::string_view code);
+
+public:
+    rateTable();
+    bool set(std::string_view code, double rate);
+    double getRate(std::string_view code) const; // Returns what one unit is worth in the base currency, or 0 if the currency is unknown
+    bool convert(double amount, std::string_view from, std::string_view to, double &result) const;
+    // Adds up amounts in any currencies, in the currency to. Returns false if a currency is unknown.
+    bool total(std::span<const currencyAmount> amounts, std::string_view to, double &result) const;
+    static std::shared_ptr<const rateTable> load(const std::string &path); // Reads a rates file, or returns nullptr if it can't
+};
+
+class exchangeRates
+{
+private:
+    std::string path;
+    std::atomic<std::shared_ptr<const rateTable>> table;
+    std::atomic<unsigned long long> version; // Goes up each time a table is published
+    struct stat loaded;                      // The file the table was read from, to tell when it is replaced
+    std::mutex refreshLock;                  // Held by refresh, which callers and the worker both run, while it reads and sets loaded
+
+    std::thread worker;
+    std::mutex stateLock;
+    std::condition_variable wakeUp;
+    bool stopping;
+
+    void work();
+
+public:
+    exchangeRates(std::string path = "rates.txt", bool background = true);
+    exchangeRates(const exchangeRates &) = delete;
+    exchangeRates &operator=(const exchangeRates &) = delete;
+    ~exchangeRates();
+    bool refresh();                                // Publishes a new table if the rates file has been replaced
+    std::shared_ptr<const rateTable> current();    // Returns the newest table
+};
+
+exchangeRates &currencyRates(); // The rates this process converts with, read from the configured rates file
+
+#endif
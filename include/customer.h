@@ -8,31 +8,59 @@
 #ifndef CUSTOMER_H
 #define CUSTOMER_H
 
-#include "sqlite3.h"
+#include <array>
+#include <unordered_map>
+#include <memory>
+#include "database.h"
 #include "user.h"
 #include "account.h"
+#include "accountPurger.h"
+#include "fraudScoring.h"
+#include "paymentScheduler.h"
+#include "columnarArchive.h"
+#include "bankConfig.h"
+#include "userDirectory.h"
+#include "existenceFilter.h"
 
 class customer : public user
 {
 private:
-    sqlite3 *DB;
-    std::string sql;
-    int rc, step;
+    std::unique_ptr<database> DB; // One connection, shared by every account the customer owns
+    int userID;                   // The ID the customer's accounts refer to them by, or -1 if they don't exist
     int creditScore;
     double loanDebt;
     double money;
+    std::pmr::vector<account> accounts;                // Storage for the accounts, in no particular order
+    std::pmr::unordered_map<int, size_t> accountsByID; // Position in accounts of each accountID
+    std::array<int, accountKindCount> accountsByKind; // Position in accounts of each account type, or -1
+    void loadAccounts();
+    void indexAccount(size_t position);
+    void removeAccount(size_t position);
+    account *findAccount(accountKind kind);
 
 public:
-    std::vector<account> accounts;
-    customer(std::string username);
+    customer(std::string username, std::pmr::memory_resource *resource = std::pmr::get_default_resource(),
+             const bankConfig &config = bankSettings());
+    customer(const customer &) = delete;
+    customer(customer &&other) noexcept;
+    customer &operator=(const customer &) = delete;
+    customer &operator=(customer &&other) noexcept;
     ~customer();
+    const std::pmr::vector<account> &getAccounts() const;
+    account *getAccount(int accountID);
     int getCreditScore();
     double getMoney();
     double getLoanDebt();
-    double checkAccountBalance(std::string accountType);
-    bool createAccount(std::string accountType, double smoney);
-    bool deleteAccount(std::string accountType);
-    bool transaction(int accountID, int receiverAccountID, double amount);
+    double checkAccountBalance(std::string_view accountType);
+    double checkAccountBalance(accountKind kind);
+    bool createAccount(std::string_view accountType, double smoney, std::string_view currency = baseCurrency);
+    bool createAccount(accountKind kind, double smoney, std::string_view currency = baseCurrency);
+    bool deleteAccount(std::string_view accountType);
+    bool deleteAccount(accountKind kind);
+    bool transaction(int accountID, int receiverAccountID, double amount, std::string_view idempotencyKey = {});
+    long long schedulePayment(int senderAccountID, int receiverAccountID, double amount, std::string_view firstDue,
+                              std::string_view frequency, int runs = -1);
+    bool cancelPayment(long long paymentID);
     void storeValues();
     void fill(std::string username);
 };
@@ -0,0 +1,236 @@
+/** @brief Provides the templace for database
+ *
+ *  Defines the variables and functions used by the database class, and the helpers that bind parameters and decode rows.
+ *
+ *  A row type lists the columns a query returns, in order, as pointers to its members:
+ *
+ *      struct userRow
+ *      {
+ *          std::string name;
+ *          int creditScore;
+ *          static auto columns() { return std::make_tuple(&userRow::name, &userRow::creditScore); }
+ *      };
+ *
+ *      std::optional<userRow> row = db.queryRow<userRow>("SELECT name, creditScore FROM users WHERE username = ?;", username);
+ *
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file database.h
+ */
+
+#ifndef DATABASE_H
+#define DATABASE_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <memory_resource>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <unordered_map>
+#include "sqlite3.h"
+
+// Reads one column of the current row straight into a field. NULL reads as 0 or an empty string.
+void readColumn(sqlite3_stmt *stmt, int column, int &field);
+void readColumn(sqlite3_stmt *stmt, int column, long long &field);
+void readColumn(sqlite3_stmt *stmt, int column, double &field);
+void readColumn(sqlite3_stmt *stmt, int column, std::string &field);
+void readColumn(sqlite3_stmt *stmt, int column, std::pmr::string &field);
+void readColumn(sqlite3_stmt *stmt, int column, std::string_view &field); // Only valid until the next row is read
+
+// Binds one parameter. Text is not copied, so it must stay alive until the statement is done.
+int bindParameter(sqlite3_stmt *stmt, int index, int value);
+int bindParameter(sqlite3_stmt *stmt, int index, long long value);
+int bindParameter(sqlite3_stmt *stmt, int index, double value);
+int bindParameter(sqlite3_stmt *stmt, int index, std::string_view value);
+
+/** @brief Reads the current row into a row type
+ *  @param stmt The statement holding the current row.
+ *  @param row The row to fill, whose columns() lists the members to read in column order.
+ */
+template <typename Row>
+void decodeRow(sqlite3_stmt *stmt, Row &row)
+{
+    std::apply([&](auto... members)
+               {
+                   int column = 0;
+                   (readColumn(stmt, column++, row.*members), ...);
+               },
+               Row::columns());
+}
+
+class database
+{
+private:
+    sqlite3 *db;
+    std::string lastError;
+    std::unordered_map<std::string_view, sqlite3_stmt *> statements; // Keyed by the statement's own copy of its SQL
+
+    sqlite3_stmt *prepare(std::string_view sql, bool &cached);
+    void release(sqlite3_stmt *stmt, bool cached);
+    bool fail(sqlite3_stmt *stmt, bool cached);
+
+    /** @brief Prepares a statement and binds its parameters
+     *  @param sql The statement to prepare.
+     *  @param cached Set to whether the statement belongs to the cache.
+     *  @param args The parameters, bound in order.
+     *  @return The statement, or nullptr if it could not be prepared or bound.
+     */
+    template <typename... Args>
+    sqlite3_stmt *bind(std::string_view sql, bool &cached, const Args &...args)
+    {
+        sqlite3_stmt *stmt = prepare(sql, cached);
+        if (stmt == nullptr)
+        {
+            return nullptr;
+        }
+        int index = 1;
+        int rc = SQLITE_OK;
+        ((rc = rc == SQLITE_OK ? bindParameter(stmt, index++, args) : rc), ...);
+        if (rc != SQLITE_OK)
+        {
+            fail(stmt, cached);
+            return nullptr;
+        }
+        return stmt;
+    }
+
+public:
+    database();
+    database(const char *path);
+    database(const database &) = delete;
+    database &operator=(const database &) = delete;
+    database(database &&other) noexcept;
+    database &operator=(database &&other) noexcept;
+    ~database();
+    bool open(const char *path);
+    void close();
+    bool isOpen() const;
+    sqlite3 *handle();
+    const std::string &getError() const;
+    long long lastInsertID();
+    int changes();
+    bool exec(const char *sql); // Runs one or more statements without parameters or results
+
+    /** @brief Runs a statement that returns no rows
+     *  @param sql The statement, with ? for each parameter.
+     *  @param args The parameters, bound in order.
+     *  @return True if the statement ran to completion, false otherwise.
+     */
+    template <typename... Args>
+    bool run(std::string_view sql, const Args &...args)
+    {
+        bool cached;
+        sqlite3_stmt *stmt = bind(sql, cached, args...);
+        if (stmt == nullptr)
+        {
+            return false;
+        }
+        int step = sqlite3_step(stmt);
+        while (step == SQLITE_ROW)
+        {
+            step = sqlite3_step(stmt);
+        }
+        if (step != SQLITE_DONE)
+        {
+            return fail(stmt, cached);
+        }
+        release(stmt, cached);
+        return true;
+    }
+
+    /** @brief Runs a query and reads the first column of its first row
+     *  @param sql The query, with ? for each parameter.
+     *  @param args The parameters, bound in order.
+     *  @return The value, or nothing if the query failed or returned no rows.
+     */
+    template <typename T, typename... Args>
+    std::optional<T> queryValue(std::string_view sql, const Args &...args)
+    {
+        bool cached;
+        sqlite3_stmt *stmt = bind(sql, cached, args...);
+        if (stmt == nullptr)
+        {
+            return std::nullopt;
+        }
+        int step = sqlite3_step(stmt);
+        if (step != SQLITE_ROW)
+        {
+            if (step != SQLITE_DONE)
+            {
+                fail(stmt, cached);
+                return std::nullopt;
+            }
+            release(stmt, cached);
+            return std::nullopt;
+        }
+        T value{};
+        readColumn(stmt, 0, value);
+        release(stmt, cached);
+        return value;
+    }
+
+    /** @brief Runs a query and reads its first row
+     *  @param sql The query, with ? for each parameter.
+     *  @param args The parameters, bound in order.
+     *  @return The row, or nothing if the query failed or returned no rows.
+     */
+    template <typename Row, typename... Args>
+    std::optional<Row> queryRow(std::string_view sql, const Args &...args)
+    {
+        bool cached;
+        sqlite3_stmt *stmt = bind(sql, cached, args...);
+        if (stmt == nullptr)
+        {
+            return std::nullopt;
+        }
+        int step = sqlite3_step(stmt);
+        if (step != SQLITE_ROW)
+        {
+            if (step != SQLITE_DONE)
+            {
+                fail(stmt, cached);
+                return std::nullopt;
+            }
+            release(stmt, cached);
+            return std::nullopt;
+        }
+        Row row{};
+        decodeRow(stmt, row);
+        release(stmt, cached);
+        return row;
+    }
+
+    /** @brief Runs a query and hands each row to a function
+     *  @param sql The query, with ? for each parameter.
+     *  @param visit Called with each row, in order. Text read as std::string_view is only valid during the call.
+     *  @param args The parameters, bound in order.
+     *  @return True if every row was read, false if the query failed.
+     */
+    template <typename Row, typename Fn, typename... Args>
+    bool forEach(std::string_view sql, Fn visit, const Args &...args)
+    {
+        bool cached;
+        sqlite3_stmt *stmt = bind(sql, cached, args...);
+        if (stmt == nullptr)
+        {
+            return false;
+        }
+        Row row{};
+        int step = sqlite3_step(stmt);
+        while (step == SQLITE_ROW)
+        {
+            decodeRow(stmt, row);
+            visit(row);
+            step = sqlite3_step(stmt);
+        }
+        if (step != SQLITE_DONE)
+        {
+            return fail(stmt, cached);
+        }
+        release(stmt, cached);
+        return true;
+    }
+};
+
+#endif
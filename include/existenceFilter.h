@@ -0,0 +1,72 @@
+/** @brief Provides the templace for countingBloomFilter and existenceFilter
+ *
+ *  Defines the variables and functions used by the countingBloomFilter and existenceFilter classes. An existenceFilter answers whether
+ *  an account ID or a username might exist without reading the database. A "no" is certain while the filters are up to date with the
+ *  change log, so a lookup of something that doesn't exist never reaches the database, and a "maybe" is checked there as before. If a
+ *  change is lost from the log, or the filters can't be built, every lookup answers "maybe" until they are built again.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file existenceFilter.h
+ */
+
+#ifndef EXISTENCE_FILTER_H
+#define EXISTENCE_FILTER_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include "database.h"
+#include "bankConfig.h"
+#include "changeLog.h"
+
+// A Bloom filter with a small counter in place of each bit, so keys can be removed as well as added. A counter that reaches 255 stays
+// there, since it no longer knows how many keys share it.
+class countingBloomFilter
+{
+private:
+    std::vector<unsigned char> counters;
+    int hashes; // How many counters each key sets
+
+    template <typename Visit>
+    void visit(unsigned long long hash, Visit visitCounter) const;
+
+public:
+    countingBloomFilter(size_t capacity = 0); // Sized so about 1 in 100 lookups of missing keys answers "maybe" once capacity keys are in it
+    void add(unsigned long long hash);
+    void remove(unsigned long long hash); // Does nothing if the key can't be in the filter
+    bool mightContain(unsigned long long hash) const;
+    void merge(const countingBloomFilter &other); // Adds in every key of a filter of the same capacity
+};
+
+class existenceFilter
+{
+private:
+    std::mutex lock;
+    countingBloomFilter accounts;
+    countingBloomFilter users;
+    size_t capacity = 0; // Keys each filter was sized for
+    size_t added = 0;    // Keys added since the filters were built
+    bool loaded = false;
+    bool failed = false; // The tables couldn't be read, so every lookup answers "maybe" until retryAt
+    std::chrono::steady_clock::time_point retryAt;
+
+    // Follows the change log from just before the tables were read, so writes by this process and every other one are added
+    std::unique_ptr<changeLogReader> changes;
+    unsigned long long loadedAt = 0; // Changes before this offset may already have been read from the tables
+    unsigned long long lostAt = 0;   // The log's count of lost commits before the tables were read
+
+    bool rebuild(const bankConfig &config);
+    bool refresh(); // Builds the filters if needed and applies new changes, returns false if they can't be trusted
+
+public:
+    bool load(const bankConfig &config = bankSettings()); // Builds the filters from the tables, if they aren't built yet
+    bool mightHaveAccount(int accountID);                 // Returns false only if the account certainly doesn't exist
+    bool mightHaveUser(std::string_view username);        // Returns false only if the user certainly doesn't exist
+};
+
+existenceFilter &existenceFilters(); // The filters every class in this process checks before reading the database
+
+#endif
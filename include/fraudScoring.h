@@ -0,0 +1,116 @@
+/** @brief Provides the templace for fraudScorer
+ *
+ *  Defines the variables and functions used by the fraudScorer class, the recent history it keeps for each account, and the rules it
+ *  scores transfers with.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file fraudScoring.h
+ */
+
+#ifndef FRAUD_SCORING_H
+#define FRAUD_SCORING_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <chrono>
+#include "database.h"
+
+// What happens to a transfer once it is scored
+enum class fraudDecision
+{
+    allow,
+    hold,  // Kept in the heldTransfers table for someone to review, and not sent
+    reject
+};
+
+// A transfer about to be committed
+struct transferAttempt
+{
+    int senderAccountID;
+    int receiverAccountID;
+    double amount;
+    long long time; // Microseconds on the steady clock
+};
+
+// The most recent transfers sent from one account, oldest overwritten first. Each field is kept in its own array, so a rule that
+// only looks at times or amounts reads one contiguous block.
+struct accountWindow
+{
+    static const int capacity = 64;
+
+    std::array<long long, capacity> times;
+    std::array<double, capacity> amounts;
+    std::array<int, capacity> receivers;
+    int next = 0;  // Where the next transfer is written
+    int count = 0; // How many of the slots are filled
+
+    void add(long long time, double amount, int receiverAccountID);
+    int countSince(long long time) const;       // Returns the number of transfers at or after time
+    double percentile(double fraction) const;   // Returns the amount that fraction of the transfers are at or below, or 0 if there are none
+    bool hasSentTo(int receiverAccountID) const; // Returns true if any of the transfers went to receiverAccountID
+};
+
+// Scores one transfer from 0 (normal) to 1 (certainly fraud), given the sender's recent transfers
+using fraudRule = std::function<double(const transferAttempt &, const accountWindow &)>;
+
+fraudRule velocityRule(int perMinute);                     // Scores a sender going over perMinute transfers a minute
+fraudRule amountRule(int minimumHistory);                  // Scores an amount far above the sender's usual amounts
+fraudRule newReceiverRule(int minimumHistory);             // Scores a large first transfer to an account the sender hasn't paid
+bool createHeldTransfers(database &db);                    // Creates the table held transfers are kept in
+
+// The outcome of scoring one transfer
+struct fraudVerdict
+{
+    fraudDecision decision;
+    double score;
+    std::string_view reason; // The name of the rule that gave the highest score, or empty if none scored
+};
+
+class fraudScorer
+{
+private:
+    static const int shardCount = 16;
+
+    // The windows of the accounts whose IDs fall in one shard. Each shard is on its own cache lines so shards don't slow each other.
+    struct alignas(64) shard
+    {
+        std::mutex lock;
+        std::unordered_map<int, accountWindow> windows;
+    };
+
+    struct namedRule
+    {
+        std::string name;
+        fraudRule rule;
+    };
+
+    std::array<shard, shardCount> shards;
+    std::vector<namedRule> rules;
+    std::shared_mutex rulesLock;
+    double holdScore;
+    double rejectScore;
+
+public:
+    fraudScorer(double holdScore = 0.5, double rejectScore = 0.9, bool defaultRules = true);
+    fraudScorer(const fraudScorer &) = delete;
+    fraudScorer &operator=(const fraudScorer &) = delete;
+    void addRule(std::string name, fraudRule rule);
+
+    // Scores a transfer against the sender's window. Transfers that are allowed are added to the window straight away, so transfers
+    // scored at the same time from one account still see each other.
+    fraudVerdict screen(int senderAccountID, int receiverAccountID, double amount);
+    void forget(int accountID); // Drops an account's window, such as when the account is closed
+};
+
+fraudScorer &fraudScoring(); // The scorer every customer of this process screens transfers with
+
+// Screens a transfer with fraudScoring() inside the transaction that sends it, and writes a held transfer to heldTransfers there
+fraudDecision screenTransfer(database &db, int senderAccountID, int receiverAccountID, double amount);
+
+#endif
@@ -0,0 +1,68 @@
+/** @brief Provides the templace for holdBook
+ *
+ *  Defines the variables and functions used by the holdBook class, and the holds it keeps. A hold reserves part of an account's balance
+ *  for a card authorization without posting anything. The account's available balance is its ledger balance less its active holds, and
+ *  withdrawals and transfers can only spend the available balance. A hold is later captured, which posts it to the journal, released, or
+ *  left to expire.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file holdBook.h
+ */
+
+#ifndef HOLD_BOOK_H
+#define HOLD_BOOK_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include "database.h"
+#include "bankConfig.h"
+#include "changeLog.h"
+#include "ledger.h"
+
+bool createHolds(database &db); // Creates the tables holds are kept in, if they don't exist
+
+// Funds reserved on one account
+struct hold
+{
+    long long holdID;
+    int accountID;
+    double amount;
+    long long expiresAt; // Seconds since 1970
+    static auto columns() { return std::make_tuple(&hold::holdID, &hold::accountID, &hold::amount, &hold::expiresAt); }
+};
+
+class holdBook
+{
+private:
+    std::mutex lock;
+    std::unordered_map<int, std::vector<hold>> active; // Each account's active holds
+    std::unordered_map<long long, int> accountOf;      // The account of each active hold
+    std::vector<hold> unsaved;                         // Holds placed since the last batch was written
+    long long nextID = 0;  // The next hold ID to give out
+    long long lastID = -1; // The last ID in the block of IDs this process has reserved
+    bool loaded = false;
+    size_t batchSize;
+    int lifetime; // Seconds a hold lasts unless it is given its own
+
+    bool load(database &db);
+    double activeTotal(int accountID, long long now); // Drops the account's expired holds from memory and totals the rest
+    bool writeUnsaved(database &db);
+    void forget(long long holdID);
+
+public:
+    holdBook(const bankConfig &config = bankSettings());
+
+    // Reserves amount on an account whose ledger balance is balance, if enough of it is available. Returns the hold's ID, or -1.
+    long long place(database &db, int accountID, double amount, double balance, int seconds = 0);
+    double held(database &db, int accountID); // Returns the total of the account's active holds
+    int capture(database &db, const std::vector<long long> &holdIDs); // Posts each hold to the journal, returns how many were captured
+    int release(database &db, const std::vector<long long> &holdIDs); // Frees each hold's funds, returns how many were released
+    int expire(database &db);                                         // Marks holds past their time as expired, returns how many
+    bool flush(database &db);                                         // Writes every hold placed since the last batch
+};
+
+holdBook &authorizationHolds(); // The holds every account in this process is checked against
+
+#endif
@@ -0,0 +1,94 @@
+/** @brief Provides the templace for idempotencyStore
+ *
+ *  Defines the variables and functions used by the idempotencyStore class. A deposit, withdrawal or transfer can be given a key chosen
+ *  by the client. If the client retries it with the same key, the retry returns the result of the first call and moves no money.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file idempotencyStore.h
+ */
+
+#ifndef IDEMPOTENCY_STORE_H
+#define IDEMPOTENCY_STORE_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <array>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include "database.h"
+#include "bankConfig.h"
+
+bool createIdempotencyKeys(database &db); // Creates the table the keys are kept in, if it doesn't exist
+
+// What a call made with a key asked for. A retry has to ask for the same thing.
+struct idempotentCall
+{
+    std::string_view operation; // "deposit", "withdraw" or "transfer"
+    int accountID;
+    int otherAccountID; // The receiving account of a transfer, otherwise 0
+    double amount;
+};
+
+enum class idempotencyResult
+{
+    fresh,      // The key is empty or unused, so the call goes ahead
+    replayed,   // The key was used by the same call, which succeeded
+    mismatched, // The key was used by a different call
+    failed      // The key could not be read or written
+};
+
+const char *idempotencyFailure(idempotencyResult result); // Returns why a call can't go ahead, or nullptr if it is fresh or replayed
+bool replayEarlier(idempotencyResult result);            // Prints the failure, if any, and returns true if the call was replayed
+
+class idempotencyStore
+{
+private:
+    static const int shardCount = 16;
+
+    struct usedKey
+    {
+        std::string key;
+        std::string operation;
+        int accountID;
+        int otherAccountID;
+        double amount;
+        long long entryID;   // The journal entry the first call posted
+        long long expiresAt; // Seconds since 1970
+    };
+
+    // Keys whose hash picks the shard, most recently used first. Each shard has its own lock, so calls with different keys rarely wait.
+    struct shard
+    {
+        std::mutex lock;
+        std::list<usedKey> recent;
+        std::unordered_map<std::string_view, std::list<usedKey>::iterator> index; // Keyed by each entry's own copy of its key
+    };
+
+    std::array<shard, shardCount> shards;
+    size_t shardCapacity;
+    long long lifetime; // Seconds a key lasts
+    std::atomic<unsigned int> claims{0};
+
+    shard &shardFor(std::string_view key);
+    void keep(shard &keys, usedKey used);
+    idempotencyResult compare(const usedKey &used, const idempotentCall &call);
+    idempotencyResult lookUp(database &db, std::string_view key, const idempotentCall &call);
+
+public:
+    idempotencyStore(const bankConfig &config = bankSettings());
+
+    // Checks a key before a call does anything. Keys not kept in memory are looked up in the table.
+    idempotencyResult check(database &db, std::string_view key, const idempotentCall &call);
+    // Writes the key inside the call's database transaction, once it has posted entryID. Anything but fresh means another call
+    // used the key first, and the caller has to roll back.
+    idempotencyResult claim(database &db, std::string_view key, const idempotentCall &call, long long entryID);
+    // Keeps a key in memory once the transaction that claimed it has committed
+    void remember(std::string_view key, const idempotentCall &call, long long entryID);
+    int removeExpired(database &db); // Deletes keys that have expired from the table, returns how many
+};
+
+idempotencyStore &idempotencyKeys(); // The keys every class in this process checks
+
+#endif
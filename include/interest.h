@@ -0,0 +1,50 @@
+/** @brief Provides the templace for interest
+ *
+ *  Defines the variables and functions used by the interest class
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file interest.h
+ */
+
+#ifndef INTEREST_H
+#define INTEREST_H
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <ctime>
+#include "database.h"
+#include "bankConfig.h"
+#include "ledger.h"
+
+class interest
+{
+private:
+    database DB; // Keeps the statements each chunk reuses prepared for the whole run
+    std::string runDate;
+    double dailyRate;
+    int chunkSize;
+    int lastAccountID;
+    int accountsPosted;
+
+    // One chunk of savings accounts, stored column by column
+    std::vector<int> accountIDs;
+    std::vector<double> balances;
+    std::vector<double> accrued;
+
+    void loadProgress();
+    bool loadChunk();
+    void computeChunk();
+    bool postChunk(bool lastChunk);
+
+public:
+    interest(double annualRate, const bankConfig &config = bankSettings());
+    ~interest();
+    int postDailyInterest(); // Posts today's interest to every savings account, resuming a crashed run
+    int getAccountsPosted(); // Returns the number of accounts credited by today's run so far
+    std::string getRunDate(); // Returns the date of the run, as YYYY-MM-DD
+};
+
+#endif
@@ -0,0 +1,137 @@
+/** @brief Provides the templace for ioPool
+ *
+ *  Defines the variables and functions used by the ioPool class
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file ioPool.h
+ */
+
+#ifndef IO_POOL_H
+#define IO_POOL_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <coroutine>
+#include <optional>
+#include <type_traits>
+#include "database.h"
+#include "bankConfig.h"
+#include "task.h"
+
+class ioPool
+{
+private:
+    bankConfig config; // Kept for the workers, which open their connections once they start
+    std::vector<std::thread> workers; // Each worker owns one database connection
+    std::deque<std::function<void(database &)>> jobs;
+    std::mutex jobsLock;
+    std::condition_variable jobsReady;
+    bool stopping;
+
+    // Coroutines whose database work has finished, waiting to be resumed on the front-end thread
+    std::vector<std::coroutine_handle<>> completed;
+    std::mutex completedLock;
+    std::condition_variable completedReady;
+
+    void work();
+
+public:
+    /** @brief Database work a coroutine can await
+     *  The work runs on one of the pool's threads with that thread's connection. The awaiting coroutine is resumed by the next call to
+     *  runCompleted on the front-end thread, with the work's result.
+     */
+    template <typename Fn>
+    class job
+    {
+    private:
+        using resultType = std::invoke_result_t<Fn &, database &>;
+
+        ioPool *pool;
+        Fn fn;
+        std::optional<resultType> result;
+
+    public:
+        job(ioPool *pool, Fn fn) : pool(pool), fn(std::move(fn)) {}
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> waiting)
+        {
+            pool->submit([this, waiting](database &db)
+                         {
+                             result.emplace(fn(db));
+                             pool->complete(waiting);
+                         });
+        }
+        resultType await_resume() { return std::move(*result); }
+    };
+
+    ioPool(const bankConfig &config = bankSettings());
+    ioPool(const ioPool &) = delete;
+    ioPool &operator=(const ioPool &) = delete;
+    ~ioPool();
+    void submit(std::function<void(database &)> work); // Queues work for the next free connection
+    void complete(std::coroutine_handle<> waiting);     // Hands a coroutine back to the front-end thread
+    size_t runCompleted();                              // Resumes every coroutine whose work has finished
+    void waitCompleted();                               // Blocks until at least one coroutine can be resumed
+
+    /** @brief Wraps database work so a coroutine can await it
+     *  Keep the returned job in a local variable and await that. GCC 12 destroys temporaries inside a co_await expression twice, which
+     *  frees anything the work captured twice.
+     *  @param fn Called with a pooled connection. Its return value is the result of the co_await.
+     *  @return The awaitable work.
+     */
+    template <typename Fn>
+    job<Fn> run(Fn fn)
+    {
+        return job<Fn>(this, std::move(fn));
+    }
+
+    /** @brief Runs a task to completion on the calling thread
+     *  @param request The task to run.
+     *  @return The task's value.
+     */
+    template <typename T>
+    T wait(task<T> &request)
+    {
+        request.start();
+        while (!request.done())
+        {
+            waitCompleted();
+            runCompleted();
+        }
+        return request.result();
+    }
+
+    /** @brief Runs many tasks to completion on the calling thread
+     *  Every task is started before any finishes, so their database work runs side by side across the pool.
+     *  @param requests The tasks to run. Read each value with result() afterwards.
+     */
+    template <typename T>
+    void waitAll(std::vector<task<T>> &requests)
+    {
+        size_t remaining = 0;
+        for (size_t i = 0; i < requests.size(); i++)
+        {
+            requests[i].start();
+        }
+        do
+        {
+            remaining = 0;
+            for (size_t i = 0; i < requests.size(); i++)
+            {
+                remaining += requests[i].done() ? 0 : 1;
+            }
+            if (remaining > 0)
+            {
+                waitCompleted();
+                runCompleted();
+            }
+        } while (remaining > 0);
+    }
+};
+
+#endif
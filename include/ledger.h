@@ -0,0 +1,32 @@
+/** @brief Provides the functions the bank's ledger is written with
+ *
+ *  Every movement of money is one entry in the journal table: a debit of amount from one account and a credit of creditAmount to another,
+ *  with creditAmount given in the credited account's currency. Money entering or leaving the bank is posted against one of the system
+ *  accounts below, which have no row in the accounts table, so every entry is balanced however it is written.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file ledger.h
+ */
+
+#ifndef LEDGER_H
+#define LEDGER_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include "database.h"
+
+const int cashAccountID = -1;     // Money paid into or out of the bank, by deposits and withdrawals
+const int interestAccountID = -2; // Interest the bank pays on savings accounts
+const int loanAccountID = -3;     // Money the bank lends, in the base currency
+const int closedAccountID = -4;   // Takes over the entries of deleted accounts, so the other side of each stays balanced
+
+bool createLedger(database &db); // Creates the journal, moving the rows of the old transactions table into it if there is one
+
+// Writes one entry and nothing else, for callers that apply the balance changes of many entries at once. Returns the entryID, or -1.
+long long recordEntry(database &db, std::string_view entryType, int debitAccountID, int creditAccountID, double amount, double creditAmount);
+// Writes one entry and applies it to the balances of the accounts involved, inside the caller's database transaction. Returns the
+// entryID, or -1 if the entry or either balance could not be written.
+long long postEntry(database &db, std::string_view entryType, int debitAccountID, int creditAccountID, double amount, double creditAmount);
+long long postEntry(database &db, std::string_view entryType, int debitAccountID, int creditAccountID, double amount);
+
+#endif
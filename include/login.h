@@ -10,17 +10,23 @@
 
 #include <iostream>
 #include <stdio.h>
-#include "sqlite3.h"
+#include "database.h"
+#include "currency.h"
+#include "bankConfig.h"
+#include "ledger.h"
+#include "userDirectory.h"
+#include "existenceFilter.h"
+#include "idempotencyStore.h"
+#include "balanceCheckpoints.h"
+
+bool createBankTables(database &db); // Creates the users, accounts and journal tables if they don't exist
 
 class login {
 	private:
-		sqlite3 *db;
-		int rc, step;
-		std::string sql;
-		char *errorMessage;
-		bool accountFound;`
+		database db;
+		bool accountFound;
 	public:
-		login();
+		login(const bankConfig &config = bankSettings());
 		bool verifyLogin(std::string, std::string);
 		std::string checkUserType(std::string);
 };
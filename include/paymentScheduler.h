@@ -0,0 +1,95 @@
+/** @brief Provides the templace for paymentScheduler
+ *
+ *  Defines the variables and functions used by the paymentScheduler class, and the functions customers schedule payments with
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file paymentScheduler.h
+ */
+
+#ifndef PAYMENT_SCHEDULER_H
+#define PAYMENT_SCHEDULER_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <ctime>
+#include "database.h"
+#include "changeLog.h"
+#include "currency.h"
+#include "bankConfig.h"
+#include "ledger.h"
+#include "userDirectory.h"
+#include "holdBook.h"
+
+// How often a scheduled payment repeats. Stored in the scheduledPayments table by name.
+enum class paymentFrequency
+{
+    once,
+    daily,
+    weekly,
+    monthly
+};
+
+bool parsePaymentFrequency(std::string_view name, paymentFrequency &frequency); // Turns a stored frequency into a paymentFrequency
+std::string_view paymentFrequencyName(paymentFrequency frequency);               // Returns the name a paymentFrequency is stored under
+long long nextPaymentTime(long long due, paymentFrequency frequency, int dayOfMonth); // Returns when a payment is due after due
+
+bool createScheduledPayments(database &db); // Creates the table scheduled payments are kept in
+// Schedules a payment, first made at firstDue (seconds since 1970) and then at each frequency, runs times or forever if runs is -1.
+// Returns the payment's ID, or -1 if it couldn't be stored.
+long long schedulePayment(database &db, int senderAccountID, int receiverAccountID, double amount, long long firstDue,
+                          paymentFrequency frequency, int runs = -1);
+
+class paymentScheduler
+{
+private:
+    // A payment due within the horizon, waiting in the wheel
+    struct duePayment
+    {
+        long long paymentID;
+        long long due;
+        int senderAccountID;
+        int receiverAccountID;
+        double amount;
+        paymentFrequency frequency;
+        int dayOfMonth;
+        int remainingRuns;
+        int attempts;
+    };
+
+    database DB;
+    std::mutex databaseLock;
+    std::vector<std::vector<duePayment>> wheel; // One slot per second, each holding the payments due in it
+    long long currentSecond;                    // The slot the wheel has reached
+    long long loadedUntil;                      // Every payment due before this is in the wheel
+    long long lastPaymentID;                    // The newest payment the wheel has seen
+    size_t loaded;
+    int horizon;
+    int batchSize;
+    int maxAttempts;
+    int retrySeconds;
+
+    std::thread worker;
+    std::mutex stateLock;
+    std::condition_variable wakeUp;
+    bool stopping;
+
+    void add(const duePayment &payment);
+    void load(long long now);
+    int execute(std::vector<duePayment> &payments, long long now);
+    void work();
+
+public:
+    paymentScheduler(const bankConfig &config = bankSettings(), bool background = true);
+    paymentScheduler(const paymentScheduler &) = delete;
+    paymentScheduler &operator=(const paymentScheduler &) = delete;
+    ~paymentScheduler();
+    int runDue(long long now); // Makes every payment due at or before now, returns how many were sent
+    size_t getLoaded();       // Returns the number of payments in the wheel
+};
+
+#endif
@@ -0,0 +1,35 @@
+/** @brief Provides the templace for requestArena
+ *
+ *  Defines the variables and functions used by the requestArena class
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file requestArena.h
+ */
+
+#ifndef REQUEST_ARENA_H
+#define REQUEST_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+
+class requestArena : public std::pmr::memory_resource
+{
+private:
+    static const size_t initialSize = 16 * 1024;
+    alignas(std::max_align_t) std::byte initialBuffer[initialSize]; // Used before anything is taken from the heap
+    std::pmr::monotonic_buffer_resource resource;
+    size_t used; // Bytes handed out since the last reset, including ones already freed, which the arena never reuses
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+public:
+    requestArena();
+    requestArena(const requestArena &) = delete;
+    requestArena &operator=(const requestArena &) = delete;
+    std::pmr::memory_resource *get(); // Returns the memory resource to hand to the request's objects
+    size_t size() const;              // Returns the bytes handed out since the last reset
+    void reset();                     // Frees everything allocated for the request at once
+};
+
+#endif
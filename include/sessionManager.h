@@ -0,0 +1,69 @@
+/** @brief Provides the templace for sessionManager
+ *
+ *  Defines the variables and functions used by the sessionManager class
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file sessionManager.h
+ */
+
+#ifndef SESSION_MANAGER_H
+#define SESSION_MANAGER_H
+
+#include <iostream>
+#include <string>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <ctime>
+#include <cerrno>
+#include <sys/random.h>
+#include "login.h"
+#include "customer.h"
+#include "administrator.h"
+#include "requestArena.h"
+
+class sessionManager
+{
+private:
+    // Destroys a customer built in its session's arena. The memory is given back when the arena is reset.
+    struct arenaDelete
+    {
+        void operator()(customer *built) const { built->~customer(); }
+    };
+
+    // One logged in user, along with the objects built for them so far
+    struct session
+    {
+        std::string token;
+        std::string username;
+        std::string userType;
+        std::unique_ptr<requestArena> arena; // Holds the customer, its accounts and strings, so must outlive customerState
+        std::unique_ptr<customer, arenaDelete> customerState;
+        std::unique_ptr<administrator> administratorState;
+        time_t lastUsed;
+    };
+
+    bankConfig config; // The settings each session's customer or administrator is built with
+    login loginPage;
+    size_t capacity;
+    int idleSeconds;
+    size_t arenaLimit; // The most memory a session's customer may have used before it is rebuilt in a fresh arena
+    std::list<session> sessions; // Most recently used first
+    std::unordered_map<std::string, std::list<session>::iterator> tokens;
+
+    std::string newToken();
+    session *find(std::string token);
+    void expireIdle();
+
+public:
+    sessionManager(const bankConfig &config = bankSettings());
+    std::string startSession(std::string username, std::string password); // Returns a session token, or "" if the login is wrong or fails
+    void endSession(std::string token);
+    std::string getUserName(std::string token);
+    std::string getUserType(std::string token);
+    customer *getCustomer(std::string token);           // Returns the session's customer, or nullptr
+    administrator *getAdministrator(std::string token); // Returns the session's administrator, or nullptr
+    void invalidateUser(std::string username);          // Drops cached objects for a user that was changed, or ends their sessions if removed
+    size_t size();
+};
+
+#endif
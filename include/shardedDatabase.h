@@ -0,0 +1,71 @@
+/** @brief Provides the templace for shardedDatabase
+ *
+ *  Defines the variables and functions used by the shardedDatabase class
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file shardedDatabase.h
+ */
+
+#ifndef SHARDED_DATABASE_H
+#define SHARDED_DATABASE_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include "database.h"
+#include "login.h"
+#include "account.h"
+
+const int maxShards = 11; // The most shard files, each kept open on its own connection
+
+class shardedDatabase
+{
+private:
+    std::string baseName;
+    std::vector<database> shards; // One connection per file
+
+    /** @brief Runs a query on every shard at once
+     *  @param query Called with each shard's connection, each on its own thread.
+     *  @return Each shard's result, in shard order.
+     */
+    template <typename T, typename Fn>
+    std::vector<T> fanOut(Fn query)
+    {
+        std::vector<T> results(shards.size());
+        std::vector<std::thread> threads;
+        threads.reserve(shards.size());
+        for (size_t i = 0; i < shards.size(); i++)
+        {
+            threads.emplace_back([&, i]
+                                 { results[i] = query(shards[i]); });
+        }
+        for (size_t i = 0; i < threads.size(); i++)
+        {
+            threads[i].join();
+        }
+        return results;
+    }
+
+public:
+    shardedDatabase(std::string baseName = "bankShard", int numShards = 4, const bankConfig &config = bankSettings());
+    int getNumShards();
+    int shardFor(std::string_view username); // The shard holding a user, their accounts, and the transactions they send
+    int shardOfAccount(int accountID);       // The shard holding an account, read straight from its ID
+    database &shard(int index);
+
+    bool createUser(std::string username, std::string password, std::string name, std::string userType);
+    bool verifyLogin(std::string username, std::string password);
+    int createAccount(std::string username, accountKind kind, double initialMoney); // Returns the new account's ID, or -1
+    double getBalance(int accountID);                                               // Returns -1 if the account doesn't exist
+    double getMoney(std::string username);
+    bool transfer(int senderAccountID, int receiverAccountID, double amount);
+
+    // Analytics, computed on every shard in parallel and then combined
+    int getNumUsers();
+    int getNumTransactions();
+    double getTotalBalance();
+    double getAverageBalance();
+};
+
+#endif
@@ -0,0 +1,105 @@
+/** @brief Provides the templace for task
+ *
+ *  A task is the result of a coroutine that produces one value. It doesn't start running until it is awaited or started, and when it
+ *  finishes it resumes whichever coroutine awaited it.
+ *
+ *      task<double> total(ioPool &pool)
+ *      {
+ *          double balance = co_await pool.run([](database &db) { return db.queryValue<double>("SELECT SUM(balance) FROM accounts;").value_or(0); });
+ *          co_return balance;
+ *      }
+ *
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file task.h
+ */
+
+#ifndef TASK_H
+#define TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+template <typename T>
+class task
+{
+public:
+    struct promise_type
+    {
+        std::optional<T> value;
+        std::coroutine_handle<> continuation; // The coroutine awaiting this one, if any
+
+        // Resumes the awaiting coroutine directly, so long chains of tasks don't grow the stack
+        struct finalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> finished) noexcept
+            {
+                std::coroutine_handle<> next = finished.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+
+        task get_return_object() { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        finalAwaiter final_suspend() noexcept { return {}; }
+        void return_value(T result) { value = std::move(result); }
+        void unhandled_exception() { std::terminate(); } // Nothing in the bank throws, so an exception here is a bug
+    };
+
+    task(task &&other) noexcept : coroutine(std::exchange(other.coroutine, nullptr)) {}
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+    task &operator=(task &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (coroutine)
+            {
+                coroutine.destroy();
+            }
+            coroutine = std::exchange(other.coroutine, nullptr);
+        }
+        return *this;
+    }
+    ~task()
+    {
+        if (coroutine)
+        {
+            coroutine.destroy();
+        }
+    }
+
+    /** @brief Starts the task without awaiting it
+     *  It runs on the calling thread until its first suspension. Used at the top level, where there is no coroutine to await it.
+     */
+    void start() { coroutine.resume(); }
+
+    /** @brief Returns whether the task has finished
+     *  @return True once the coroutine has returned its value.
+     */
+    bool done() const { return coroutine && coroutine.done(); }
+
+    /** @brief Returns the value of a finished task
+     *  @return The value the coroutine returned. Only valid once done() is true.
+     */
+    T result() { return std::move(*coroutine.promise().value); }
+
+    // Awaiting a task starts it, and the awaiting coroutine resumes once it finishes.
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept
+    {
+        coroutine.promise().continuation = caller;
+        return coroutine;
+    }
+    T await_resume() { return result(); }
+
+private:
+    std::coroutine_handle<promise_type> coroutine;
+
+    explicit task(std::coroutine_handle<promise_type> coroutine) : coroutine(coroutine) {}
+};
+
+#endif
@@ -0,0 +1,49 @@
+/** @brief Provides the templace for transactionPartitions
+ *
+ *  Defines the variables and functions used by the transactionPartitions class
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file transactionPartitions.h
+ */
+
+#ifndef TRANSACTION_PARTITIONS_H
+#define TRANSACTION_PARTITIONS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdio>
+#include <ctime>
+#include <sys/stat.h>
+#include "database.h"
+#include "columnarArchive.h"
+#include "bankConfig.h"
+#include "ledger.h"
+
+class transactionPartitions
+{
+private:
+    database DB;
+    std::string directory;
+
+    std::string partitionPath(const std::string &month);  // The file a month is sealed into
+    std::string archivePath(const std::string &month);    // The file a month is archived into
+    std::string schemaName(const std::string &month);     // The name a month's file is attached under
+    bool attachPartition(const std::string &month);       // Attaches a sealed month that isn't archived
+    void detachPartition(const std::string &month);
+    bool hasCreditColumn(const std::string &month);       // Whether an attached month's file keeps credited amounts
+    bool sealMonth(const std::string &month);
+    bool readRange(const std::string &fromTime, const std::string &toTime, int accountID,
+                   const std::function<void(const transactionRecord &)> &visit);
+
+public:
+    transactionPartitions(const bankConfig &config = bankSettings());
+    int sealCompletedMonths(std::string beforeMonth = ""); // Moves every month before beforeMonth (default: this month) out of the live journal
+    int archiveOlderThan(int days);                        // Seals finished months, then archives those that ended over days ago
+    bool archiveMonth(std::string month);                  // Rewrites a sealed month as a columnar archive
+    std::vector<std::string> getSealedMonths();
+    bool forEachInRange(std::string fromTime, std::string toTime, std::function<void(const transactionRecord &)> visit);
+    bool forEachForAccount(int accountID, std::string fromTime, std::string toTime, std::function<void(const transactionRecord &)> visit);
+};
+
+#endif
@@ -0,0 +1,46 @@
+/** @brief Provides the templace for userDirectory
+ *
+ *  Defines the variables and functions used by the userDirectory class. Users are keyed by an integer userID, which every account row
+ *  refers to. A username is only compared as text once, when it is first looked up, usually at login, and the userDirectory remembers
+ *  its ID after that.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file userDirectory.h
+ */
+
+#ifndef USER_DIRECTORY_H
+#define USER_DIRECTORY_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include "database.h"
+#include "currency.h"
+#include "existenceFilter.h"
+
+bool addUserIDs(database &db); // Rebuilds users and accounts tables keyed by username around an integer userID
+
+class userDirectory
+{
+private:
+    // Lets the map be searched with a string_view without building a string
+    struct usernameHash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view username) const { return std::hash<std::string_view>()(username); }
+    };
+
+    std::shared_mutex lock; // Lookups share it, and only a user's first lookup takes it alone
+    std::unordered_map<std::string, int, usernameHash, std::equal_to<>> ids;
+
+public:
+    int find(database &db, std::string_view username);    // Returns the user's ID, reading it from db the first time, or -1
+    void remember(std::string_view username, int userID); // Records an ID already read, such as at login
+    void forget(std::string_view username);               // Drops a removed user, whose username may be given to a new user
+};
+
+userDirectory &userIDs(); // The directory every class in this process resolves usernames through
+
+#endif
@@ -11,70 +11,88 @@
 
 using namespace std;
 
-/** @brief Helps with executing sql.
- *
- *  This function is used when executing sql statements.
- *  @param unused This variable is not used and serves no purpose.
- *  @param numColumns The number of columns in the table.
- *  @param value List of the values from the current row from each column.
- *  @param columns Name of each column in the table.
- *  @return Always returns to fit the base necessities.
+/** @brief Turns a stored account type into an accountKind
+ *
+ *  @param name Represents the account type, as stored in the accounts table
+ *  @param kind Set to the matching accountKind
+ *  @return returns true if the name is a known account type, false otherwise
  */
-static int callback(void *unused, int numColumns, char **value, char **columns)
+bool parseAccountKind(string_view name, accountKind &kind)
 {
-	for (int i = 0; i < numColumns; i++)
+	if (name == "chequing")
 	{
-		cout << "Name = " << columns[i] << "   Value = " << value[i] << endl;
+		kind = accountKind::chequing;
+		return true;
 	}
-	return 0;
+	if (name == "savings")
+	{
+		kind = accountKind::savings;
+		return true;
+	}
+	return false;
+}
+
+/** @brief Returns the name an accountKind is stored under
+ *
+ *  @param kind Represents the account type
+ *  @return returns "chequing" or "savings"
+ */
+string_view accountKindName(accountKind kind)
+{
+	return kind == accountKind::savings ? "savings" : "chequing";
 }
 
 /** @brief Creates a new account for the customer.
  *
  *  Takes an accountType, username, and initial deposit. This will populate the account's data members, and then
- *  Writes the account to the accounts table in the database
- *  @param accountType Represents the type of account to be opened
+ *  Writes the account to the accounts table in the database. If the account can't be written, its ID is left at 0.
+ *  @param DB Represents the database connection of the customer opening the account
+ *  @param kind Represents the type of account to be opened
+ *  @param userID Represents the ID of the customer that's opening the account
  *  @param username Represents the username of the customer that's opening the account
  *  @param smoney Represents the initial deposit for the account upon opening.
+ *  @param currency Represents the code of the currency the account is held in
+ *  @param resource Represents the memory the account's strings are allocated from
  */
-account::account(string accountType, string username, double smoney)
+account::account(database *DB, accountKind kind, int userID, string_view username, double smoney, string_view currency,
+				 pmr::memory_resource *resource)
+	: DB(DB), userID(userID), username(username, resource), currency(currency, resource), kind(kind), balance(smoney), accountID(0)
 {
-	// Populates data members
-	this->accountType = accountType;
-	this->username = username;
-	balance = smoney;
-	errorMessage = 0;
-
-	// Opens the database
-	rc = sqlite3_open("newDatabase.db", &DB);
-
 	// Adds a new row to the accounts table, with the parameter values provided.
-	sql = "INSERT INTO accounts(username, accountType, initialBalance, balance) VALUES (\"" + username + "\", \"" + accountType + "\", " + to_string(smoney) + ", " + to_string(smoney) + ");";
-
-	rc = sqlite3_exec(DB, sql.c_str(), callback, 0, &errorMessage);
-
-	storeValues();
+	DB->exec("BEGIN;");
+	if (DB->run("INSERT INTO accounts(userID, accountType, initialBalance, balance, currency) VALUES (?, ?, ?, ?, ?);",
+				userID, accountKindName(kind), smoney, smoney, this->currency))
+	{
+		int insertedID = (int)DB->lastInsertID();
+		if (changeFeed().commit(*DB, {{changeType::accountOpened, insertedID, 0, smoney, string(username)}}))
+		{
+			accountID = insertedID;
+		}
+	}
+	else
+	{
+		DB->exec("ROLLBACK;");
+	}
 }
 
 /** @brief Creates an account object to represent an EXISTING account.
  *
- *  Creates an account object to represent an existing account. This constructor will not write to the database, but instead
- *  fetch it's data from the accounts table and populates its data members.
- *  @param accountType Represents the type of account
+ *  Creates an account object to represent an existing account from a row the customer has already read. This constructor does not
+ *  touch the database.
+ *  @param DB Represents the database connection of the customer that owns this account
+ *  @param accountID Represents the account's ID
+ *  @param kind Represents the type of account
+ *  @param userID Represents the ID of the customer that owns this account
  *  @param username Represents the username of the customer that owns this account
+ *  @param balance Represents the account's balance when it was read
+ *  @param currency Represents the code of the currency the account is held in
+ *  @param resource Represents the memory the account's strings are allocated from
  *
  */
-account::account(string accountType, string username)
+account::account(database *DB, int accountID, accountKind kind, int userID, string_view username, double balance, string_view currency,
+				 pmr::memory_resource *resource)
+	: DB(DB), userID(userID), username(username, resource), currency(currency, resource), kind(kind), balance(balance), accountID(accountID)
 {
-	// Populates data members
-	this->accountType = accountType;
-	this->username = username;
-	errorMessage = 0;
-
-	rc = sqlite3_open("newDatabase.db", &DB);
-
-	// fetches account data from the accounts table and stores it.
-	storeValues();
 }
 
 /** @brief destructor for the account object
@@ -98,6 +116,48 @@ double account::getBalance()
 	return balance;
 }
 
+/** @brief Returns the balance this account can spend
+ *
+ *  This method fetches the balance in the database, and subtracts the funds held for card authorizations that haven't been captured,
+ *  released or expired yet.
+ *	@return returns the available balance of the account
+ */
+double account::getAvailableBalance()
+{
+	refreshBalance();
+	return balance - authorizationHolds().held(*DB, accountID);
+}
+
+/** @brief Holds funds for a card authorization
+ *
+ *  The funds stay in the account, but can't be withdrawn or sent until the hold is captured, which posts it, or released. Whether the
+ *  account can cover the hold is decided from its balance and its other holds in memory.
+ *  @param amount Represents the amount held
+ *  @param seconds Represents how long the hold lasts before it expires, or 0 for the configured time
+ *  @return returns the hold's ID, which it is captured or released by, or -1 if the available balance doesn't cover it
+ */
+long long account::authorize(double amount, int seconds)
+{
+	refreshBalance();
+	long long holdID = authorizationHolds().place(*DB, accountID, amount, balance, seconds);
+	if (holdID < 0)
+	{
+		cout << "Not Enough Funds!" << endl;
+	}
+	return holdID;
+}
+
+/** @brief Returns the balance this account had at a past time
+ *
+ *  The balance is read from the nearest end of day checkpoint, and the journal entries between the checkpoint and the time.
+ *  @param timestamp Represents the time, as YYYY-MM-DD HH:MM:SS in UTC, or YYYY-MM-DD for the start of that day
+ *	@return returns the balance at that time, or nothing if it can't be worked out
+ */
+optional<double> account::getBalanceAsOf(string_view timestamp)
+{
+	return balanceAsOf(*DB, accountID, timestamp);
+}
+
 /** @brief Creates an account object to represent an EXISTING account.
  *
  *	This method checks the account's balance, to see if a loan is approved
@@ -127,18 +187,29 @@ bool account::applyForLoan(double amount)
  *	@return returns accountID, which represents the accountID associated with the account.
  *
  */
-int account::getID()
+int account::getID() const
 {
 	return accountID;
 }
 
+/** @brief Returns the ID of the user the account belongs to
+ *
+ *	This method returns the userID the account's row refers to its owner by
+ *	@return returns userID, which represents the user associated with the account.
+ *
+ */
+int account::getUserID() const
+{
+	return userID;
+}
+
 /** @brief Returns the username associated with the account
  *
  *	This method returns the username associated with the account
  *	@return returns username, which represents the username associated with the account.
  *
  */
-string account::getUserName()
+string_view account::getUserName() const
 {
 	return username;
 }
@@ -149,60 +220,140 @@ string account::getUserName()
  *	@return returns accountType, which represents the account type of this account.
  *
  */
-string account::getAccountType()
+string_view account::getAccountType() const
+{
+	return accountKindName(kind);
+}
+
+/** @brief Returns the currency of the account
+ *
+ *	This method returns the code of the currency the account's balance is held in, such as CAD or USD
+ *	@return returns the account's currency code.
+ *
+ */
+string_view account::getCurrency() const
+{
+	return currency;
+}
+
+/** @brief Returns the account type of the account
+ *
+ *	This method returns the account type as an accountKind, which is cheaper to compare than its name
+ *	@return returns the accountKind of this account.
+ *
+ */
+accountKind account::getAccountKind() const
 {
-	return accountType;
+	return kind;
 }
 
 /** @brief Withdraw money from the customer account
  *
- *	This method will check to see if the account has sufficient funds. If so, it writes the transaction to the database, subtracts the requested
- *  amount from the account, and stores the new value in the data member
+ *	This method will check to see if the account has sufficient funds, not counting funds held for card authorizations. If so, it posts
+ *  the withdrawal to the journal, which subtracts the
+ *  requested amount from the account, and stores the new value in the data member. The funds are checked inside the database transaction
+ *  that posts the withdrawal, after it has taken the write lock, so another connection can't spend or hold them in between.
  *  @param amount Represents the amount to be withdrawn
- *  @return returns true if the account has enough funds to be withdrawn. False otherwise.
+ *  @param idempotencyKey Represents a key chosen by the client, so a retry with the same key returns the first call's result without
+ *  withdrawing again, or an empty string
+ *  @return returns true if the account has enough funds to be withdrawn, or a withdrawal with the key was already made. False otherwise.
  *
  */
-bool account::withdraw(double amount)
+bool account::withdraw(double amount, string_view idempotencyKey)
 {
-	// Store the most up-to-date balance value of the account.
-	refreshBalance();
+	idempotentCall call{"withdraw", accountID, 0, amount};
+	idempotencyResult earlier = idempotencyKeys().check(*DB, idempotencyKey, call);
+	if (earlier != idempotencyResult::fresh)
+	{
+		return replayEarlier(earlier);
+	}
 
-	// If the account has enough funds remaining, updates the transactions table, and the account balance
-	if (balance >= amount)
+	if (!DB->exec("BEGIN IMMEDIATE;"))
 	{
-		sql = "INSERT INTO transactions(senderAccountID, transactionType, amount) VALUES (" + to_string(accountID) + ", \"withdraw\", " + to_string(amount) + ");";
-		rc = sqlite3_exec(DB, sql.c_str(), callback, 0, &errorMessage);
+		cout << "Could not withdraw: " << DB->getError() << endl;
+		return false;
+	}
 
-		sql = "UPDATE accounts SET balance = balance - " + to_string(amount) + " WHERE accountID = " + to_string(accountID) + ";";
-		rc = sqlite3_exec(DB, sql.c_str(), callback, 0, &errorMessage);
+	// Store the most up-to-date balance value of the account, read under the write lock.
+	refreshBalance();
+
+	// If the account doesn't have enough funds remaining, nothing is paid out
+	if (balance - authorizationHolds().held(*DB, accountID) < amount)
+	{
+		DB->exec("ROLLBACK;");
+		cout << "Not Enough Funds!" << endl;
+		return false;
+	}
 
-		// Stores the new balance in the account object
+	// Pays the money out of the account to the bank's cash
+	long long entryID = postEntry(*DB, "withdraw", accountID, cashAccountID, amount);
+	if (entryID < 0)
+	{
+		cout << "Could not withdraw: " << DB->getError() << endl;
+		DB->exec("ROLLBACK;");
+		return false;
+	}
+	earlier = idempotencyKeys().claim(*DB, idempotencyKey, call, entryID);
+	if (earlier != idempotencyResult::fresh)
+	{
+		DB->exec("ROLLBACK;");
 		refreshBalance();
-		return true;
+		return replayEarlier(earlier);
 	}
-	else
+	if (!changeFeed().commit(*DB, {{changeType::withdraw, accountID, 0, amount, string(username)}}))
 	{
-		cout << "Not Enough Funds!" << endl;
+		refreshBalance();
 		return false;
 	}
+	idempotencyKeys().remember(idempotencyKey, call, entryID);
+
+	// Stores the new balance in the account object
+	refreshBalance();
+	return true;
 }
 
 /** @brief Deposit money into the customer account
  *
- *	This method will add the transaction record into the transaction table, and adds the amount to the balance in the accounts table.
+ *	This method will post the deposit to the journal, which adds the amount to the balance in the accounts table.
  *	It then pulls the new balance from the database and stores it into the object.
  *  @param amount Represents the amount to deposit
- *  @return returns true if the account successfully deposits the money
+ *  @param idempotencyKey Represents a key chosen by the client, so a retry with the same key returns the first call's result without
+ *  depositing again, or an empty string
+ *  @return returns true if the account successfully deposits the money, or a deposit with the key was already made
  *
  */
-bool account::deposit(double amount)
+bool account::deposit(double amount, string_view idempotencyKey)
 {
-	// Updates the transactions table, and the account balance
-	sql = "INSERT INTO transactions(senderAccountID, transactionType, amount) VALUES (" + to_string(accountID) + ", \"deposit\", " + to_string(amount) + ");";
-	rc = sqlite3_exec(DB, sql.c_str(), callback, 0, &errorMessage);
+	idempotentCall call{"deposit", accountID, 0, amount};
+	idempotencyResult earlier = idempotencyKeys().check(*DB, idempotencyKey, call);
+	if (earlier != idempotencyResult::fresh)
+	{
+		refreshBalance();
+		return replayEarlier(earlier);
+	}
 
-	sql = "UPDATE accounts SET balance = balance + " + to_string(amount) + " WHERE accountID = " + to_string(accountID) + ";";
-	rc = sqlite3_exec(DB, sql.c_str(), callback, 0, &errorMessage);
+	// Pays the money from the bank's cash into the account, and claims the key in the same database transaction
+	DB->exec("BEGIN;");
+	long long entryID = postEntry(*DB, "deposit", cashAccountID, accountID, amount);
+	if (entryID < 0)
+	{
+		cout << "Could not deposit: " << DB->getError() << endl;
+		DB->exec("ROLLBACK;");
+		return false;
+	}
+	earlier = idempotencyKeys().claim(*DB, idempotencyKey, call, entryID);
+	if (earlier != idempotencyResult::fresh)
+	{
+		DB->exec("ROLLBACK;");
+		refreshBalance();
+		return replayEarlier(earlier);
+	}
+	if (!changeFeed().commit(*DB, {{changeType::deposit, accountID, 0, amount, string(username)}}))
+	{
+		refreshBalance();
+		return false;
+	}
+	idempotencyKeys().remember(idempotencyKey, call, entryID);
 
 	// Stores the new balance in the account object
 	refreshBalance();
@@ -211,49 +362,38 @@ bool account::deposit(double amount)
 
 /** @brief Fetches the account information from the database
  *
- *	This method fetches the most updated accountType, balance, and accountID information from the accounts table, and stores it in
+ *	This method fetches the most updated accountType and balance information from the accounts table, and stores it in
  *  this account object.
  */
 void account::storeValues()
 {
-	// Declares the statement object
-	sqlite3_stmt *stmt;
-
-	// Retrieves the account's type, balance, and ID
-	sql = "SELECT accountType, balance, accountID FROM accounts WHERE username = \"" + username + "\" AND accountType = \"" + accountType + "\";";
-	sqlite3_prepare_v2(DB, sql.c_str(), sql.length(), &stmt, nullptr);
-
-	step = sqlite3_step(stmt);
-
-	// Parses the returned row, and stores each value in its respective data members
-	accountType = string(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)));
-	balance = (sqlite3_column_double(stmt, 1));
-	accountID = (sqlite3_column_int(stmt, 2));
-
-	// Destroys the statement object
-	sqlite3_finalize(stmt);
+	// The account's type and balance, in the order they are selected
+	struct accountRow
+	{
+		string_view accountType;
+		double balance;
+		static auto columns() { return make_tuple(&accountRow::accountType, &accountRow::balance); }
+	};
+
+	// Retrieves the account's type and balance, and stores each value in its respective data members
+	DB->forEach<accountRow>("SELECT accountType, balance FROM accounts WHERE accountID = ?;", [&](const accountRow &row)
+							{
+								parseAccountKind(row.accountType, kind);
+								balance = row.balance;
+							},
+							accountID);
 }
 
 /** @brief Refreshes the balance of the account
  *
- *	This method fetches the most updated accountType, balance, and accountID information from the accounts table, and stores it in
- *  this account object.
+ *	This method fetches the most updated balance from the accounts table, and stores it in this account object.
  */
 void account::refreshBalance()
 {
-	// Declares the statement object
-	sqlite3_stmt *stmt;
-
-	// Retrieves the account's balance
-	sql = "SELECT balance FROM accounts WHERE username = \"" + username + "\" AND accountType = \"" + accountType + "\";";
-
-	sqlite3_prepare_v2(DB, sql.c_str(), sql.length(), &stmt, nullptr);
-
-	step = sqlite3_step(stmt);
-
-	// Stores the balance
-	balance = (sqlite3_column_double(stmt, 0));
-
-	// Destroys the statement object
-	sqlite3_finalize(stmt);
+	// Retrieves and stores the account's balance
+	optional<double> fetched = DB->queryValue<double>("SELECT balance FROM accounts WHERE accountID = ?;", accountID);
+	if (fetched)
+	{
+		balance = *fetched;
+	}
 }
@@ -0,0 +1,155 @@
+/** @brief Detaches the journal entries of deleted accounts in the background.
+ *
+ *  Deleting an account or a user only removes the account and user rows and queues each account in the purgeQueue table, which is quick
+ *  however long the account's history is. This class then moves the queued accounts' side of each journal entry onto the closed-account
+ *  system account a small batch at a time, each batch in its own short database transaction with a pause after it, so closing a large
+ *  account never holds the write lock for long. The entries themselves are kept, so the other account of each transfer still has its
+ *  history and the ledger still balances. Account IDs are never reused, so entries left behind for a while can't be mistaken for a new
+ *  account's.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file accountPurger.cpp
+ *  @class accountPurger "../include/accountPurger.h"
+ */
+
+#include "accountPurger.h"
+
+using namespace std;
+
+/** @brief Creates the purge queue
+ *
+ *  @param db Represents the database whose deleted accounts are queued
+ *  @return returns true if the table exists afterwards, false otherwise
+ */
+bool createPurgeQueue(database &db)
+{
+	return db.exec("create table if not exists purgeQueue ("
+				   "accountID INTEGER PRIMARY KEY, "
+				   "queuedAt DATETIME default CURRENT_TIMESTAMP NOT NULL);");
+}
+
+/** @brief Opens the database and starts purging
+ *
+ *  @param config Represents the settings the database is opened with, the most entries detached in one database transaction, the
+ *  pause after each batch, and how often an empty queue is checked again
+ *  @param background Represents whether to start a thread that purges on its own. Without one, purgeBatch has to be called.
+ */
+accountPurger::accountPurger(const bankConfig &config, bool background)
+{
+	batchSize = config.purgeBatchSize > 0 ? config.purgeBatchSize : 1;
+	pause = chrono::milliseconds(config.purgePauseMilliseconds);
+	idle = chrono::milliseconds(config.purgeIdleMilliseconds);
+	stopping = false;
+	woken = false;
+
+	config.open(DB);
+	createPurgeQueue(DB);
+	createLedger(DB);
+
+	if (background)
+	{
+		worker = thread(&accountPurger::work, this);
+	}
+}
+
+/** @brief Stops purging
+ *
+ *  Waits for the current batch to finish. Accounts still queued are picked up the next time a purger runs.
+ */
+accountPurger::~accountPurger()
+{
+	{
+		lock_guard<mutex> guard(stateLock);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+}
+
+/** @brief Detaches one batch of a deleted account's journal entries
+ *
+ *  Takes the oldest queued account and moves up to batchSize of its entries onto the closed-account system account, debits first. Once
+ *  none are left, the account leaves the queue.
+ *  @return returns the number of entries detached, or -1 if the batch failed
+ */
+int accountPurger::purgeBatch()
+{
+	lock_guard<mutex> guard(databaseLock);
+	optional<int> accountID = DB.queryValue<int>("SELECT accountID FROM purgeQueue ORDER BY queuedAt, accountID LIMIT 1;");
+	if (!accountID)
+	{
+		return 0;
+	}
+
+	if (!DB.exec("BEGIN IMMEDIATE;"))
+	{
+		return -1;
+	}
+	bool ok = DB.run("UPDATE journal SET debitAccountID = ? WHERE entryID IN "
+					 "(SELECT entryID FROM journal WHERE debitAccountID = ? LIMIT ?);",
+					 closedAccountID, *accountID, batchSize);
+	int removed = ok ? DB.changes() : 0;
+	if (ok && removed < batchSize)
+	{
+		ok = DB.run("UPDATE journal SET creditAccountID = ? WHERE entryID IN "
+					"(SELECT entryID FROM journal WHERE creditAccountID = ? LIMIT ?);",
+					closedAccountID, *accountID, batchSize - removed);
+		removed += ok ? DB.changes() : 0;
+	}
+	if (ok && removed < batchSize)
+	{
+		ok = DB.run("DELETE FROM purgeQueue WHERE accountID = ?;", *accountID);
+	}
+	if (!ok || !DB.exec("COMMIT;"))
+	{
+		cout << "Could not purge account " << *accountID << ": " << DB.getError() << endl;
+		DB.exec("ROLLBACK;");
+		return -1;
+	}
+	return removed;
+}
+
+/** @brief Returns the number of deleted accounts not yet purged
+ *
+ *  @return returns the number of accounts in the purge queue
+ */
+int accountPurger::getPending()
+{
+	lock_guard<mutex> guard(databaseLock);
+	return DB.queryValue<int>("SELECT COUNT(*) FROM purgeQueue;").value_or(0);
+}
+
+/** @brief Starts on the queue now
+ *
+ *  Called after an account is deleted, so the purger doesn't wait for its next check.
+ */
+void accountPurger::wake()
+{
+	{
+		lock_guard<mutex> guard(stateLock);
+		woken = true;
+	}
+	wakeUp.notify_all();
+}
+
+/** @brief Purges batches until the purger is destroyed
+ *
+ *  Pauses after every batch, and waits for idle, or for wake, whenever the queue is empty or a batch fails.
+ */
+void accountPurger::work()
+{
+	unique_lock<mutex> guard(stateLock);
+	while (!stopping)
+	{
+		guard.unlock();
+		int removed = purgeBatch();
+		bool pending = removed > 0 || (removed == 0 && getPending() > 0);
+		guard.lock();
+
+		wakeUp.wait_for(guard, pending ? pause : idle, [this]
+						{ return stopping || woken; });
+		woken = false;
+	}
+}
@@ -1,7 +1,8 @@
 /** @brief Grants administrator functions.
  * 
  *  Allows the administrator, a user with more privilege, to perform various administrator-exclusive functions. This is especially in 
- *  regards to editing users and viewing user information.
+ *  regards to editing users and viewing user information. A user's fields are read together as one profile, and a profile read moments
+ *  ago is used again until this administrator changes that user.
  *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
  *  @file administrator.cpp
  *  @class administrator "../include/administrator.h"
@@ -11,149 +12,205 @@
 
 using namespace std;
 
-/** @brief Helps with executing sql.
- *  @param unused This variable is not used and serves no purpose.
- *  @param numColumns The number of columns in the table.
- *  @param value List of the values from the current row from each column.
- *  @param columns Name of each column in the table.
- *  @return Always returns to fit the base necessities.
- * 
- *  This function is used when executing sql statements.
-*/  
-static int callback(void *unused, int numColumns, char **value, char **columns) {
-    for (int i = 0; i < numColumns; i++) {
-        cout << "Name = " << columns[i] << "   Value = " << value[i] << endl;
-        }
-    return 0;
-}
-
 /** @brief Opens the database.
+ *  @param config The settings the database is opened with, and how many user profiles are kept and for how long.
  * 
  * Opens the bank database and allows the database's foreign keys to be usable.
 */
-administrator::administrator() {
-    rc = sqlite3_open("bankDatabase.db", &db);
-    if (rc) {
-        cout << "Can't open database" << endl;
-	}
+administrator::administrator(const bankConfig &config) {
+    profileCapacity = config.profileCacheSize > 0 ? config.profileCacheSize : 1;
+    profileLifetime = chrono::milliseconds(config.profileCacheMilliseconds);
+    config.open(db);
 
     //Allowing the compatibility of foreign keys
-    sql = "PRAGMA foreign_keys = ON;";
-    rc = sqlite3_exec(db, sql.c_str(), callback, 0, &errorMessage);
+    db.exec("PRAGMA foreign_keys = ON;");
+    addUserIDs(db);
+    createLedger(db);
+}
+
+/** @brief Registers a function to call when a user is changed.
+ *  @param listener Called with the username of every user this administrator updates, removes or gives a loan to.
+ * 
+ *  Lets anything caching a user's data, such as the session manager, drop its copy when an administrator changes that user.
+*/
+void administrator::onUserChanged(function<void(string)> listener) {
+    userChanged = listener;
 }
 
 /** @brief Checks if a user exists.
  *  @param username We are checking if this username exists in the database.
  *  @return Returns true if the username does exist in the database, and false otherwise.
  * 
- * Taking in a username, this function goes through every username in the users table to find a match.
+ * Taking in a username, this function goes through every username in the users table to find a match, unless the existence
+ * filters have never seen it.
 */
 bool administrator::userExists(string username) {
-    sql = "SELECT EXISTS(SELECT 1 FROM users WHERE username = \"" + username + "\");";
-    sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-    step = sqlite3_step(stmt);
-    empty = (sqlite3_column_int(stmt,0));
-    sqlite3_finalize(stmt);
-    if (empty == 0) {
-        return false;
-    }
-    return true;
+    return existenceFilters().mightHaveUser(username) &&
+           db.queryValue<int>("SELECT EXISTS(SELECT 1 FROM users WHERE username = ?);", username).value_or(0) == 1;
 }
 
 /** @brief Checks if an account exists.
  *  @param accountID We are checking if this account ID exists in the database.
  *  @return Returns true if the account ID does exist in the database, and false otherwise.
  * 
- * Taking in an account ID, this function goes through every account ID in the accounts table to find a match.
+ * Taking in an account ID, this function goes through every account ID in the accounts table to find a match, unless the existence
+ * filters have never seen it.
 */
 bool administrator::accountExists(int accountID) {
-    sql = "SELECT EXISTS(SELECT 1 FROM accounts WHERE accountID = " + to_string(accountID) + ";";
-    sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-    step = sqlite3_step(stmt);
-    empty = (sqlite3_column_int(stmt,0));
-    sqlite3_finalize(stmt);
-    if (empty == 0) {
-        return false;
+    return existenceFilters().mightHaveAccount(accountID) &&
+           db.queryValue<int>("SELECT EXISTS(SELECT 1 FROM accounts WHERE accountID = ?);", accountID).value_or(0) == 1;
+}
+
+/** @brief Finds a profile read recently enough to use.
+ *  @param username The username of the user.
+ *  @return Returns the kept profile, or nullptr if there isn't one or it is too old.
+*/
+const userProfile *administrator::findCachedProfile(const string &username) {
+    unordered_map<string, cachedProfile>::iterator found = profiles.find(username);
+    if (found == profiles.end()) {
+        return nullptr;
+    }
+    if (chrono::steady_clock::now() - found->second.readAt >= profileLifetime) {
+        profiles.erase(found);
+        return nullptr;
+    }
+    return &found->second.profile;
+}
+
+/** @brief Keeps a profile that was just read.
+ *  @param profile The profile.
+ *
+ *  When the cache is full, profiles that are too old are dropped, and if that isn't enough, all of them are.
+*/
+void administrator::cacheProfile(const userProfile &profile) {
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if (profiles.size() >= profileCapacity && profiles.find(profile.username) == profiles.end()) {
+        for (unordered_map<string, cachedProfile>::iterator i = profiles.begin(); i != profiles.end();) {
+            i = now - i->second.readAt >= profileLifetime ? profiles.erase(i) : next(i);
+        }
+        if (profiles.size() >= profileCapacity) {
+            profiles.clear();
+        }
+    }
+    profiles[profile.username] = {profile, now};
+}
+
+/** @brief Gets everything about a user.
+ *  @param username The username of the user.
+ *  @return Returns the user's profile, or nothing if the user does not exist.
+ * 
+ *  Reads every field of the user in one query. A profile read in the last moments is used again without a query, unless this
+ *  administrator has changed the user since.
+*/
+optional<userProfile> administrator::getUserProfile(string username) {
+    const userProfile *cached = findCachedProfile(username);
+    if (cached != nullptr) {
+        return *cached;
+    }
+
+    optional<userProfile> profile = db.queryRow<userProfile>("SELECT userID, username, name, creditScore, loanDebt, userType FROM users " \
+                                                             "WHERE username = ?;", username);
+    if (profile) {
+        cacheProfile(*profile);
+    }
+    return profile;
+}
+
+/** @brief Gets everything about several users.
+ *  @param usernames The usernames of the users.
+ *  @return Returns each user's profile, in the order of usernames, or nothing for users that do not exist.
+ * 
+ *  Every user without a recent profile is read in one query, which is given the usernames as a JSON array.
+*/
+vector<optional<userProfile>> administrator::getUserProfiles(const vector<string> &usernames) {
+    vector<optional<userProfile>> result(usernames.size());
+    string missing = "[";
+    for (size_t i = 0; i < usernames.size(); i++) {
+        const userProfile *cached = findCachedProfile(usernames[i]);
+        if (cached != nullptr) {
+            result[i] = *cached;
+            continue;
+        }
+        if (missing.size() > 1) {
+            missing += ',';
+        }
+        missing += '"';
+        for (unsigned char c : usernames[i]) {
+            if (c == '"' || c == '\\') {
+                missing += '\\';
+                missing += (char)c;
+            } else if (c < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                missing += escaped;
+            } else {
+                missing += (char)c;
+            }
+        }
+        missing += '"';
+    }
+    missing += ']';
+
+    if (missing.size() > 2) {
+        unordered_map<string, userProfile> read;
+        db.forEach<userProfile>("SELECT userID, username, name, creditScore, loanDebt, userType FROM users " \
+                                "WHERE username IN (SELECT value FROM json_each(?));",
+                                [&](const userProfile &profile) {
+                                    cacheProfile(profile);
+                                    read[profile.username] = profile;
+                                }, missing);
+        for (size_t i = 0; i < usernames.size(); i++) {
+            unordered_map<string, userProfile>::iterator found = read.find(usernames[i]);
+            if (!result[i] && found != read.end()) {
+                result[i] = found->second;
+            }
+        }
     }
-    return true;
+    return result;
 }
 
 /** @brief Gets the name of a given user.
  *  @param username The username we are getting the name for.
  *  @return Returns the name of the user, or an empty string if the user does not exist.
  * 
- *  Searches through the database to find the name of a user with a given username.
+ *  Reads the name from the user's profile.
 */
 string administrator::getName(string username) {
-    sqlite3_stmt* stmt;
-    if (userExists(username)) {
-        sql = "SELECT name FROM users WHERE username = \"" + username + "\";";
-        sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-        step = sqlite3_step(stmt);
-        user = string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
-        sqlite3_finalize(stmt);
-        return user;
-    }
-    return "";
+    optional<userProfile> profile = getUserProfile(username);
+    return profile ? profile->name : "";
 }
 
 /** @brief Gets the credit score of a given user.
  *  @param username The username we are getting the credit score for.
  *  @return Returns the credit score of the user, or -1 if the user does not exist.
  * 
- *  Searches through the database to find the credit score of a user with a given username.
+ *  Reads the credit score from the user's profile.
 */
 int administrator::getUserCreditScore(string username) {
-    sqlite3_stmt* stmt;
-    if (userExists(username)) {
-        sql = "SELECT creditScore FROM users WHERE username = \"" + username + "\";";
-        sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-        step = sqlite3_step(stmt);
-        int creditScore = (sqlite3_column_int(stmt, 0));
-        sqlite3_finalize(stmt);
-        return creditScore;
-    }
-    return -1;
+    optional<userProfile> profile = getUserProfile(username);
+    return profile ? profile->creditScore : -1;
 }  
 
 /** @brief Gets the loan debt of a given user.
  *  @param username The username we are getting the loan debt for.
  *  @return Returns the loan debt of the user, or -1 if the user does not exist.
  * 
- *  Searches through the database to find the loan debt of a user with a given username.
+ *  Reads the loan debt from the user's profile.
 */
 double administrator::getUserLoanDebt(string username) {
-    sqlite3_stmt* stmt;
-    if (userExists(username)) {
-        sql = "SELECT loanDebt FROM users WHERE username = \"" + username + "\";";
-        sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-        step = sqlite3_step(stmt);
-        double loanDebt = (sqlite3_column_double(stmt, 0));
-        sqlite3_finalize(stmt);
-        return loanDebt;
-    }
-    return -1;
+    optional<userProfile> profile = getUserProfile(username);
+    return profile ? profile->loanDebt : -1;
 }
 
 /** @brief Gets the user type of a given user.
  *  @param username The username we are getting the user type for.
  *  @return Returns the user type of the user, or an empty string if the user does not exist.
  * 
- *  Searches through the database to find if a user is a "regular" customer or an "admin".
+ *  Reads from the user's profile whether they are a "regular" customer or an "admin".
 */
 string administrator::getUserType(string username) {
-    sqlite3_stmt* stmt;
-    if (userExists(username)) {
-        sql = "SELECT userType FROM users WHERE username = \"" + username + "\";";
-        sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-        step = sqlite3_step(stmt);
-        string userType(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
-        sqlite3_finalize(stmt);
-        return userType;
-    }
-    return "";
+    optional<userProfile> profile = getUserProfile(username);
+    return profile ? profile->userType : "";
 }
 
 /** @brief Updates the credit score of a user.
@@ -164,8 +221,19 @@ string administrator::getUserType(string username) {
 */
 void administrator::updateCreditScore(string username, int amount) {
     if (userExists(username)) {
-        sql = "UPDATE users SET creditScore = " + to_string(amount) + " where username = \"" + username + "\";";
-        rc = sqlite3_exec(db, sql.c_str(), callback, 0, &errorMessage);
+        db.exec("BEGIN;");
+        if (!db.run("UPDATE users SET creditScore = ? where username = ?;", amount, username)) {
+            cout << "Could not update credit score: " << db.getError() << endl;
+            db.exec("ROLLBACK;");
+            return;
+        }
+        profiles.erase(username);
+        if (!changeFeed().commit(db, {{changeType::creditScoreChanged, 0, 0, (double)amount, username}})) {
+            return;
+        }
+        if (userChanged) {
+            userChanged(username);
+        }
     }
 }
 
@@ -175,9 +243,42 @@ void administrator::updateCreditScore(string username, int amount) {
  *  Deletes a user from the database if it exists.
 */
 void administrator::removeUser(string username) {
-    if (userExists(username)) {
-        sql = "DELETE FROM users WHERE username = \"" + username + "\";";
-        rc = sqlite3_exec(db, sql.c_str(), callback, 0, &errorMessage);
+    int userID = userIDs().find(db, username);
+    if (userID >= 0) {
+        // Foreign keys are turned off so deleting the user doesn't cascade through every transaction. The user's accounts are queued
+        // instead, and accountPurger detaches their journal entries in small batches.
+        createPurgeQueue(db);
+        db.exec("PRAGMA foreign_keys = OFF;");
+        // Each of the user's accounts is published as closed, along with the user
+        struct closedAccount {
+            int accountID;
+            static auto columns() { return make_tuple(&closedAccount::accountID); }
+        };
+        vector<changeEvent> removed;
+        db.exec("BEGIN;");
+        bool ok = db.forEach<closedAccount>("SELECT accountID FROM accounts WHERE userID = ?;", [&](const closedAccount &row) {
+                      removed.push_back({changeType::accountClosed, row.accountID, 0, 0, username});
+                  }, userID) &&
+                  db.run("INSERT OR IGNORE INTO purgeQueue (accountID) SELECT accountID FROM accounts WHERE userID = ?;", userID) &&
+                  db.run("DELETE FROM accounts WHERE userID = ?;", userID) &&
+                  db.run("DELETE FROM users WHERE userID = ?;", userID);
+        if (ok) {
+            removed.push_back({changeType::userRemoved, 0, 0, 0, username});
+            ok = changeFeed().commit(db, removed);
+        } else {
+            cout << "Could not remove user: " << db.getError() << endl;
+            db.exec("ROLLBACK;");
+        }
+        db.exec("PRAGMA foreign_keys = ON;");
+        if (!ok) {
+            return;
+        }
+        // The username can be signed up again, under a new ID
+        userIDs().forget(username);
+        profiles.erase(username);
+        if (userChanged) {
+            userChanged(username);
+        }
     } else {
         cout << "USER DOESN'T EXIST" << endl;
     }
@@ -185,27 +286,46 @@ void administrator::removeUser(string username) {
 
 /** @brief Grants a loan to a user.
  *  @param accountID The unique ID of the user's account we wish to add money to.
- *  @param amount The amount of money we wish to add to the account.
+ *  @param amount The amount of money we wish to add to the account, in the account's currency.
  * 
  *  Adds money to a user's account while also increasing their loan debt by the same amount.
 */
 void administrator::giveLoan(int accountID, double amount) {
-    sqlite3_stmt* stmt;
-    if (accountExists(accountID)) {
-        // Adding to the balance of the account.
-        sql = "update accounts set balance = balance + " + to_string(amount) + " where accountID = " + to_string(accountID) + ";";
-        rc = sqlite3_exec(db, sql.c_str(), callback, 0, &errorMessage);
-
-        // Finding the owner of the account
-        sql = "select username from accounts where accountID = " + to_string(accountID) + ";";
-        sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-        step = sqlite3_step(stmt);
-        string username(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
-        sqlite3_finalize(stmt);
-
-        // Increasing the loan debt on the account
-        sql = "update users set loanDebt = loanDebt + " + to_string(amount) + " where username = " + username + ";";
-        rc = sqlite3_exec(db, sql.c_str(), callback, 0, &errorMessage);
+    // Finding the owner of the account, and the currency it is held in
+    struct ownerRow {
+        int userID;
+        string username;
+        string currency;
+        static auto columns() { return make_tuple(&ownerRow::userID, &ownerRow::username, &ownerRow::currency); }
+    };
+    optional<ownerRow> owner = db.queryRow<ownerRow>("select u.userID, u.username, a.currency from accounts as a, users as u " \
+                                                     "where a.accountID = ? and u.userID = a.userID;", accountID);
+    if (owner) {
+        string username = owner->username;
+
+        // Loan debt is kept in the base currency
+        double debt;
+        if (!currencyRates().current()->convert(amount, owner->currency, baseCurrency, debt)) {
+            cout << "No exchange rate for " << owner->currency << endl;
+            return;
+        }
+
+        // Posting the loan from the bank's loan account to the account, and increasing the loan debt of its owner, together.
+        db.exec("BEGIN;");
+        bool ok = postEntry(db, "loan", loanAccountID, accountID, debt, amount) >= 0 &&
+                  db.run("update users set loanDebt = loanDebt + ? where userID = ?;", debt, owner->userID);
+        if (!ok) {
+            cout << "Could not give loan: " << db.getError() << endl;
+            db.exec("ROLLBACK;");
+            return;
+        }
+        profiles.erase(username);
+        if (!changeFeed().commit(db, {{changeType::loanGiven, accountID, 0, amount, username}})) {
+            return;
+        }
+        if (userChanged) {
+            userChanged(username);
+        }
     }
 }
 
@@ -218,9 +338,15 @@ void administrator::giveLoan(int accountID, double amount) {
 */
 void administrator::createUser(string name, string username, string password) {
     if (!userExists(username)) {
-        sql = "insert or ignore into users " \
+        db.exec("BEGIN;");
+        if (db.run("insert or ignore into users " \
         "(username, password, name, userType) values " \
-        "(\"" + username + "\",\"" + password + "\",\"" + name + "\",\"regular\");";
-        rc = sqlite3_exec(db, sql.c_str(), callback, 0, &errorMessage);
+        "(?, ?, ?, \"regular\");", username, password, name) && db.changes() == 1) {
+            if (changeFeed().commit(db, {{changeType::userCreated, 0, 0, 0, username}})) {
+                profiles.erase(username);
+            }
+        } else {
+            db.exec("ROLLBACK;");
+        }
     }
 }
@@ -11,33 +11,82 @@
 #include "analytics.h"
 using namespace std;
 
-/** @brief Helps with executing sql.
- *  @param unused This variable is not used and serves no purpose.
- *  @param numColumns The number of columns in the table.
- *  @param value List of the values from the current row from each column.
- *  @param columns Name of each column in the table.
- *  @return Always returns to fit the base necessities.
+/** @brief Opens the database.
+ *  @param resource The memory each call's working lists are allocated from, such as a request's arena.
+ *  @param config The settings the database is opened with.
+ *  
+ *  Constructor that opens the database used to obtain information from. With the default write-ahead logging journal mode, analytics
+ *  reads run on a snapshot and never block, or get blocked by, accounts and customers writing at the same time. The connection is
+ *  then made read-only, since analytics never writes.
+*/
+analytics::analytics(pmr::memory_resource *resource, const bankConfig &config)
+    : resource(resource) {
+    inSnapshot = false;
+	// opens the database file with the configured pragmas, returns an error if it fails
+    config.open(db);
+    addUserIDs(db);
+    createLedger(db);
+    db.exec("PRAGMA query_only = ON;");
+}
+
+/** @brief Closes the database.
  * 
- *  This function is used when executing sql statements.
-*/  
-static int callback(void *unused, int numColumns, char **value, char **columns) {
-    for (int i = 0; i < numColumns; i++) {
-        cout << "Name = " << columns[i] << "   Value = " << value[i] << endl;
-        }
-    return 0;
+ *  Ends any snapshot that is still open and closes the database.
+*/
+analytics::~analytics() {
+    endSnapshot();
 }
 
-/** @brief Opens the database.
- *  
- *  Constructor that opens the database used to obtain information from.
+/** @brief Starts a snapshot.
+ *  @return Returns true if a snapshot is open, and false if one could not be started.
+ * 
+ *  Opens a read transaction and reads from it straight away, which fixes the point in time it sees. Every figure asked for until
+ *  endSnapshot is called comes from that same point in time, no matter what is written to the database in the meantime.
 */
-analytics::analytics() {
-    errorMessage = 0;
-	// opens the database file, returns an error if it fails
-    rc = sqlite3_open("bankDatabase.db", &db);
-    if (rc) {
-        cout << "Can't open database" << endl;
-	}
+bool analytics::beginSnapshot() {
+    if (inSnapshot) {
+        return true;
+    }
+    // A deferred transaction only takes its snapshot on its first read
+    if (!db.exec("BEGIN;") || !db.queryValue<int>("SELECT COUNT(*) FROM sqlite_master;")) {
+        cout << "Can't start snapshot: " << db.getError() << endl;
+        db.exec("ROLLBACK;");
+        return false;
+    }
+    inSnapshot = true;
+    return true;
+}
+
+/** @brief Ends the current snapshot.
+ * 
+ *  Closes the read transaction started by beginSnapshot, so the next figures see the latest data.
+*/
+void analytics::endSnapshot() {
+    if (inSnapshot) {
+        db.exec("COMMIT;");
+        inSnapshot = false;
+    }
+}
+
+/** @brief Opens a snapshot for a single figure.
+ *  @return Returns true if this call started the snapshot, and false if one was already open or could not be started.
+ * 
+ *  Used by figures that run more than one query, so that all of their queries read the same point in time.
+*/
+bool analytics::openSnapshot() {
+    if (inSnapshot) {
+        return false;
+    }
+    return beginSnapshot();
+}
+
+/** @brief Closes a snapshot opened for a single figure.
+ *  @param started Whether the matching call to openSnapshot started the snapshot.
+*/
+void analytics::closeSnapshot(bool started) {
+    if (started) {
+        endSnapshot();
+    }
 }
 
 /** @brief Checks if a user exists. 
@@ -47,16 +96,7 @@ analytics::analytics() {
  *  Searches through the users table in the database for the given username.
 */
 bool analytics::userExists(string username) {
-    sql = "SELECT EXISTS(SELECT 1 FROM users WHERE username = \"" + username + "\");";
-    sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-    step = sqlite3_step(stmt);
-    empty = (sqlite3_column_int(stmt,0));
-    sqlite3_finalize(stmt);
-    if (empty == 0) {
-        return false;
-    }
-    return true;
+    return db.queryValue<int>("SELECT EXISTS(SELECT 1 FROM users WHERE username = ?);", username).value_or(0) == 1;
 }
 
 /** @brief Gets the number of users
@@ -65,65 +105,42 @@ bool analytics::userExists(string username) {
  *  Goes through the users table in the database and checks how many rows (users) there are.
 */
 int analytics::getNumUsers() {
-    sql = "SELECT COUNT(*) FROM users WHERE userType=\"regular\";";
-    sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-    step = sqlite3_step(stmt);
-    int numUsers = (sqlite3_column_int(stmt, 0));
-    sqlite3_finalize(stmt);
-    return numUsers;
+    return db.queryValue<int>("SELECT COUNT(*) FROM users WHERE userType=\"regular\";").value_or(0);
 }
 
 /** @brief Gets the balance of a user.
  *  @param username The username of the user we wish to check the balance of.
- *  @return The total balance of the user.
+ *  @return The total balance of the user, 0 if they have no accounts, or -1 if the user does not exist.
  * 
- * Goes through all of the given user's accounts and totals up the balance.
+ * Goes through all of the given user's accounts and totals up the balance in each currency, then converts the totals to the base
+ * currency together.
 */
 double analytics::getBalance(string username) {
-    sqlite3_stmt* stmt;
-    if (userExists(username)) {
-        double totalBalance = 0;
-        sql = "SELECT COUNT(*) FROM accounts WHERE username = \"" + username + "\");";
-        sql = "SELECT EXISTS(SELECT 1 FROM accounts WHERE username = \"" + username + "\");";
-        sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-        step = sqlite3_step(stmt);
-        int empty = (sqlite3_column_int(stmt,0));
-        sqlite3_finalize(stmt);
-        if (empty == 0) {
-            return 0.00;
-        }
-
-        sql = "SELECT balance FROM accounts WHERE username = \"" + username + "\";";
-        sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-        step = sqlite3_step(stmt);
-        while (step == 100) {
-            totalBalance += (sqlite3_column_double(stmt,0));
-            step = sqlite3_step(stmt);
-        }
-        sqlite3_finalize(stmt);
-        return totalBalance;
+    bool started = openSnapshot();
+    double totalBalance = -1;
+    int userID = userIDs().find(db, username);
+    if (userID >= 0) {
+        pmr::vector<currencyAmount> totals(resource);
+        db.forEach<currencyAmount>("SELECT currency, SUM(balance) FROM accounts WHERE userID = ? GROUP BY currency;",
+                                   [&](const currencyAmount &row) { totals.push_back(row); }, userID);
+        totalBalance = 0;
+        currencyRates().current()->total(totals, baseCurrency, totalBalance);
     }
-    return -1;
+    closeSnapshot(started);
+    return totalBalance;
 }
 
 /** @brief Calculates the average balance.
  *  
- *  Looks at every user's total balance and calculates the average of those numbers.
+ *  Totals the balance of every account owned by a regular user in one scan, one total per currency, and converts the totals to the
+ *  base currency together. Then divides by the number of users to get the average of every user's total balance.
 */  
 void analytics::calculateAverageBalance() {
-    string username = "";
-    sql = "SELECT username FROM users WHERE userType = \"regular\";";
-    sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-    step = sqlite3_step(stmt);
+    pmr::vector<currencyAmount> totals(resource);
+    db.forEach<currencyAmount>("SELECT a.currency, SUM(a.balance) FROM accounts AS a, users AS u WHERE a.userID = u.userID AND u.userType = \"regular\" GROUP BY a.currency;",
+                               [&](const currencyAmount &row) { totals.push_back(row); });
     averageBalance = 0;
-    while (step == SQLITE_ROW) {
-        username = (reinterpret_cast<char const*>(sqlite3_column_text(stmt,0)));
-        averageBalance += this->getBalance(username);
-        step = sqlite3_step(stmt);
-    }
-    sqlite3_finalize(stmt);
+    currencyRates().current()->total(totals, baseCurrency, averageBalance);
     averageBalance = averageBalance / this->getNumUsers();
 }
 
@@ -132,16 +149,7 @@ void analytics::calculateAverageBalance() {
  *  Totals the credit score of all regular users, then divides by the number of users to get the average credit score.
 */
 void analytics::calculateAverageCreditScore() {
-    sql = "SELECT creditScore FROM users WHERE userType = \"regular\";";
-    sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-    step = sqlite3_step(stmt);
-    averageCredit = 0;
-    while (step == 100) {
-        averageCredit += (sqlite3_column_int(stmt, 0));
-        step = sqlite3_step(stmt);
-    }
-    sqlite3_finalize(stmt);
+    averageCredit = db.queryValue<double>("SELECT SUM(creditScore) FROM users WHERE userType = \"regular\";").value_or(0);
     averageCredit = averageCredit / this->getNumUsers();
 }
 
@@ -151,7 +159,9 @@ void analytics::calculateAverageCreditScore() {
  *  Getter function to give the average balance between all users rounded to two decimal places.
 */
 double analytics::getAverageBalance() {
+    bool started = openSnapshot();
     calculateAverageBalance();
+    closeSnapshot(started);
     return floor(averageBalance * 100.00) / 100.00;
 }
 
@@ -161,22 +171,28 @@ double analytics::getAverageBalance() {
  *  Getter function to give the average credit between all users.
 */
 double analytics::getAverageCreditScore() {
+    bool started = openSnapshot();
     calculateAverageCreditScore();
+    closeSnapshot(started);
     return averageCredit;
 }
 
 /** @brief Gets the number of transactions.
  *  @return The total number of transactions.
  * 
- *  Looks through the transactions table in the database and counts the number of rows, equal to the number of transactions. 
+ *  Looks through the journal in the database and counts its entries, one for each transaction, plus the entries already moved out of
+ *  it into sealed months. 
 */
 int analytics::getNumTransactions() {
-    sql = "SELECT COUNT(*) FROM transactions;";
-    sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-    step = sqlite3_step(stmt);
-    totalTransactions = sqlite3_column_double(stmt,0);
-    sqlite3_finalize(stmt);
+    // Both counts come from one snapshot, so a month sealed in between isn't counted twice or missed
+    bool started = openSnapshot();
+    totalTransactions = db.queryValue<int>("SELECT COUNT(*) FROM journal;").value_or(0);
+
+    // Adds the entries sealed into monthly files, if any month has ever been sealed
+    if (db.queryValue<int>("SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = 'partitions';").value_or(0) == 1) {
+        totalTransactions += db.queryValue<int>("SELECT COALESCE(SUM(rows), 0) FROM partitions;").value_or(0);
+    }
+    closeSnapshot(started);
     return totalTransactions;
 }
 
@@ -187,14 +203,5 @@ int analytics::getNumTransactions() {
  *  Looks through the users table in the database for the user's credit score given their username.
 */
 int analytics::getCreditScore(string username) {
-    sqlite3_stmt* stmt;
-    if (userExists(username)) {
-        sql = "SELECT creditScore FROM users WHERE username = \"" + username + "\";";
-        sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-        step = sqlite3_step(stmt);
-        double creditScore = (sqlite3_column_int(stmt,0));
-        sqlite3_finalize(stmt);
-        return creditScore;
-    }
-    return -1;
+    return db.queryValue<int>("SELECT creditScore FROM users WHERE username = ?;", username).value_or(-1);
 }
@@ -0,0 +1,349 @@
+/** @brief Coroutine versions of the bank's operations.
+ *
+ *  This class gives each blocking operation of account, customer, budgeting, administrator and analytics a coroutine that returns a task.
+ *  The SQLite work runs on the class's I/O pool, and the coroutine picks up again on the front-end thread once it is done, so a single
+ *  thread can keep thousands of requests in flight. Messages are printed on the front-end thread, never from the pool.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file asyncBank.cpp
+ *  @class asyncBank "../include/asyncBank.h"
+ */
+
+#include "asyncBank.h"
+
+using namespace std;
+
+/** @brief Starts the I/O pool
+ *
+ *  Gives the accounts table its currency column, keys users by userID, and creates the journal and idempotency keys, first if they don't
+ *  exist yet.
+ *  @param config Represents the settings the pool's connections are opened with, and the number of I/O threads, each with its own connection
+ */
+asyncBank::asyncBank(const bankConfig &config)
+	: pool(config)
+{
+	// The pool's connections may be setting up the file at the same time, which the busy timeout waits out
+	database db;
+	config.open(db);
+	addUserIDs(db);
+	createLedger(db);
+	createIdempotencyKeys(db);
+}
+
+/** @brief Returns the username of an account's owner
+ *
+ *  @param db Represents the pool connection
+ *  @param accountID Represents the account
+ *  @return returns the owner's username, or an empty string if the account doesn't exist
+ */
+static string ownerOf(database &db, int accountID)
+{
+	return db.queryValue<string>("SELECT u.username FROM accounts AS a, users AS u WHERE a.accountID = ? AND u.userID = a.userID;", accountID)
+		.value_or("");
+}
+
+/** @brief Claims a call's idempotency key and commits the call
+ *
+ *  The commit goes through the change log, like the same operation on account or customer.
+ *  @param db Represents the pool connection, inside the call's database transaction
+ *  @param idempotencyKey Represents the key, or an empty string
+ *  @param call Represents the call
+ *  @param entryID Represents the journal entry the call posted
+ *  @param change Represents the write the call made, as it is recorded in the change log
+ *  @return returns nullptr if the call committed, or the message to print if it was rolled back
+ */
+static const char *commitWithKey(database &db, string_view idempotencyKey, const idempotentCall &call, long long entryID, const changeEvent &change)
+{
+	idempotencyResult claimed = idempotencyKeys().claim(db, idempotencyKey, call, entryID);
+	if (claimed != idempotencyResult::fresh)
+	{
+		db.exec("ROLLBACK;");
+		return idempotencyFailure(claimed);
+	}
+	if (!changeFeed().commit(db, {change}))
+	{
+		return "Could not commit.";
+	}
+	idempotencyKeys().remember(idempotencyKey, call, entryID);
+	return nullptr;
+}
+
+/** @brief Returns the I/O pool
+ *
+ *  @return returns the pool the tasks run on, for waiting on them
+ */
+ioPool &asyncBank::getPool()
+{
+	return pool;
+}
+
+/** @brief Returns the balance of an account
+ *
+ *  @param accountID Represents the account
+ *  @return returns a task giving the account's balance, or 0 if it doesn't exist
+ */
+task<double> asyncBank::getBalanceAsync(int accountID)
+{
+	auto work = pool.run([accountID](database &db)
+						 { return db.queryValue<double>("SELECT balance FROM accounts WHERE accountID = ?;", accountID).value_or(0); });
+	co_return co_await work;
+}
+
+/** @brief Deposits money into an account
+ *
+ *  @param accountID Represents the account
+ *  @param amount Represents the amount deposited
+ *  @param idempotencyKey Represents a key chosen by the client, so a retry with the same key doesn't deposit again, or an empty string
+ *  @return returns a task giving true if the deposit was made, now or by an earlier call with the key, false otherwise
+ */
+task<bool> asyncBank::depositAsync(int accountID, double amount, string idempotencyKey)
+{
+	// The work returns nullptr on success, or the message to print on the front-end thread
+	auto deposit = pool.run([accountID, amount, idempotencyKey](database &db) -> const char *
+							{
+								idempotentCall call{"deposit", accountID, 0, amount};
+								db.exec("BEGIN IMMEDIATE;");
+								idempotencyResult earlier = idempotencyKeys().check(db, idempotencyKey, call);
+								if (earlier != idempotencyResult::fresh)
+								{
+									db.exec("ROLLBACK;");
+									return idempotencyFailure(earlier);
+								}
+								long long entryID = postEntry(db, "deposit", cashAccountID, accountID, amount);
+								if (entryID < 0)
+								{
+									db.exec("ROLLBACK;");
+									return "Could not deposit.";
+								}
+								return commitWithKey(db, idempotencyKey, call, entryID, {changeType::deposit, accountID, 0, amount, ownerOf(db, accountID)});
+							});
+	const char *failure = co_await deposit;
+	if (failure != nullptr)
+	{
+		cout << failure << endl;
+	}
+	co_return failure == nullptr;
+}
+
+/** @brief Withdraws money from an account
+ *
+ *  The balance is checked inside the same database transaction as the withdrawal, so two withdrawals running at once can't overdraw it.
+ *  @param accountID Represents the account
+ *  @param amount Represents the amount withdrawn
+ *  @param idempotencyKey Represents a key chosen by the client, so a retry with the same key doesn't withdraw again, or an empty string
+ *  @return returns a task giving true if the withdrawal was made, now or by an earlier call with the key, false if there weren't enough
+ *  funds
+ */
+task<bool> asyncBank::withdrawAsync(int accountID, double amount, string idempotencyKey)
+{
+	auto withdrawal = pool.run([accountID, amount, idempotencyKey](database &db) -> const char *
+							   {
+								   idempotentCall call{"withdraw", accountID, 0, amount};
+								   db.exec("BEGIN IMMEDIATE;");
+								   idempotencyResult earlier = idempotencyKeys().check(db, idempotencyKey, call);
+								   if (earlier != idempotencyResult::fresh)
+								   {
+									   db.exec("ROLLBACK;");
+									   return idempotencyFailure(earlier);
+								   }
+								   double balance = db.queryValue<double>("SELECT balance FROM accounts WHERE accountID = ?;", accountID).value_or(0) -
+													authorizationHolds().held(db, accountID);
+								   long long entryID = balance >= amount ? postEntry(db, "withdraw", accountID, cashAccountID, amount) : -1;
+								   if (entryID < 0)
+								   {
+									   db.exec("ROLLBACK;");
+									   return "Not Enough Funds!";
+								   }
+								   return commitWithKey(db, idempotencyKey, call, entryID, {changeType::withdraw, accountID, 0, amount, ownerOf(db, accountID)});
+							   });
+	const char *failure = co_await withdrawal;
+	if (failure != nullptr)
+	{
+		cout << failure << endl;
+	}
+	co_return failure == nullptr;
+}
+
+/** @brief Returns the total money a customer holds
+ *
+ *  @param username Represents the customer
+ *  @return returns a task giving the sum of the balances of all the customer's accounts, in the base currency
+ */
+task<double> asyncBank::getMoneyAsync(string username)
+{
+	auto work = pool.run([username](database &db)
+						 {
+							 vector<currencyAmount> totals;
+							 db.forEach<currencyAmount>("SELECT currency, SUM(balance) FROM accounts WHERE userID = ? GROUP BY currency;", [&](const currencyAmount &row)
+														{ totals.push_back(row); }, userIDs().find(db, username));
+							 double money = 0;
+							 currencyRates().current()->total(totals, baseCurrency, money);
+							 return money;
+						 });
+	co_return co_await work;
+}
+
+/** @brief Sends money from one of a customer's accounts to another account
+ *
+ *  Checks the same things as customer::transaction, but inside the database transaction that makes the transfer, and screens it for fraud
+ *  the same way. A held transfer is committed to heldTransfers without being sent.
+ *  @param username Represents the customer sending the money
+ *  @param senderAccountID Represents the account the money is sent from, which must belong to the customer
+ *  @param receiverAccountID Represents the account the money is sent to
+ *  @param amount Represents the amount sent, in the sender account's currency
+ *  @param idempotencyKey Represents a key chosen by the client, so a retry with the same key doesn't send the money again, or an empty
+ *  string
+ *  @return returns a task giving true if the transfer was made, now or by an earlier call with the key, false otherwise
+ */
+task<bool> asyncBank::transferAsync(string username, int senderAccountID, int receiverAccountID, double amount, string idempotencyKey)
+{
+	// The work returns nullptr on success, or the message to print on the front-end thread
+	auto transfer = pool.run([username, senderAccountID, receiverAccountID, amount, idempotencyKey](database &db) -> const char *
+							 {
+								 idempotentCall call{"transfer", senderAccountID, receiverAccountID, amount};
+								 db.exec("BEGIN IMMEDIATE;");
+								 optional<int> owner = db.queryValue<int>("SELECT userID FROM accounts WHERE accountID = ?;", senderAccountID);
+								 optional<string> senderCurrency = db.queryValue<string>("SELECT currency FROM accounts WHERE accountID = ?;", senderAccountID);
+								 optional<string> receiverCurrency = db.queryValue<string>("SELECT currency FROM accounts WHERE accountID = ?;", receiverAccountID);
+								 double received = 0;
+								 long long entryID = -1;
+								 fraudDecision decision = fraudDecision::allow;
+								 bool replayed = false;
+								 const char *message = nullptr;
+								 if (!owner || *owner != userIDs().find(db, username))
+								 {
+									 message = "This account doesn't belong to you!";
+								 }
+								 else if (idempotencyResult earlier = idempotencyKeys().check(db, idempotencyKey, call); earlier != idempotencyResult::fresh)
+								 {
+									 message = idempotencyFailure(earlier);
+									 replayed = message == nullptr;
+								 }
+								 else if (db.queryValue<double>("SELECT balance FROM accounts WHERE accountID = ?;", senderAccountID).value_or(0) -
+											  authorizationHolds().held(db, senderAccountID) <
+										  amount)
+								 {
+									 message = "Not enough funds remaining.";
+								 }
+								 else if (!receiverCurrency)
+								 {
+									 message = "This account doesn't exist!";
+								 }
+								 else if (!currencyRates().current()->convert(amount, *senderCurrency, *receiverCurrency, received))
+								 {
+									 message = "There is no exchange rate for this account's currency.";
+								 }
+								 else if ((decision = screenTransfer(db, senderAccountID, receiverAccountID, amount)) != fraudDecision::allow)
+								 {
+									 message = decision == fraudDecision::hold ? "Transaction Held For Review." : "Transaction Rejected.";
+								 }
+								 else if ((entryID = postEntry(db, "transfer", senderAccountID, receiverAccountID, amount, received)) < 0)
+								 {
+									 message = "Transaction Failed.";
+								 }
+								 if (decision == fraudDecision::hold)
+								 {
+									 if (db.exec("COMMIT;"))
+									 {
+										 return message;
+									 }
+									 message = "Transaction Failed.";
+								 }
+								 if (message != nullptr || replayed)
+								 {
+									 db.exec("ROLLBACK;");
+									 return message;
+								 }
+								 return commitWithKey(db, idempotencyKey, call, entryID, {changeType::transfer, senderAccountID, receiverAccountID, amount, username});
+							 });
+	const char *failure = co_await transfer;
+
+	cout << (failure != nullptr ? failure : "Transaction Completed.") << endl;
+	co_return failure == nullptr;
+}
+
+/** @brief Returns the total a customer has spent
+ *
+ *  @param username Represents the customer
+ *  @return returns a task giving the total of the journal entries taking money from the customer's accounts
+ */
+task<double> asyncBank::getSpendingAsync(string username)
+{
+	auto work = pool.run([username](database &db)
+						 {
+							 return db.queryValue<double>("SELECT SUM(j.amount) FROM accounts AS a, journal AS j WHERE a.accountID = j.debitAccountID AND a.userID = ?;",
+														  userIDs().find(db, username))
+								 .value_or(0);
+						 });
+	co_return co_await work;
+}
+
+/** @brief Returns the total a customer has gained
+ *
+ *  @param username Represents the customer
+ *  @return returns a task giving the total of the journal entries giving money to the customer's accounts
+ */
+task<double> asyncBank::getGainedAsync(string username)
+{
+	auto work = pool.run([username](database &db)
+						 {
+							 return db.queryValue<double>("SELECT SUM(j.creditAmount) FROM accounts AS a, journal AS j WHERE a.accountID = j.creditAccountID AND a.userID = ?;",
+														  userIDs().find(db, username))
+								 .value_or(0);
+						 });
+	co_return co_await work;
+}
+
+/** @brief Returns a user's credit score
+ *
+ *  @param username Represents the user
+ *  @return returns a task giving the user's credit score, or -1 if the user doesn't exist
+ */
+task<int> asyncBank::getCreditScoreAsync(string username)
+{
+	auto work = pool.run([username](database &db)
+						 { return db.queryValue<int>("SELECT creditScore FROM users WHERE username = ?;", username).value_or(-1); });
+	co_return co_await work;
+}
+
+/** @brief Updates a user's credit score
+ *
+ *  The update is committed through the change log, like administrator::updateCreditScore.
+ *  @param username Represents the user
+ *  @param creditScore Represents the new credit score
+ *  @return returns a task giving true if the user exists and was updated, false otherwise
+ */
+task<bool> asyncBank::updateCreditScoreAsync(string username, int creditScore)
+{
+	auto work = pool.run([username, creditScore](database &db)
+						 {
+							 db.exec("BEGIN IMMEDIATE;");
+							 if (!db.run("UPDATE users SET creditScore = ? WHERE username = ?;", creditScore, username) || db.changes() != 1)
+							 {
+								 db.exec("ROLLBACK;");
+								 return false;
+							 }
+							 return changeFeed().commit(db, {{changeType::creditScoreChanged, 0, 0, (double)creditScore, username}});
+						 });
+	co_return co_await work;
+}
+
+/** @brief Returns the average balance of the regular users
+ *
+ *  @return returns a task giving the total balance of every regular user's accounts divided by the number of regular users
+ */
+task<double> asyncBank::getAverageBalanceAsync()
+{
+	auto work = pool.run([](database &db)
+						 {
+							 db.exec("BEGIN;");
+							 vector<currencyAmount> totals;
+							 db.forEach<currencyAmount>("SELECT a.currency, SUM(a.balance) FROM accounts AS a, users AS u WHERE a.userID = u.userID AND u.userType = \"regular\" GROUP BY a.currency;", [&](const currencyAmount &row)
+														{ totals.push_back(row); });
+							 double total = 0;
+							 currencyRates().current()->total(totals, baseCurrency, total);
+							 int numUsers = db.queryValue<int>("SELECT COUNT(*) FROM users WHERE userType = \"regular\";").value_or(0);
+							 db.exec("COMMIT;");
+							 return numUsers > 0 ? total / numUsers : 0.0;
+						 });
+	co_return co_await work;
+}
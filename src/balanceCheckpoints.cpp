@@ -0,0 +1,267 @@
+/** @brief Keeps end of day balances, so the balance of an account at a past time is read without replaying its history.
+ *
+ *  A checkpointWriter, started with the program's other background workers, writes them when it starts and then once a day, just
+ *  after midnight UTC. It works backward from the balances in the accounts table: the balance at
+ *  the end of a day is the current balance less every journal entry posted since. All accounts are written by one statement per day,
+ *  inside one database transaction, so nothing can be posted between reading the balances and reading the entries. Days missed since
+ *  the last run are filled in from the newer day's checkpoint and the one day of entries between them.
+ *
+ *  A past balance then starts from the nearest checkpoint before it and adds the entries up to the time asked for, which is less than
+ *  a day of them. Before the first checkpoint, it works backward from the first one, or from the current balance if there is none.
+ *  Accounts are opened with their balance and no journal entry, so an account's balance before it was opened reads as its opening
+ *  balance.
+ *
+ *  Entries in months sealed out of the journal can't be read by either. Sealing a month after its days are checkpointed keeps their
+ *  end of day balances, but a time within one of those days can't be answered.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file balanceCheckpoints.cpp
+ */
+
+#include <ctime>
+#include "balanceCheckpoints.h"
+
+using namespace std;
+
+// Each account's balance change in a range of entry times: credits in the account's currency less debits. ?2 is the first time in
+// the range and ?3 the time after it.
+static const string changesInRange = "SELECT accountID, SUM(change) AS change FROM ("
+									 "SELECT creditAccountID AS accountID, creditAmount AS change FROM journal WHERE entryTime >= ?2 AND entryTime < ?3 "
+									 "UNION ALL "
+									 "SELECT debitAccountID, -amount FROM journal WHERE entryTime >= ?2 AND entryTime < ?3) "
+									 "GROUP BY accountID";
+
+// One account's balance change in the same range, with the account as ?1
+static const string accountChangeInRange = "SELECT COALESCE(SUM(CASE WHEN creditAccountID = ?1 THEN creditAmount ELSE 0 END) - "
+										   "SUM(CASE WHEN debitAccountID = ?1 THEN amount ELSE 0 END), 0) FROM journal "
+										   "WHERE (debitAccountID = ?1 OR creditAccountID = ?1) AND entryTime >= ?2 AND entryTime < ?3";
+
+static const string endOfTime = "9999-12-31";
+
+struct checkpoint
+{
+	string day;
+	double balance;
+	static auto columns() { return make_tuple(&checkpoint::day, &checkpoint::balance); }
+};
+
+/** @brief Moves a day forward or back
+ *
+ *  @param day Represents a day, as YYYY-MM-DD
+ *  @param days Represents the number of days to move it by
+ *  @return returns the day moved to, as YYYY-MM-DD
+ */
+static string shiftDay(const string &day, int days)
+{
+	tm date{};
+	date.tm_year = stoi(day.substr(0, 4)) - 1900;
+	date.tm_mon = stoi(day.substr(5, 2)) - 1;
+	date.tm_mday = stoi(day.substr(8, 2)) + days;
+	date.tm_hour = 12;
+	time_t moved = timegm(&date);
+	char result[16];
+	strftime(result, sizeof(result), "%Y-%m-%d", gmtime(&moved));
+	return result;
+}
+
+/** @brief Returns the first day whose entries are all still in the live journal
+ *
+ *  @param db Represents the database the journal is in
+ *  @return returns the first day of the month after the last sealed month, or "" if no month is sealed
+ */
+static string firstLiveDay(database &db)
+{
+	int partitioned = db.queryValue<int>("SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = 'partitions';").value_or(0);
+	if (partitioned == 0)
+	{
+		return "";
+	}
+	string lastSealed = db.queryValue<string>("SELECT COALESCE(MAX(month), '') FROM partitions;").value_or("");
+	return lastSealed.empty() ? "" : shiftDay(lastSealed + "-01", 31).substr(0, 7) + "-01";
+}
+
+/** @brief Creates the table checkpoints are kept in
+ *
+ *  @param db Represents the database the table is created in
+ *  @return returns true if the table exists afterwards
+ */
+bool createBalanceCheckpoints(database &db)
+{
+	return db.exec("create table if not exists balanceCheckpoints ("
+				   "accountID INTEGER NOT NULL, "
+				   "day varchar(10) NOT NULL, "
+				   "balance decimal(15,2) NOT NULL, "
+				   "PRIMARY KEY (accountID, day)) WITHOUT ROWID;") &&
+		   db.exec("create index if not exists balanceCheckpointsByDay on balanceCheckpoints(day);");
+}
+
+/** @brief Writes the end of day balance of every account for each day since the last checkpoint
+ *
+ *  The newest day is worked out from the current balances and the entries posted after it, and each day before it from the day after.
+ *  If there is no checkpoint yet, only throughDay is written. Days whose later entries are partly in sealed months are skipped.
+ *  @param db Represents the database the accounts and journal are in
+ *  @param throughDay Represents the last day written, as YYYY-MM-DD, or "" for yesterday
+ *  @return returns the number of days written, or -1 if they could not be
+ */
+int writeBalanceCheckpoints(database &db, string throughDay)
+{
+	if (throughDay.empty())
+	{
+		time_t yesterday = time(nullptr) - 24 * 60 * 60;
+		char day[16];
+		strftime(day, sizeof(day), "%Y-%m-%d", gmtime(&yesterday)); // entryTime is stored in UTC
+		throughDay = day;
+	}
+	if (!createBalanceCheckpoints(db))
+	{
+		return -1;
+	}
+
+	string lastDay = db.queryValue<string>("SELECT COALESCE(MAX(day), '') FROM balanceCheckpoints;").value_or("");
+	if (!lastDay.empty() && lastDay >= throughDay)
+	{
+		return 0;
+	}
+	string firstDay = lastDay.empty() ? throughDay : shiftDay(lastDay, 1);
+	string liveFrom = firstLiveDay(db);
+	if (!liveFrom.empty())
+	{
+		if (shiftDay(throughDay, 1) < liveFrom)
+		{
+			cout << "Can't checkpoint " << throughDay << ", its month is sealed" << endl;
+			return -1;
+		}
+		firstDay = max(firstDay, shiftDay(liveFrom, -1));
+	}
+
+	if (!db.exec("BEGIN IMMEDIATE;"))
+	{
+		return -1;
+	}
+	bool ok = db.run("INSERT OR REPLACE INTO balanceCheckpoints (accountID, day, balance) "
+					 "SELECT accounts.accountID, ?1, accounts.balance - COALESCE(later.change, 0) FROM accounts "
+					 "LEFT JOIN (" + changesInRange + ") later ON later.accountID = accounts.accountID;",
+					 throughDay, shiftDay(throughDay, 1), endOfTime);
+	int written = 1;
+	for (string day = shiftDay(throughDay, -1); ok && day >= firstDay; day = shiftDay(day, -1))
+	{
+		string nextDay = shiftDay(day, 1);
+		ok = db.run("INSERT OR REPLACE INTO balanceCheckpoints (accountID, day, balance) "
+					"SELECT next.accountID, ?1, next.balance - COALESCE(during.change, 0) FROM balanceCheckpoints next "
+					"LEFT JOIN (" + changesInRange + ") during ON during.accountID = next.accountID WHERE next.day = ?2;",
+					day, nextDay, shiftDay(nextDay, 1));
+		written++;
+	}
+	if (!ok || !db.exec("COMMIT;"))
+	{
+		cout << "Could not write balance checkpoints: " << db.getError() << endl;
+		db.exec("ROLLBACK;");
+		return -1;
+	}
+	return written;
+}
+
+/** @brief Returns an account's balance at a past time
+ *
+ *  @param db Represents the database the checkpoints and journal are in
+ *  @param accountID Represents the account
+ *  @param timestamp Represents the time, as YYYY-MM-DD HH:MM:SS in UTC, or YYYY-MM-DD for the start of that day
+ *  @return returns the balance at that time, or nothing if the account doesn't exist, or the entries needed are in a sealed month
+ */
+optional<double> balanceAsOf(database &db, int accountID, string_view timestamp)
+{
+	string at(timestamp);
+	string day = at.substr(0, 10);
+
+	// The last checkpoint ending at or before the time, otherwise the first one after it
+	optional<checkpoint> before;
+	optional<checkpoint> after;
+	bool read = db.forEach<checkpoint>("SELECT day, balance FROM balanceCheckpoints WHERE accountID = ? AND day < ? ORDER BY day DESC LIMIT 1;",
+									   [&](const checkpoint &row)
+									   { before = row; },
+									   accountID, day) &&
+				(before || db.forEach<checkpoint>("SELECT day, balance FROM balanceCheckpoints WHERE accountID = ? AND day >= ? ORDER BY day LIMIT 1;",
+												  [&](const checkpoint &row)
+												  { after = row; },
+												  accountID, day));
+	if (!read)
+	{
+		cout << "Could not read balance checkpoints: " << db.getError() << endl;
+		return nullopt;
+	}
+
+	string from = before ? shiftDay(before->day, 1) : at;
+	string to = before ? at : after ? shiftDay(after->day, 1) : endOfTime;
+	string liveFrom = firstLiveDay(db);
+	if (from < to && !liveFrom.empty() && from < liveFrom)
+	{
+		cout << "The balance at " << at << " needs entries from a sealed month" << endl;
+		return nullopt;
+	}
+
+	if (before || after)
+	{
+		optional<double> change = db.queryValue<double>(accountChangeInRange + ";", accountID, from, to);
+		if (!change)
+		{
+			return nullopt;
+		}
+		return before ? before->balance + *change : after->balance - *change;
+	}
+	// Read in one statement, so an entry posted meanwhile is counted in both or neither
+	return db.queryValue<double>("SELECT balance - (" + accountChangeInRange + ") FROM accounts WHERE accountID = ?1;", accountID, from, to);
+}
+
+/** @brief Opens the database and starts checkpointing
+ *
+ *  @param config Represents the settings the database is opened with
+ *  @param background Represents whether to start a thread that writes the checkpoints each day. Without one, nothing is written.
+ */
+checkpointWriter::checkpointWriter(const bankConfig &config, bool background)
+{
+	stopping = false;
+
+	config.open(DB);
+	createBalanceCheckpoints(DB);
+
+	if (background)
+	{
+		worker = thread(&checkpointWriter::work, this);
+	}
+}
+
+/** @brief Stops checkpointing
+ *
+ *  Waits for the days being written to finish. Days missed while no writer runs are filled in the next time one starts.
+ */
+checkpointWriter::~checkpointWriter()
+{
+	{
+		lock_guard<mutex> guard(stateLock);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+}
+
+/** @brief Writes the checkpoints up to yesterday, then again a minute after each midnight UTC, until the writer is destroyed
+ *
+ *  A run with nothing new to write only reads the last checkpoint's day.
+ */
+void checkpointWriter::work()
+{
+	unique_lock<mutex> guard(stateLock);
+	while (!stopping)
+	{
+		guard.unlock();
+		writeBalanceCheckpoints(DB);
+		guard.lock();
+
+		time_t now = time(nullptr);
+		time_t nextRun = now - now % (24 * 60 * 60) + 24 * 60 * 60 + 60;
+		wakeUp.wait_until(guard, chrono::system_clock::from_time_t(nextRun), [this]
+						  { return stopping; });
+	}
+}
@@ -0,0 +1,282 @@
+/** @brief Reads the settings the bank runs with
+ *
+ *  Every class that opens the database or sizes a pool, cache or batch takes a bankConfig, so how much durability is traded for
+ *  throughput is decided by each deployment's config file and environment rather than when the program is built.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file bankConfig.cpp
+ *  @class bankConfig "../include/bankConfig.h"
+ */
+
+#include <cstdlib>
+#include <cctype>
+#include <charconv>
+#include <climits>
+#include "bankConfig.h"
+
+using namespace std;
+
+// Every setting, by the name it is given in the config file
+static const pair<const char *, string bankConfig::*> textSettings[] = {
+	{"databasePath", &bankConfig::databasePath},
+	{"journalMode", &bankConfig::journalMode},
+	{"synchronous", &bankConfig::synchronous},
+	{"changeLogDirectory", &bankConfig::changeLogDirectory},
+	{"partitionDirectory", &bankConfig::partitionDirectory},
+	{"ratesPath", &bankConfig::ratesPath},
+};
+static const pair<const char *, long long bankConfig::*> largeSettings[] = {
+	{"cacheSize", &bankConfig::cacheSize},
+	{"mmapSize", &bankConfig::mmapSize},
+	{"changeLogSegmentSize", &bankConfig::changeLogSegmentSize},
+};
+static const pair<const char *, int bankConfig::*> numberSettings[] = {
+	{"busyTimeout", &bankConfig::busyTimeout},
+	{"ioThreads", &bankConfig::ioThreads},
+	{"analyticsThreads", &bankConfig::analyticsThreads},
+	{"filterThreads", &bankConfig::filterThreads},
+	{"sessionCapacity", &bankConfig::sessionCapacity},
+	{"sessionIdleSeconds", &bankConfig::sessionIdleSeconds},
+	{"sessionArenaBytes", &bankConfig::sessionArenaBytes},
+	{"profileCacheSize", &bankConfig::profileCacheSize},
+	{"profileCacheMilliseconds", &bankConfig::profileCacheMilliseconds},
+	{"idempotencyCacheSize", &bankConfig::idempotencyCacheSize},
+	{"idempotencyKeySeconds", &bankConfig::idempotencyKeySeconds},
+	{"purgeBatchSize", &bankConfig::purgeBatchSize},
+	{"purgePauseMilliseconds", &bankConfig::purgePauseMilliseconds},
+	{"purgeIdleMilliseconds", &bankConfig::purgeIdleMilliseconds},
+	{"schedulerHorizon", &bankConfig::schedulerHorizon},
+	{"schedulerBatchSize", &bankConfig::schedulerBatchSize},
+	{"schedulerMaxAttempts", &bankConfig::schedulerMaxAttempts},
+	{"schedulerRetrySeconds", &bankConfig::schedulerRetrySeconds},
+	{"interestChunkSize", &bankConfig::interestChunkSize},
+	{"holdBatchSize", &bankConfig::holdBatchSize},
+	{"holdSeconds", &bankConfig::holdSeconds},
+};
+
+// The values the two text pragmas accept. Pragmas can't take bound parameters, so nothing else is ever put into their SQL.
+static const string_view journalModes[] = {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"};
+static const string_view synchronousModes[] = {"OFF", "NORMAL", "FULL", "EXTRA"};
+
+static string_view trim(string_view text)
+{
+	size_t start = text.find_first_not_of(" \t\r");
+	if (start == string_view::npos)
+	{
+		return {};
+	}
+	size_t end = text.find_last_not_of(" \t\r");
+	return text.substr(start, end - start + 1);
+}
+
+/** @brief Checks a pragma's value against the ones it accepts
+ *
+ *  @param value Represents the value given, in any case
+ *  @param accepted Represents the values the pragma accepts
+ *  @param result Represents where the value is stored, in capitals, if it is accepted
+ *  @return returns true if the value is accepted
+ */
+template <size_t count>
+static bool pickMode(string_view value, const string_view (&accepted)[count], string &result)
+{
+	string upper(value);
+	for (char &c : upper)
+	{
+		c = toupper((unsigned char)c);
+	}
+	for (string_view mode : accepted)
+	{
+		if (upper == mode)
+		{
+			result = upper;
+			return true;
+		}
+	}
+	return false;
+}
+
+/** @brief Sets one setting
+ *
+ *  @param name Represents the setting's member name
+ *  @param value Represents its value, as written in the config file
+ *  @return returns true if the setting was set, false if the name is unknown or the value isn't valid for it
+ */
+bool bankConfig::set(string_view name, string_view value)
+{
+	if (name == "journalMode")
+	{
+		return pickMode(value, journalModes, journalMode);
+	}
+	if (name == "synchronous")
+	{
+		return pickMode(value, synchronousModes, synchronous);
+	}
+	for (const auto &[settingName, member] : textSettings)
+	{
+		if (name == settingName)
+		{
+			if (value.empty())
+			{
+				return false;
+			}
+			this->*member = value;
+			return true;
+		}
+	}
+
+	long long number;
+	from_chars_result parsed = from_chars(value.data(), value.data() + value.size(), number);
+	bool valid = parsed.ec == errc() && parsed.ptr == value.data() + value.size();
+	for (const auto &[settingName, member] : largeSettings)
+	{
+		if (name == settingName)
+		{
+			if (valid)
+			{
+				this->*member = number;
+			}
+			return valid;
+		}
+	}
+	for (const auto &[settingName, member] : numberSettings)
+	{
+		if (name == settingName)
+		{
+			valid = valid && number >= 0 && number <= INT_MAX;
+			if (valid)
+			{
+				this->*member = (int)number;
+			}
+			return valid;
+		}
+	}
+	return false;
+}
+
+/** @brief Reads settings from a config file
+ *
+ *  A bad line is reported and skipped, leaving that setting as it was.
+ *  @param path Represents the file
+ *  @return returns true if the file was read and every line was valid
+ */
+bool bankConfig::load(const string &path)
+{
+	ifstream file(path);
+	if (!file)
+	{
+		return false;
+	}
+
+	bool ok = true;
+	string line;
+	while (getline(file, line))
+	{
+		string_view text = trim(line);
+		if (text.empty() || text[0] == '#')
+		{
+			continue;
+		}
+		size_t equals = text.find('=');
+		if (equals == string_view::npos || !set(trim(text.substr(0, equals)), trim(text.substr(equals + 1))))
+		{
+			cout << "Bad line in " << path << ": " << line << endl;
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+/** @brief Reads settings from the environment
+ *
+ *  Each setting is read from BANK_ and its member name in capitals, with a _ before each word, so cacheSize is read from
+ *  BANK_CACHE_SIZE. Settings with no variable are left as they are.
+ *  @return returns true if every variable that is set was valid
+ */
+bool bankConfig::loadEnvironment()
+{
+	bool ok = true;
+	auto read = [&](const char *name)
+	{
+		string variable = "BANK_";
+		for (const char *c = name; *c != '\0'; c++)
+		{
+			if (isupper((unsigned char)*c))
+			{
+				variable += '_';
+			}
+			variable += toupper((unsigned char)*c);
+		}
+		const char *value = getenv(variable.c_str());
+		if (value != nullptr && !set(name, trim(value)))
+		{
+			cout << "Bad value for " << variable << ": " << value << endl;
+			ok = false;
+		}
+	};
+
+	for (const auto &setting : textSettings)
+	{
+		read(setting.first);
+	}
+	for (const auto &setting : largeSettings)
+	{
+		read(setting.first);
+	}
+	for (const auto &setting : numberSettings)
+	{
+		read(setting.first);
+	}
+	return ok;
+}
+
+/** @brief Sets the configured pragmas on a connection
+ *
+ *  The busy timeout is set first, so changing the journal mode waits for other connections rather than failing.
+ *  @param db Represents the open connection
+ *  @return returns true if every pragma was set
+ */
+bool bankConfig::apply(database &db) const
+{
+	bool ok = db.exec(("PRAGMA busy_timeout = " + to_string(busyTimeout) + ";").c_str());
+	ok = db.exec(("PRAGMA journal_mode = " + journalMode + ";").c_str()) && ok;
+	ok = db.exec(("PRAGMA synchronous = " + synchronous + ";").c_str()) && ok;
+	ok = db.exec(("PRAGMA cache_size = " + to_string(cacheSize) + ";").c_str()) && ok;
+	ok = db.exec(("PRAGMA mmap_size = " + to_string(mmapSize) + ";").c_str()) && ok;
+	return ok;
+}
+
+/** @brief Opens the configured database file
+ *
+ *  @param db Represents the connection to open
+ *  @return returns true if the file was opened and every pragma was set
+ */
+bool bankConfig::open(database &db) const
+{
+	if (!db.open(databasePath.c_str()))
+	{
+		cout << "Can't open database" << endl;
+		return false;
+	}
+	return apply(db);
+}
+
+/** @brief Returns the settings this process runs with
+ *
+ *  Read once, the first time they are asked for: the defaults, then the file named by BANK_CONFIG or bank.conf if it exists, then the
+ *  environment.
+ *  @return returns the settings
+ */
+const bankConfig &bankSettings()
+{
+	static const bankConfig settings = []
+	{
+		bankConfig config;
+		const char *path = getenv("BANK_CONFIG");
+		if (!config.load(path != nullptr ? path : "bank.conf") && path != nullptr)
+		{
+			cout << "Couldn't read all of " << path << endl;
+		}
+		config.loadEnvironment();
+		return config;
+	}();
+	return settings;
+}
@@ -12,28 +12,38 @@ using namespace std;
 
 /** @brief represents the budgeting page for the customer
  *
- *  Takes a username, and generates the budgeting page for customer associated with the username.
+ *  Takes a username, and generates the budgeting page for customer associated with the username. The username is looked up once, and
+ *  every total is read by the user's ID.
  *  @param username Represents the username of the customer that wants to access their budgeting page
+ *  @param resource Represents the memory the page's strings are allocated from
+ *  @param config Represents the settings the database is opened with
  */
-budgeting::budgeting(string username)
+budgeting::budgeting(string username, pmr::memory_resource *resource, const bankConfig &config)
+    : username(username, resource)
 {
-    this->username = username;
-
     // Instantiates the data members to 0
     spending = 0.0;
     moneyGained = 0.0;
     initialBalance = 0.0;
 
     // Opens the database
-    rc = sqlite3_open("newDatabase.db", &DB);
+    config.open(DB);
+    addUserIDs(DB);
+    userID = userIDs().find(DB, this->username);
 }
 
 /** @brief empty constructor for the budgeting object
  *
  *  This method allows for budgeting object instantiation for GUI purposes
+ *  @param resource Represents the memory the page's strings are allocated from
  */
-budget::budgeting()
+budgeting::budgeting(pmr::memory_resource *resource)
+    : username(resource)
 {
+    userID = -1;
+    spending = 0.0;
+    moneyGained = 0.0;
+    initialBalance = 0.0;
 }
 
 /** @brief destructor for the budgeting object
@@ -44,69 +54,72 @@ budgeting::~budgeting()
 {
 }
 
+/** @brief reads the total spent and gained by the user
+ *
+ *  This method reads every journal entry that takes money from or gives money to one of the customer's accounts in a single pass, and
+ *  adds the debits up as spending and the credits as money gained, together with the totals of the months sealed out of the journal.
+ */
+void budgeting::loadTotals()
+{
+    struct totalsRow
+    {
+        double spent;
+        double gained;
+        static auto columns() { return std::make_tuple(&totalsRow::spent, &totalsRow::gained); }
+    };
+
+    // Both reads run in one read transaction, so a month sealed between them isn't counted twice or missed
+    DB.exec("BEGIN;");
+
+    // Queries the journal for the entries on either side of the user's accounts. A debit is money spent, and a credit is money gained.
+    optional<totalsRow> live = DB.queryRow<totalsRow>("SELECT SUM(CASE WHEN j.debitAccountID = a.accountID THEN j.amount ELSE 0 END),"
+                                                      " SUM(CASE WHEN j.creditAccountID = a.accountID THEN j.creditAmount ELSE 0 END)"
+                                                      " FROM accounts AS a, journal AS j"
+                                                      " WHERE (j.debitAccountID = a.accountID OR j.creditAccountID = a.accountID) AND a.userID = ?;",
+                                                      userID);
+
+    // Adds the months that have been sealed out of the journal, if there are any
+    optional<totalsRow> sealed = DB.queryRow<totalsRow>("SELECT SUM(CASE WHEN m.transactionType IN (\"withdraw\", \"send\") THEN m.total ELSE 0 END),"
+                                                        " SUM(CASE WHEN m.transactionType IN (\"withdraw\", \"send\") THEN 0 ELSE m.total END)"
+                                                        " FROM accounts AS a, monthlyTotals AS m WHERE a.accountID = m.accountID AND a.userID = ?;",
+                                                        userID);
+    DB.exec("COMMIT;");
+
+    spending = (live ? live->spent : 0) + (sealed ? sealed->spent : 0);
+    moneyGained = (live ? live->gained : 0) + (sealed ? sealed->gained : 0);
+}
+
 /** @brief returns the total amount of spending from the user
  *
- *  This method searches through all of the customer's withdrawal and send transactions, adds up the amount, and returns it to the customer
+ *  This method adds up all of the customer's withdrawals and transfers sent, and returns it to the customer
  *  @return Returns the total amount spent by the user
  */
 double budgeting::getSpending()
 {
-    // Queries the database for the total amount from all withdrawal/send transactions under the specified username
-    sql = "SELECT SUM(t.amount) FROM accounts AS a, users AS u, transactions AS t WHERE u.username = a.username"
-          " AND a.accountID = t.senderAccountID"
-          " AND u.username = \"" +
-          username +
-          "\" AND (transactionType = \"withdraw\" OR transactionType = \"send\");";
-
-    // Prepares the statement object
-    sqlite3_stmt *stmt;
-    sqlite3_prepare_v2(DB, sql.c_str(), sql.length(), &stmt, nullptr);
-    step = sqlite3_step(stmt);
-
-    // Stores the retrieved value
-    spending = (sqlite3_column_double(stmt, 0));
-    sqlite3_finalize(stmt);
-
-    // Returns the total spend value to the user
+    loadTotals();
     return spending;
 }
 
 /** @brief returns the total amount gained for the user
  *
- *  This method searches through all of the customer's deposit and receive transactions, adds up the amount, and returns it to the customer
+ *  This method adds up all of the customer's deposits, transfers received, interest and loans, and returns it to the customer
  *  @return Returns the total amount gained by the user through all accounts
  */
 double budgeting::getGained()
 {
-    // Queries the database for the total amount from all receive/deposit transactions under the specified username.
-    sql = "SELECT SUM(t.amount) FROM accounts AS a, users AS u, transactions AS t WHERE u.username = a.username"
-          " AND a.accountID = t.senderAccountID"
-          " AND u.username = \"" +
-          username +
-          "\" AND (transactionType = \"deposit\" OR transactionType = \"receive\");";
-
-    // Prepares the statement object.
-    sqlite3_stmt *stmt;
-
-    sqlite3_prepare_v2(DB, sql.c_str(), sql.length(), &stmt, nullptr);
-    step = sqlite3_step(stmt);
-
-    // Stores the retrieved value.
-    moneyGained = (sqlite3_column_double(stmt, 0));
-    sqlite3_finalize(stmt);
-
-    // Returns the total gain value.
+    loadTotals();
     return moneyGained;
 }
 
 /** @brief returns the total amount of profit for the user
  *
- *  This method searches calculates the total profit by subtracting total spending from total gain
+ *  This method searches calculates the total profit by subtracting total spending from total gain, both read in one pass
  *  @return Returns the total amount gained by the user through all accounts
  */
 double budgeting::getProfit()
 {
-    return getGained() - getSpending();
+    loadTotals();
+    return moneyGained - spending;
 }
 
 /** @brief returns the total initial balance from all of the user's accounts
@@ -117,38 +130,8 @@ double budgeting::getProfit()
 double budgeting::getInitialBalance()
 {
     // Queries the database by adding initial balance from all accounts under the specified user
-    sql = "SELECT SUM(initialBalance) FROM users AS u, accounts AS a WHERE u.username = a.username"
-          " AND u.username = \"" +
-          username + "\";";
-
-    // Prepares the statement object.
-    sqlite3_stmt *stmt;
-    sqlite3_prepare_v2(DB, sql.c_str(), sql.length(), &stmt, nullptr);
-
-    step = sqlite3_step(stmt);
-
-    // Stores the retrieved value.
-    initialBalance = (sqlite3_column_double(stmt, 0));
-    sqlite3_finalize(stmt);
+    initialBalance = DB.queryValue<double>("SELECT SUM(initialBalance) FROM accounts WHERE userID = ?;", userID).value_or(0);
 
     // Returns the total initial balance
     return initialBalance;
 }
-
-/** @brief Helps with executing sql.
- *
- *  This function is used when executing sql statements.
- *  @param unused This variable is not used and serves no purpose.
- *  @param numColumns The number of columns in the table.
- *  @param value List of the values from the current row from each column.
- *  @param columns Name of each column in the table.
- *  @return Always returns to fit the base necessities.
- */
-static int callback(void *unused, int numColumns, char **value, char **columns)
-{
-    for (int i = 0; i < numColumns; i++)
-    {
-        cout << "Name = " << columns[i] << "   Value = " << value[i] << endl;
-    }
-    return 0;
-}
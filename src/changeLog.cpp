@@ -0,0 +1,669 @@
+/** @brief Publishes every committed write to a log other processes can follow
+ *
+ *  Accounts, customers and administrators hand their writes to changeLog::commit, which commits them to the database and appends a
+ *  record of each to the end of the log, in the order the commits happened. The log is made of memory mapped segment files, so a
+ *  changeLogReader in any process sees a record as soon as it is appended, and reads it straight from the mapping without copying it.
+ *  The database is still the only record of the bank's data. The log only tells its readers what changed, and when.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file changeLog.cpp
+ *  @class changeLog "../include/changeLog.h"
+ */
+
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include "changeLog.h"
+
+using namespace std;
+
+static const unsigned int logVersion = 1;
+static const size_t segmentHeaderSize = 64;
+static const size_t recordHeaderSize = 48;
+static const size_t maxUsernameLength = 1024;
+static const unsigned int endOfSegment = 0xFFFFFFFF;
+
+/** @brief Reads a record's length, after which the rest of the record is safe to read
+ *
+ *  @param at Represents the start of the record
+ *  @return returns the record's length, 0 if nothing is written there yet, or endOfSegment
+ */
+static unsigned int loadLength(const unsigned char *at)
+{
+	return atomic_ref<unsigned int>(*(unsigned int *)at).load(memory_order_acquire);
+}
+
+/** @brief Writes a record's length once the rest of the record is written, which makes the record visible to readers
+ *
+ *  @param at Represents the start of the record
+ *  @param length Represents the record's length, or endOfSegment
+ */
+static void storeLength(unsigned char *at, unsigned int length)
+{
+	atomic_ref<unsigned int>(*(unsigned int *)at).store(length, memory_order_release);
+}
+
+/** @brief Checks that a record was written completely
+ *
+ *  @param at Represents the start of the record
+ *  @param length Represents the record's length
+ *  @return returns true if the record's checksum matches its contents
+ */
+static bool checkRecord(const unsigned char *at, unsigned int length)
+{
+	unsigned int expected;
+	memcpy(&expected, at + 4, 4);
+	return (unsigned int)crc32(0, at + 8, length - 8) == expected;
+}
+
+string_view changeTypeName(changeType type)
+{
+	switch (type)
+	{
+	case changeType::accountOpened:
+		return "accountOpened";
+	case changeType::accountClosed:
+		return "accountClosed";
+	case changeType::deposit:
+		return "deposit";
+	case changeType::withdraw:
+		return "withdraw";
+	case changeType::transfer:
+		return "transfer";
+	case changeType::loanGiven:
+		return "loanGiven";
+	case changeType::userCreated:
+		return "userCreated";
+	case changeType::userRemoved:
+		return "userRemoved";
+	case changeType::creditScoreChanged:
+		return "creditScoreChanged";
+	}
+	return "unknown";
+}
+
+logSegment::logSegment()
+{
+	base = 0;
+	fd = -1;
+	data = nullptr;
+	size = 0;
+}
+
+logSegment::~logSegment()
+{
+	close();
+}
+
+/** @brief Maps a segment file
+ *
+ *  @param directory Represents the directory of the log
+ *  @param base Represents the offset the segment starts at
+ *  @param writable Represents whether the segment is mapped for appending
+ *  @return returns true if the file exists and has a valid header
+ */
+bool logSegment::open(const string &directory, unsigned long long base, bool writable)
+{
+	close();
+	fd = ::open(path(directory, base).c_str(), writable ? O_RDWR : O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < segmentHeaderSize)
+	{
+		close();
+		return false;
+	}
+	void *mapped = mmap(nullptr, info.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+	if (mapped == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	data = (unsigned char *)mapped;
+	size = info.st_size;
+
+	unsigned int version;
+	unsigned long long storedBase;
+	memcpy(&version, data + 4, 4);
+	memcpy(&storedBase, data + 16, 8);
+	if (memcmp(data, "BKCL", 4) != 0 || version != logVersion || storedBase != base)
+	{
+		cout << "Not a change log segment: " << path(directory, base) << endl;
+		close();
+		return false;
+	}
+	this->base = base;
+	return true;
+}
+
+void logSegment::close()
+{
+	if (data != nullptr)
+	{
+		munmap(data, size);
+		data = nullptr;
+	}
+	if (fd >= 0)
+	{
+		::close(fd);
+		fd = -1;
+	}
+	size = 0;
+}
+
+bool logSegment::isOpen() const
+{
+	return data != nullptr;
+}
+
+/** @brief Returns the file a segment is stored in
+ *
+ *  @param directory Represents the directory of the log
+ *  @param base Represents the offset the segment starts at
+ *  @return returns the segment's path
+ */
+string logSegment::path(const string &directory, unsigned long long base)
+{
+	char name[48];
+	snprintf(name, sizeof(name), "changes-%020llu.log", base);
+	return directory + "/" + name;
+}
+
+/** @brief Finds the segments of a log
+ *
+ *  @param directory Represents the directory of the log
+ *  @return returns the offsets the segments start at, smallest first
+ */
+vector<unsigned long long> logSegment::list(const string &directory)
+{
+	vector<unsigned long long> bases;
+	error_code error;
+	for (const filesystem::directory_entry &entry : filesystem::directory_iterator(directory, error))
+	{
+		string name = entry.path().filename().string();
+		unsigned long long base;
+		char end;
+		if (name.size() == 32 && sscanf(name.c_str(), "changes-%20llu.lo%c", &base, &end) == 2 && end == 'g')
+		{
+			bases.push_back(base);
+		}
+	}
+	sort(bases.begin(), bases.end());
+	return bases;
+}
+
+/** @brief Opens the log for appending
+ *
+ *  Finds the end of the newest segment. A record left half written by a crash is cleared, along with everything after it, and a commit
+ *  a crash left without its records is counted as lost.
+ *  @param directory Represents the directory of the log, which is created if it doesn't exist
+ *  @param segmentSize Represents the size of each new segment, rounded up to a whole number of pages
+ */
+changeLog::changeLog(string directory, size_t segmentSize)
+{
+	this->directory = directory;
+	this->segmentSize = max<size_t>((segmentSize + 4095) / 4096 * 4096, 4096);
+	position = segmentHeaderSize;
+
+	mkdir(directory.c_str(), 0755);
+	lockFD = ::open((directory + "/lock").c_str(), O_RDWR | O_CREAT, 0644);
+	if (lockFD < 0)
+	{
+		cout << "Can't open change log in " << directory << endl;
+		return;
+	}
+
+	flock(lockFD, LOCK_EX);
+	recoverPending();
+	vector<unsigned long long> bases = logSegment::list(directory);
+	if (bases.empty() ? createSegment(0) && openSegment(0) : segment.open(directory, bases.back(), true))
+	{
+		while (position + 8 <= segment.size)
+		{
+			unsigned int length = loadLength(segment.data + position);
+			if (length == 0 || length == endOfSegment)
+			{
+				break;
+			}
+			if (length < recordHeaderSize || position + length > segment.size || !checkRecord(segment.data + position, length))
+			{
+				memset(segment.data + position, 0, segment.size - position);
+				break;
+			}
+			position += length;
+		}
+		catchUp();
+	}
+	else
+	{
+		cout << "Can't open change log in " << directory << endl;
+	}
+	flock(lockFD, LOCK_UN);
+}
+
+changeLog::~changeLog()
+{
+	if (lockFD >= 0)
+	{
+		::close(lockFD);
+	}
+}
+
+/** @brief Makes a new segment file
+ *
+ *  The file is filled in under a temporary name first, so readers never see it without its header. If another process has already
+ *  made the segment, it is left as it is.
+ *  @param base Represents the offset the new segment starts at
+ *  @return returns true if the segment exists
+ */
+bool changeLog::createSegment(unsigned long long base)
+{
+	string path = logSegment::path(directory, base);
+	if (access(path.c_str(), F_OK) != 0)
+	{
+		string temporary = path + ".tmp";
+		int fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+		{
+			return false;
+		}
+		unsigned char header[segmentHeaderSize] = {};
+		unsigned long long size = segmentSize;
+		memcpy(header, "BKCL", 4);
+		memcpy(header + 4, &logVersion, 4);
+		memcpy(header + 8, &size, 8);
+		memcpy(header + 16, &base, 8);
+		bool written = ftruncate(fd, segmentSize) == 0 && pwrite(fd, header, sizeof(header), 0) == (ssize_t)sizeof(header);
+		::close(fd);
+		if (!written || rename(temporary.c_str(), path.c_str()) != 0)
+		{
+			unlink(temporary.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+/** @brief Starts appending to the start of a segment
+ *
+ *  @param base Represents the offset the segment starts at
+ *  @return returns true if the segment is open for appending
+ */
+bool changeLog::openSegment(unsigned long long base)
+{
+	position = segmentHeaderSize;
+	return segment.open(directory, base, true);
+}
+
+/** @brief Moves past records other processes have appended
+ *
+ *  Must be called with the directory locked.
+ *  @return returns true if position is the end of the log
+ */
+bool changeLog::catchUp()
+{
+	while (segment.isOpen())
+	{
+		if (position + 8 > segment.size || loadLength(segment.data + position) == endOfSegment)
+		{
+			unsigned long long nextBase = segment.base + segment.size;
+			if (!createSegment(nextBase) || !openSegment(nextBase))
+			{
+				return false;
+			}
+			continue;
+		}
+		unsigned int length = loadLength(segment.data + position);
+		if (length == 0)
+		{
+			return true;
+		}
+		position += length;
+	}
+	return false;
+}
+
+/** @brief Appends one record to the end of the log
+ *
+ *  Must be called with the directory locked. When the record doesn't fit, the next segment is made before the current one is marked
+ *  as finished, so a reader following the mark always finds it.
+ *  @param event Represents the write being recorded
+ *  @param commitTime Represents when it was committed, in microseconds since 1970
+ *  @return returns true if the record was appended
+ */
+bool changeLog::append(const changeEvent &event, long long commitTime)
+{
+	unsigned int usernameLength = (unsigned int)min(event.username.size(), maxUsernameLength);
+	unsigned int length = (unsigned int)((recordHeaderSize + usernameLength + 7) / 8 * 8);
+
+	if (position + length > segment.size)
+	{
+		unsigned long long nextBase = segment.base + segment.size;
+		if (!createSegment(nextBase))
+		{
+			return false;
+		}
+		if (position + 8 <= segment.size)
+		{
+			storeLength(segment.data + position, endOfSegment);
+		}
+		if (!openSegment(nextBase))
+		{
+			return false;
+		}
+	}
+
+	unsigned char *at = segment.data + position;
+	unsigned long long offset = segment.base + position;
+	unsigned char type = (unsigned char)event.type;
+	memset(at + 4, 0, length - 4);
+	memcpy(at + 8, &offset, 8);
+	memcpy(at + 16, &commitTime, 8);
+	memcpy(at + 24, &type, 1);
+	memcpy(at + 28, &event.accountID, 4);
+	memcpy(at + 32, &event.otherAccountID, 4);
+	memcpy(at + 36, &usernameLength, 4);
+	memcpy(at + 40, &event.amount, 8);
+	memcpy(at + 48, event.username.data(), usernameLength);
+	unsigned int checksum = (unsigned int)crc32(0, at + 8, length - 8);
+	memcpy(at + 4, &checksum, 4);
+	storeLength(at, length);
+
+	position += length;
+	return true;
+}
+
+/** @brief Commits a transaction and records what it changed
+ *
+ *  The directory stays locked from the commit until the records are appended, so no other commit, in this process or another, can
+ *  get between a commit and its records. If the log can't be written, the commit still stands, and the loss is counted so readers
+ *  know to read the database again. The commit is marked pending in the lock file before it is made and cleared once its records are
+ *  appended, so a process that dies in between leaves the mark for the next one to count as lost.
+ *  @param db Represents the connection with a transaction open
+ *  @param events Represents the writes the transaction made
+ *  @return returns true if the transaction committed
+ */
+bool changeLog::commit(database &db, const vector<changeEvent> &events)
+{
+	lock_guard<mutex> guard(writeLock);
+	if (lockFD >= 0)
+	{
+		flock(lockFD, LOCK_EX);
+		recoverPending();
+		setPending(true);
+	}
+
+	bool committed = db.exec("COMMIT;");
+	if (!committed)
+	{
+		cout << "Could not commit: " << db.getError() << endl;
+		db.exec("ROLLBACK;");
+	}
+	else if (events.size() > 0)
+	{
+		long long commitTime = chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+		bool recorded = catchUp();
+		for (const changeEvent &event : events)
+		{
+			recorded = recorded && append(event, commitTime);
+		}
+		if (!recorded)
+		{
+			cout << "Could not record change in " << directory << endl;
+			markLost();
+		}
+	}
+
+	if (lockFD >= 0)
+	{
+		setPending(false);
+		flock(lockFD, LOCK_UN);
+	}
+	return committed;
+}
+
+/** @brief Marks a commit as pending in the first byte of the lock file, or clears the mark
+ *
+ *  Called with the directory locked. If the mark can't be written, the commit goes on without it.
+ *  @param pending Represents whether a commit is about to be made
+ */
+void changeLog::setPending(bool pending)
+{
+	char mark = pending ? 'p' : '-';
+	if (::pwrite(lockFD, &mark, 1, 0) != 1)
+	{
+		cout << "Could not mark pending change in " << directory << endl;
+	}
+}
+
+/** @brief Counts a commit whose writer died before appending its records
+ *
+ *  Called with the directory locked, so a mark left in the lock file can't belong to a commit still running. The commit may have
+ *  been rolled back when its writer died, in which case readers only read the database again for nothing.
+ */
+void changeLog::recoverPending()
+{
+	char mark = 0;
+	if (::pread(lockFD, &mark, 1, 0) == 1 && mark == 'p')
+	{
+		cout << "A commit was left without its records in " << directory << endl;
+		markLost();
+		setPending(false);
+	}
+}
+
+/** @brief Counts a commit whose records could not be appended
+ *
+ *  Readers that keep state built from the log can't tell a record is missing, so the loss is counted instead. One byte is added to
+ *  the lost file for each, which other processes see in its size. The count is also kept in memory, in case the file can't be written.
+ */
+void changeLog::markLost()
+{
+	lostHere++;
+	int fd = ::open((directory + "/lost").c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (fd >= 0)
+	{
+		if (::write(fd, "x", 1) != 1)
+		{
+			cout << "Could not count lost change in " << directory << endl;
+		}
+		::close(fd);
+	}
+}
+
+/** @brief Returns how many commits are missing from the log
+ *
+ *  A reader that sees this change has missed records, and has to build its state from the database again. A pending mark with no
+ *  writer holding the directory is counted here, rather than waiting for the next commit to find it.
+ *  @return returns a count that grows with every lost commit: the size of the lost file, plus the commits this process lost
+ */
+unsigned long long changeLog::getLostCount()
+{
+	char mark = 0;
+	if (lockFD >= 0 && ::pread(lockFD, &mark, 1, 0) == 1 && mark == 'p')
+	{
+		unique_lock<mutex> guard(writeLock, try_to_lock);
+		if (guard.owns_lock() && flock(lockFD, LOCK_EX | LOCK_NB) == 0)
+		{
+			recoverPending();
+			flock(lockFD, LOCK_UN);
+		}
+	}
+	struct stat info;
+	unsigned long long counted = stat((directory + "/lost").c_str(), &info) == 0 ? info.st_size : 0;
+	return counted + lostHere.load();
+}
+
+/** @brief Returns the offset the next record will be written at
+ *
+ *  @return returns the end of the log
+ */
+unsigned long long changeLog::getEndOffset()
+{
+	lock_guard<mutex> guard(writeLock);
+	if (lockFD >= 0)
+	{
+		flock(lockFD, LOCK_EX);
+		catchUp();
+		flock(lockFD, LOCK_UN);
+	}
+	return segment.base + position;
+}
+
+/** @brief Writes the segment being appended to out to disk
+ *
+ *  Readers don't need this to see new records. It only matters if the log has to survive the machine going down.
+ */
+void changeLog::flush()
+{
+	lock_guard<mutex> guard(writeLock);
+	if (segment.isOpen())
+	{
+		msync(segment.data, segment.size, MS_SYNC);
+	}
+}
+
+/** @brief Deletes segments every consumer has read past
+ *
+ *  The segment being appended to is always kept.
+ *  @param offset Represents the smallest offset any consumer still has to read from
+ *  @return returns the number of segments deleted
+ */
+int changeLog::removeSegmentsBefore(unsigned long long offset)
+{
+	lock_guard<mutex> guard(writeLock);
+	vector<unsigned long long> bases = logSegment::list(directory);
+	int removed = 0;
+	for (size_t i = 0; i + 1 < bases.size(); i++)
+	{
+		if (bases[i + 1] <= offset && bases[i] != segment.base && unlink(logSegment::path(directory, bases[i]).c_str()) == 0)
+		{
+			removed++;
+		}
+	}
+	return removed;
+}
+
+/** @brief Starts following a log
+ *
+ *  @param directory Represents the directory of the log
+ *  @param offset Represents the offset to start reading from, as returned by getOffset or a record. 0 starts from the oldest record kept.
+ */
+changeLogReader::changeLogReader(string directory, unsigned long long offset)
+{
+	this->directory = directory;
+	position = offset;
+	openAt(offset);
+}
+
+/** @brief Maps the segment holding an offset
+ *
+ *  If the segment has already been deleted, reading starts at the oldest record kept.
+ *  @param offset Represents the offset to read from next
+ *  @return returns true if the segment is open
+ */
+bool changeLogReader::openAt(unsigned long long offset)
+{
+	vector<unsigned long long> bases = logSegment::list(directory);
+	if (bases.empty())
+	{
+		return false;
+	}
+	vector<unsigned long long>::iterator after = upper_bound(bases.begin(), bases.end(), offset);
+	unsigned long long base = after == bases.begin() ? bases.front() : *(after - 1);
+	if (!segment.open(directory, base, false))
+	{
+		return false;
+	}
+	position = offset > base + segmentHeaderSize ? (size_t)min<unsigned long long>(offset - base, segment.size) : segmentHeaderSize;
+	return true;
+}
+
+/** @brief Reads the next record
+ *
+ *  The record's username points into the mapped segment, so nothing is copied. A record still being written is not read until it is
+ *  complete.
+ *  @param record Represents where the record is stored
+ *  @return returns true if a record was read, false if the reader is at the end of the log
+ */
+bool changeLogReader::next(changeRecord &record)
+{
+	if (!segment.isOpen() && !openAt(position))
+	{
+		return false;
+	}
+
+	while (position + 8 > segment.size || loadLength(segment.data + position) == endOfSegment)
+	{
+		unsigned long long nextBase = segment.base + segment.size;
+		if (!segment.open(directory, nextBase, false))
+		{
+			position = nextBase;
+			return false;
+		}
+		position = segmentHeaderSize;
+	}
+
+	const unsigned char *at = segment.data + position;
+	unsigned int length = loadLength(at);
+	if (length < recordHeaderSize || position + length > segment.size || !checkRecord(at, length))
+	{
+		return false;
+	}
+
+	unsigned int usernameLength;
+	memcpy(&record.offset, at + 8, 8);
+	memcpy(&record.commitTime, at + 16, 8);
+	record.type = (changeType)at[24];
+	memcpy(&record.accountID, at + 28, 4);
+	memcpy(&record.otherAccountID, at + 32, 4);
+	memcpy(&usernameLength, at + 36, 4);
+	memcpy(&record.amount, at + 40, 8);
+	record.username = string_view((const char *)at + 48, usernameLength);
+	position += length;
+	return true;
+}
+
+/** @brief Reads the next record, waiting for one to be appended if the reader is at the end of the log
+ *
+ *  @param record Represents where the record is stored
+ *  @param wait Represents the longest time to wait
+ *  @return returns true if a record was read
+ */
+bool changeLogReader::next(changeRecord &record, chrono::milliseconds wait)
+{
+	chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + wait;
+	chrono::microseconds pause(50);
+	while (!next(record))
+	{
+		if (chrono::steady_clock::now() >= deadline)
+		{
+			return false;
+		}
+		this_thread::sleep_for(pause);
+		pause = min(pause * 2, chrono::microseconds(2000));
+	}
+	return true;
+}
+
+/** @brief Returns the offset to resume reading from
+ *
+ *  @return returns the offset of the next record
+ */
+unsigned long long changeLogReader::getOffset() const
+{
+	return segment.isOpen() ? segment.base + position : position;
+}
+
+/** @brief Returns the log this process publishes its writes to
+ *
+ *  @return returns the log in the configured directory
+ */
+changeLog &changeFeed()
+{
+	static changeLog feed(bankSettings().changeLogDirectory, bankSettings().changeLogSegmentSize);
+	return feed;
+}
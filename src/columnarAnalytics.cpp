@@ -0,0 +1,561 @@
+/** @brief Answers analytics and budgeting questions from memory.
+ *
+ *  Loads the accounts table and the journal into column-oriented arrays, with usernames and transaction types replaced by small integer
+ *  codes, and answers the analytics and budgeting aggregates by scanning those arrays split across every core. New transactions are picked
+ *  up by reading only the entries added since the last load. Months sealed out of the journal are loaded from their monthly totals, so
+ *  the aggregates still match budgeting. This is meant for the administrator dashboard, where the same data is asked many different
+ *  questions.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file columnarAnalytics.cpp
+ *  @class columnarAnalytics "../include/columnarAnalytics.h"
+ *
+*/
+
+#include "columnarAnalytics.h"
+using namespace std;
+
+/** @brief Runs a scan split across several threads.
+ *  @param count The number of rows to scan.
+ *  @param numThreads The most threads to use.
+ *  @param scan Called once per thread with the thread's index and the first and last (exclusive) row it scans.
+ *  @return Returns the number of threads used.
+ *
+ *  Small scans run on the calling thread, since starting threads would cost more than the scan itself.
+*/
+template <typename Fn>
+static unsigned int parallelScan(size_t count, unsigned int numThreads, Fn scan) {
+    const size_t minRowsPerThread = 1 << 16;
+    unsigned int used = (unsigned int)min<size_t>(numThreads, count / minRowsPerThread);
+    if (used <= 1) {
+        scan(0, (size_t)0, count);
+        return 1;
+    }
+
+    vector<thread> threads;
+    size_t perThread = (count + used - 1) / used;
+    for (unsigned int t = 0; t < used; t++) {
+        size_t begin = t * perThread;
+        size_t end = min(count, begin + perThread);
+        threads.emplace_back(scan, t, begin, end);
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    return used;
+}
+
+/** @brief Opens the database and loads every table.
+ *  @param config The settings the database is opened with, and the most threads a scan may use, or 0 to use one per core.
+*/
+columnarAnalytics::columnarAnalytics(const bankConfig &config) {
+    lastTransactionID = 0;
+    sealedRows = 0;
+    sealedSides = 0;
+    sealedEntries = 0;
+    numThreads = config.analyticsThreads > 0 ? config.analyticsThreads : max(1u, thread::hardware_concurrency());
+
+	// opens the database file with the configured pragmas, returns an error if it fails
+    config.open(db);
+    addUserIDs(db);
+    load();
+}
+
+/** @brief Closes the database.
+*/
+columnarAnalytics::~columnarAnalytics() {
+}
+
+/** @brief Loads every table from scratch.
+ *
+ *  Drops all columns and dictionaries, and reads users, accounts and transactions again from one consistent read of the database. Use this
+ *  after accounts or transactions have been deleted, which refresh does not notice.
+*/
+void columnarAnalytics::load() {
+    usernames.clear();
+    regularUsers.clear();
+    usernameCodes.clear();
+    userIDCodes.clear();
+    transactionTypes.clear();
+    typeCodes.clear();
+    currencies.clear();
+    currencyCodes.clear();
+    transactionAccounts.clear();
+    transactionUsers.clear();
+    types.clear();
+    amounts.clear();
+    timestamps.clear();
+    days.clear();
+    lastTransactionID = 0;
+    sealedRows = 0;
+    sealedSides = 0;
+
+    db.exec("BEGIN;");
+    loadUsers();
+    loadAccounts();
+    loadSealedTotals();
+    loadTransactions();
+    db.exec("COMMIT;");
+}
+
+/** @brief Picks up changes since the last load.
+ *  @return The number of new transactions read, or of every transaction if they were all loaded again.
+ *
+ *  Reloads users and account balances, which are small, and appends only the transactions with an ID above the last one read. If a
+ *  month has been sealed since, its entries have left the journal for the monthly totals, so everything is loaded again instead.
+*/
+int columnarAnalytics::refresh() {
+    if (countSealedEntries() != sealedEntries) {
+        load();
+        return (int)amounts.size();
+    }
+
+    db.exec("BEGIN;");
+    loadUsers();
+    loadAccounts();
+    int added = loadTransactions();
+    db.exec("COMMIT;");
+    return added;
+}
+
+/** @brief Gets the number of regular users.
+ *  @return The number of regular users.
+*/
+int columnarAnalytics::getNumUsers() {
+    int numUsers = 0;
+    for (size_t i = 0; i < regularUsers.size(); i++) {
+        numUsers += regularUsers[i] ? 1 : 0;
+    }
+    return numUsers;
+}
+
+/** @brief Gets the number of transactions.
+ *  @return The number of transaction sides loaded, counting each side totalled into a sealed month.
+*/
+int columnarAnalytics::getNumTransactions() {
+    return (int)(amounts.size() - sealedRows + sealedSides);
+}
+
+/** @brief Gets the balance of a user.
+ *  @param username The username of the user we wish to check the balance of.
+ *  @return The total balance of the user in the base currency, or -1 if the user does not exist.
+ *
+ *  Totals the user's balances in each currency, then converts the totals to the base currency together, matching analytics::getBalance.
+*/
+double columnarAnalytics::getBalance(string username) {
+    unordered_map<string, int>::iterator found = usernameCodes.find(username);
+    if (found == usernameCodes.end()) {
+        return -1;
+    }
+
+    int code = found->second;
+    vector<double> currencyTotals(currencies.size(), 0.0);
+    for (size_t i = 0; i < balances.size(); i++) {
+        currencyTotals[accountCurrencies[i]] += (accountUsers[i] == code) ? balances[i] : 0.0;
+    }
+    return toBaseCurrency(currencyTotals);
+}
+
+/** @brief Gets the average balance.
+ *  @return The average of every regular user's total balance in the base currency, rounded down to two decimal places.
+*/
+double columnarAnalytics::getAverageBalance() {
+    int numUsers = getNumUsers();
+    if (numUsers == 0) {
+        return 0;
+    }
+
+    vector<double> currencyTotals(currencies.size(), 0.0);
+    for (size_t i = 0; i < balances.size(); i++) {
+        currencyTotals[accountCurrencies[i]] += regularUsers[accountUsers[i]] ? balances[i] : 0.0;
+    }
+    return floor(toBaseCurrency(currencyTotals) / numUsers * 100.00) / 100.00;
+}
+
+/** @brief Gets the total spending of a user.
+ *  @param username The username of the user.
+ *  @return The total of the user's withdraw and send transactions, matching budgeting::getSpending.
+*/
+double columnarAnalytics::getSpending(string username) {
+    unordered_map<string, int>::iterator found = usernameCodes.find(username);
+    if (found == usernameCodes.end()) {
+        return 0;
+    }
+    return sumTransactions(found->second, {"withdraw", "send"});
+}
+
+/** @brief Gets the total money gained by a user.
+ *  @param username The username of the user.
+ *  @return The total of the user's deposit, receive, interest and loan transactions, matching budgeting::getGained.
+*/
+double columnarAnalytics::getGained(string username) {
+    unordered_map<string, int>::iterator found = usernameCodes.find(username);
+    if (found == usernameCodes.end()) {
+        return 0;
+    }
+    return sumTransactions(found->second, {"deposit", "receive", "interest", "loan"});
+}
+
+/** @brief Gets the total amount of one type of transaction.
+ *  @param transactionType The type of transaction, such as "deposit".
+ *  @return The total amount of every transaction of that type.
+*/
+double columnarAnalytics::getTotalAmount(string transactionType) {
+    return sumTransactions(-1, {transactionType});
+}
+
+/** @brief Gets the total amount of each type of transaction.
+ *  @return The total amount, keyed by transaction type.
+*/
+map<string, double> columnarAnalytics::getTotalByType() {
+    vector<double> totals = groupTransactions(types, transactionTypes.size(), -1);
+    map<string, double> result;
+    for (size_t i = 0; i < totals.size(); i++) {
+        result[transactionTypes[i]] = totals[i];
+    }
+    return result;
+}
+
+/** @brief Gets the total amount of one type of transaction for each user.
+ *  @param transactionType The type of transaction, or an empty string for every type.
+ *  @return The total amount, keyed by username. Users without any matching transactions are left out.
+*/
+map<string, double> columnarAnalytics::getTotalByUser(string transactionType) {
+    int typeFilter = transactionType.empty() ? -1 : typeCode(transactionType);
+    map<string, double> result;
+    if (!transactionType.empty() && typeFilter < 0) {
+        return result;
+    }
+
+    vector<double> totals = groupTransactions(transactionUsers, usernames.size(), typeFilter);
+    for (size_t i = 0; i < totals.size(); i++) {
+        if (totals[i] != 0) {
+            result[usernames[i]] = totals[i];
+        }
+    }
+    return result;
+}
+
+/** @brief Gets the total amount of one type of transaction for each day.
+ *  @param transactionType The type of transaction, or an empty string for every type.
+ *  @return The total amount, keyed by the day as YYYY-MM-DD. Days without any matching transactions are left out.
+*/
+map<string, double> columnarAnalytics::getTotalByDay(string transactionType) {
+    int typeFilter = transactionType.empty() ? -1 : typeCode(transactionType);
+    map<string, double> result;
+    if (days.empty() || (!transactionType.empty() && typeFilter < 0)) {
+        return result;
+    }
+
+    // Days are grouped relative to the first day, so the groups stay a small dense array
+    int firstDay = days[0];
+    int lastDay = days[0];
+    for (size_t i = 1; i < days.size(); i++) {
+        firstDay = min(firstDay, days[i]);
+        lastDay = max(lastDay, days[i]);
+    }
+    vector<int> keys(days.size());
+    for (size_t i = 0; i < days.size(); i++) {
+        keys[i] = days[i] - firstDay;
+    }
+
+    vector<double> totals = groupTransactions(keys, lastDay - firstDay + 1, typeFilter);
+    for (size_t i = 0; i < totals.size(); i++) {
+        if (totals[i] != 0) {
+            char date[11];
+            time_t dayStart = (time_t)(firstDay + (int)i) * 86400;
+            strftime(date, sizeof(date), "%Y-%m-%d", gmtime(&dayStart));
+            result[date] = totals[i];
+        }
+    }
+    return result;
+}
+
+/** @brief Gets the code for a username.
+ *  @param username The username to look up.
+ *  @return The username's code, added to the dictionary if it was not there yet.
+*/
+int columnarAnalytics::usernameCode(const string &username) {
+    unordered_map<string, int>::iterator found = usernameCodes.find(username);
+    if (found != usernameCodes.end()) {
+        return found->second;
+    }
+    int code = (int)usernames.size();
+    usernames.push_back(username);
+    regularUsers.push_back(false);
+    usernameCodes[username] = code;
+    return code;
+}
+
+/** @brief Gets the code for a transaction type.
+ *  @param transactionType The transaction type to look up.
+ *  @return The transaction type's code, or -1 if no loaded transaction has that type.
+*/
+int columnarAnalytics::typeCode(const string &transactionType) {
+    unordered_map<string, int>::iterator found = typeCodes.find(transactionType);
+    if (found != typeCodes.end()) {
+        return found->second;
+    }
+    return -1;
+}
+
+/** @brief Loads the users dictionary.
+ *
+ *  Adds any new usernames to the dictionary, and records which users are regular users, and which code each userID has.
+*/
+void columnarAnalytics::loadUsers() {
+    struct userRow {
+        int userID;
+        string username;
+        string_view userType;
+        static auto columns() { return make_tuple(&userRow::userID, &userRow::username, &userRow::userType); }
+    };
+
+    db.forEach<userRow>("SELECT userID, username, userType FROM users;", [&](const userRow &row) {
+        int code = usernameCode(row.username);
+        regularUsers[code] = (row.userType == "regular");
+        userIDCodes[row.userID] = code;
+    });
+}
+
+/** @brief Loads the account columns.
+ *
+ *  Replaces the account columns with the current accounts table. Accounts are few next to transactions, so they are always read in full.
+ *  Each account's owner is found by userID, among the users just loaded.
+*/
+void columnarAnalytics::loadAccounts() {
+    accountIDs.clear();
+    accountUsers.clear();
+    balances.clear();
+    accountCurrencies.clear();
+    accountUserCodes.clear();
+
+    struct accountRow {
+        int accountID;
+        int userID;
+        double balance;
+        string currency;
+        static auto columns() { return make_tuple(&accountRow::accountID, &accountRow::userID, &accountRow::balance, &accountRow::currency); }
+    };
+
+    db.forEach<accountRow>("SELECT accountID, userID, balance, currency FROM accounts;", [&](const accountRow &row) {
+        unordered_map<int, int>::iterator owner = userIDCodes.find(row.userID);
+        if (owner == userIDCodes.end()) {
+            return;
+        }
+
+        // Currencies are few, so each gets a code the first time it is seen
+        unordered_map<string, int>::iterator currency = currencyCodes.find(row.currency);
+        if (currency == currencyCodes.end()) {
+            currency = currencyCodes.emplace(row.currency, (int)currencies.size()).first;
+            currencies.push_back(row.currency);
+        }
+
+        int code = owner->second;
+        accountIDs.push_back(row.accountID);
+        accountUsers.push_back(code);
+        balances.push_back(row.balance);
+        accountCurrencies.push_back(currency->second);
+        accountUserCodes[row.accountID] = code;
+    });
+}
+
+/** @brief Converts a total in each currency to the base currency.
+ *  @param currencyTotals One total per currency code.
+ *  @return The sum of the totals in the base currency, at the current exchange rates.
+*/
+double columnarAnalytics::toBaseCurrency(const vector<double> &currencyTotals) {
+    vector<currencyAmount> totals;
+    for (size_t i = 0; i < currencyTotals.size(); i++) {
+        totals.push_back({currencies[i], currencyTotals[i]});
+    }
+    double total = 0;
+    currencyRates().current()->total(totals, baseCurrency, total);
+    return total;
+}
+
+/** @brief Appends one side of a transaction to the transaction columns.
+ *  @param accountID The account the side is on.
+ *  @param type The transaction type the side counts as.
+ *  @param amount The amount, in the account's currency.
+ *  @param timestamp The time, in seconds since 1970.
+ *  @return Returns true if the side was appended, false if it is on one of the bank's system accounts.
+*/
+bool columnarAnalytics::appendTransaction(int accountID, const string &type, double amount, long long timestamp) {
+    if (accountID < 0) {
+        return false;
+    }
+
+    // Transaction types are few, so each gets a code the first time it is seen
+    int code = typeCode(type);
+    if (code < 0) {
+        code = (int)transactionTypes.size();
+        transactionTypes.push_back(type);
+        typeCodes[type] = code;
+    }
+
+    unordered_map<int, int>::iterator owner = accountUserCodes.find(accountID);
+    transactionAccounts.push_back(accountID);
+    transactionUsers.push_back(owner != accountUserCodes.end() ? owner->second : -1);
+    types.push_back(code);
+    amounts.push_back(amount);
+    timestamps.push_back(timestamp);
+    days.push_back((int)(timestamp / 86400));
+    return true;
+}
+
+/** @brief Appends new journal entries to the transaction columns.
+ *  @return The number of transactions appended.
+ *
+ *  Reads only the entries with an ID above the last one read, in ID order. Each entry is split into a row for the account it debits and
+ *  a row for the account it credits, so a transfer is scanned as a send and a receive, as budgeting counts it. Sides on the bank's system
+ *  accounts belong to no user and are skipped.
+*/
+int columnarAnalytics::loadTransactions() {
+    struct entryRow {
+        long long entryID;
+        int debitAccountID;
+        int creditAccountID;
+        string entryType;
+        double amount;
+        double creditAmount;
+        long long timestamp;
+        static auto columns() {
+            return make_tuple(&entryRow::entryID, &entryRow::debitAccountID, &entryRow::creditAccountID, &entryRow::entryType,
+                              &entryRow::amount, &entryRow::creditAmount, &entryRow::timestamp);
+        }
+    };
+
+    int added = 0;
+    auto append = [&](int accountID, const string &type, double amount, long long timestamp) {
+        added += appendTransaction(accountID, type, amount, timestamp) ? 1 : 0;
+    };
+
+    db.forEach<entryRow>("SELECT entryID, debitAccountID, creditAccountID, entryType, amount, creditAmount, CAST(strftime('%s', entryTime) AS INTEGER) "
+                         "FROM journal WHERE entryID > ? ORDER BY entryID;", [&](const entryRow &row) {
+        lastTransactionID = row.entryID;
+        bool transfer = row.entryType == "transfer";
+        append(row.debitAccountID, transfer ? "send" : row.entryType, row.amount, row.timestamp);
+        append(row.creditAccountID, transfer ? "receive" : row.entryType, row.creditAmount, row.timestamp);
+    }, lastTransactionID);
+    return added;
+}
+
+/** @brief Counts the entries sealed out of the journal.
+ *  @return The number of entries in sealed months, or 0 if no month has been sealed.
+*/
+long long columnarAnalytics::countSealedEntries() {
+    if (db.queryValue<int>("SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = 'partitions';").value_or(0) == 0) {
+        return 0;
+    }
+    return db.queryValue<long long>("SELECT COALESCE(SUM(rows), 0) FROM partitions;").value_or(0);
+}
+
+/** @brief Loads the totals of the months sealed out of the journal.
+ *
+ *  Each account's total for each transaction type in a sealed month becomes one row, dated the first day of the month. Sums by user and
+ *  type then add up the same as budgeting, which reads monthlyTotals the same way. Must be called before the journal is read, inside
+ *  the same database transaction, so no entry is counted in both.
+*/
+void columnarAnalytics::loadSealedTotals() {
+    struct totalRow {
+        int accountID;
+        string transactionType;
+        double total;
+        long long count;
+        long long timestamp;
+        static auto columns() {
+            return make_tuple(&totalRow::accountID, &totalRow::transactionType, &totalRow::total, &totalRow::count, &totalRow::timestamp);
+        }
+    };
+
+    sealedEntries = countSealedEntries();
+    if (sealedEntries == 0) {
+        return;
+    }
+    db.forEach<totalRow>("SELECT accountID, transactionType, total, count, CAST(strftime('%s', month || '-01') AS INTEGER) FROM monthlyTotals "
+                         "ORDER BY month, accountID;", [&](const totalRow &row) {
+        if (appendTransaction(row.accountID, row.transactionType, row.total, row.timestamp)) {
+            sealedRows++;
+            sealedSides += row.count;
+        }
+    });
+}
+
+/** @brief Totals the transactions of some types.
+ *  @param userCode The code of the user whose transactions are totalled, or -1 for every user.
+ *  @param wantedTypes The transaction types to include.
+ *  @return The total amount of the matching transactions.
+ *
+ *  Each thread scans its share of the columns with four separate running totals, which keeps the loop free of branches and lets the
+ *  additions overlap.
+*/
+double columnarAnalytics::sumTransactions(int userCode, const vector<string> &wantedTypes) {
+    vector<char> wanted(transactionTypes.size(), 0);
+    for (size_t i = 0; i < wantedTypes.size(); i++) {
+        int code = typeCode(wantedTypes[i]);
+        if (code >= 0) {
+            wanted[code] = 1;
+        }
+    }
+
+    vector<double> partials(numThreads, 0.0);
+    const int *users = transactionUsers.data();
+    const int *codes = types.data();
+    const double *amount = amounts.data();
+    const char *isWanted = wanted.data();
+
+    parallelScan(amounts.size(), numThreads, [&](unsigned int t, size_t begin, size_t end) {
+        double sums[4] = {0, 0, 0, 0};
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4) {
+            for (int lane = 0; lane < 4; lane++) {
+                bool match = isWanted[codes[i + lane]] && (userCode < 0 || users[i + lane] == userCode);
+                sums[lane] += match ? amount[i + lane] : 0.0;
+            }
+        }
+        for (; i < end; i++) {
+            bool match = isWanted[codes[i]] && (userCode < 0 || users[i] == userCode);
+            sums[0] += match ? amount[i] : 0.0;
+        }
+        partials[t] = sums[0] + sums[1] + sums[2] + sums[3];
+    });
+
+    double total = 0;
+    for (size_t t = 0; t < partials.size(); t++) {
+        total += partials[t];
+    }
+    return total;
+}
+
+/** @brief Totals transactions into groups.
+ *  @param keys The group of each transaction, from 0 to numKeys - 1, or -1 to leave the transaction out.
+ *  @param numKeys The number of groups.
+ *  @param typeFilter The code of the only transaction type to include, or -1 for every type.
+ *  @return The total amount of each group.
+ *
+ *  Each thread totals its share of the rows into its own groups, and the groups are added together at the end.
+*/
+vector<double> columnarAnalytics::groupTransactions(const vector<int> &keys, size_t numKeys, int typeFilter) {
+    vector<vector<double>> partials(numThreads);
+    const int *key = keys.data();
+    const int *codes = types.data();
+    const double *amount = amounts.data();
+
+    unsigned int used = parallelScan(amounts.size(), numThreads, [&](unsigned int t, size_t begin, size_t end) {
+        vector<double> &groups = partials[t];
+        groups.assign(numKeys, 0.0);
+        for (size_t i = begin; i < end; i++) {
+            if (key[i] >= 0 && (typeFilter < 0 || codes[i] == typeFilter)) {
+                groups[key[i]] += amount[i];
+            }
+        }
+    });
+
+    vector<double> totals(numKeys, 0.0);
+    for (unsigned int t = 0; t < used; t++) {
+        for (size_t k = 0; k < partials[t].size(); k++) {
+            totals[k] += partials[t][k];
+        }
+    }
+    return totals;
+}
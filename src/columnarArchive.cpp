@@ -0,0 +1,567 @@
+/** @brief Reads and writes compressed column files of old transactions.
+ *
+ *  This class stores transactions that will never change again in a compact file. Rows are grouped into blocks, and each block stores its
+ *  columns one after another: IDs and times as the difference from the row before, transaction types as one-byte codes into a list of
+ *  names, and amounts as whole cents, with the amount credited to the receiver kept as its difference from the amount, all as
+ *  variable-length integers, and then compressed with zlib. The file is mapped into memory for reading, and the index at the front gives
+ *  each block's smallest and largest time and account, so a read only decompresses the blocks that can hold rows it wants.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file columnarArchive.cpp
+ *  @class columnarArchive "../include/columnarArchive.h"
+ */
+
+#include "columnarArchive.h"
+
+using namespace std;
+
+static const char archiveMagic[4] = {'B', 'K', 'C', 'A'};
+static const unsigned int archiveVersion = 2;
+static const size_t headerSize = 4 + 4 + 4 + 4 + 8;
+static const size_t indexEntrySize = 8 + 4 + 4 + 4 + 8 * 4 + 4 + 4;
+
+/** @brief Appends a fixed-size value to a buffer
+ *
+ *  @param out Represents the buffer
+ *  @param value Represents the value, written in the machine's byte order
+ */
+template <typename T>
+static void putFixed(vector<unsigned char> &out, T value)
+{
+	unsigned char bytes[sizeof(T)];
+	memcpy(bytes, &value, sizeof(T));
+	out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+/** @brief Reads a fixed-size value from the mapped file
+ *
+ *  @param in Represents where the value starts
+ *  @return returns the value
+ */
+template <typename T>
+static T getFixed(const unsigned char *in)
+{
+	T value;
+	memcpy(&value, in, sizeof(T));
+	return value;
+}
+
+/** @brief Appends an unsigned variable-length integer
+ *
+ *  Seven bits are stored per byte, with the top bit set on every byte but the last, so small numbers take one byte.
+ *  @param out Represents the buffer
+ *  @param value Represents the value
+ */
+static void putVarint(vector<unsigned char> &out, unsigned long long value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((unsigned char)value);
+}
+
+/** @brief Appends a signed variable-length integer
+ *
+ *  Zigzag encoding maps small negative numbers to small unsigned ones: 0, -1, 1, -2 become 0, 1, 2, 3.
+ *  @param out Represents the buffer
+ *  @param value Represents the value
+ */
+static void putSigned(vector<unsigned char> &out, long long value)
+{
+	putVarint(out, ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63));
+}
+
+/** @brief Reads an unsigned variable-length integer
+ *
+ *  @param in Represents the read position, moved past the value
+ *  @param end Represents the end of the buffer
+ *  @param value Set to the value read
+ *  @return returns false if the buffer ends in the middle of the value
+ */
+static bool getVarint(const unsigned char *&in, const unsigned char *end, unsigned long long &value)
+{
+	value = 0;
+	for (int shift = 0; in < end && shift < 64; shift += 7)
+	{
+		unsigned char byte = *in++;
+		value |= (unsigned long long)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/** @brief Reads a signed variable-length integer
+ *
+ *  @param in Represents the read position, moved past the value
+ *  @param end Represents the end of the buffer
+ *  @param value Set to the value read
+ *  @return returns false if the buffer ends in the middle of the value
+ */
+static bool getSigned(const unsigned char *&in, const unsigned char *end, long long &value)
+{
+	unsigned long long raw;
+	if (!getVarint(in, end, raw))
+	{
+		return false;
+	}
+	value = (long long)(raw >> 1) ^ -(long long)(raw & 1);
+	return true;
+}
+
+/** @brief Turns a database time into seconds
+ *
+ *  @param time Represents a time as YYYY-MM-DD HH:MM:SS in UTC
+ *  @return returns the seconds since 1970, or 0 if the time can't be read
+ */
+long long parseTime(string_view time)
+{
+	string text(time);
+	struct tm parts = {};
+	if (sscanf(text.c_str(), "%d-%d-%d %d:%d:%d", &parts.tm_year, &parts.tm_mon, &parts.tm_mday, &parts.tm_hour, &parts.tm_min, &parts.tm_sec) < 3)
+	{
+		return 0;
+	}
+	parts.tm_year -= 1900;
+	parts.tm_mon -= 1;
+	return (long long)timegm(&parts);
+}
+
+/** @brief Turns seconds into a database time
+ *
+ *  @param seconds Represents the seconds since 1970
+ *  @return returns the time as YYYY-MM-DD HH:MM:SS in UTC
+ */
+string formatTime(long long seconds)
+{
+	time_t when = (time_t)seconds;
+	struct tm parts;
+	gmtime_r(&when, &parts);
+	char text[20];
+	strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &parts);
+	return text;
+}
+
+/** @brief Creates an archive reader with no file open
+ */
+columnarArchive::columnarArchive()
+{
+	fd = -1;
+	data = nullptr;
+	size = 0;
+	rowCount = 0;
+	version = 0;
+}
+
+/** @brief Unmaps the file
+ */
+columnarArchive::~columnarArchive()
+{
+	close();
+}
+
+/** @brief Maps an archive file and reads its index
+ *
+ *  @param path Represents the archive file
+ *  @return returns true if the file is a complete archive, false otherwise
+ */
+bool columnarArchive::open(const string &path)
+{
+	close();
+
+	fd = ::open(path.c_str(), O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < headerSize)
+	{
+		close();
+		return false;
+	}
+	size = (size_t)info.st_size;
+	void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapped == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	data = (const unsigned char *)mapped;
+
+	version = getFixed<unsigned int>(data + 4);
+	if (memcmp(data, archiveMagic, 4) != 0 || version < 1 || version > archiveVersion)
+	{
+		close();
+		return false;
+	}
+	unsigned int typeCount = getFixed<unsigned int>(data + 8);
+	unsigned int blockCount = getFixed<unsigned int>(data + 12);
+	rowCount = getFixed<unsigned long long>(data + 16);
+
+	// The list of transaction type names
+	size_t position = headerSize;
+	for (unsigned int i = 0; i < typeCount; i++)
+	{
+		if (position >= size || position + 1 + data[position] > size)
+		{
+			close();
+			return false;
+		}
+		types.emplace_back((const char *)data + position + 1, data[position]);
+		position += 1 + data[position];
+	}
+
+	// The block index
+	if (position + (size_t)blockCount * indexEntrySize > size)
+	{
+		close();
+		return false;
+	}
+	blocks.resize(blockCount);
+	for (unsigned int i = 0; i < blockCount; i++)
+	{
+		const unsigned char *entry = data + position + (size_t)i * indexEntrySize;
+		blockInfo &block = blocks[i];
+		block.offset = getFixed<unsigned long long>(entry);
+		block.compressedSize = getFixed<unsigned int>(entry + 8);
+		block.rawSize = getFixed<unsigned int>(entry + 12);
+		block.rows = getFixed<unsigned int>(entry + 16);
+		block.minID = getFixed<long long>(entry + 20);
+		block.maxID = getFixed<long long>(entry + 28);
+		block.minTime = getFixed<long long>(entry + 36);
+		block.maxTime = getFixed<long long>(entry + 44);
+		block.minAccount = getFixed<int>(entry + 52);
+		block.maxAccount = getFixed<int>(entry + 56);
+		if (block.offset + block.compressedSize > size)
+		{
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+/** @brief Unmaps the file
+ */
+void columnarArchive::close()
+{
+	if (data != nullptr)
+	{
+		munmap((void *)data, size);
+	}
+	if (fd >= 0)
+	{
+		::close(fd);
+	}
+	fd = -1;
+	data = nullptr;
+	size = 0;
+	rowCount = 0;
+	version = 0;
+	types.clear();
+	blocks.clear();
+}
+
+/** @brief Returns whether an archive is open
+ *
+ *  @return returns true if a file is mapped
+ */
+bool columnarArchive::isOpen() const
+{
+	return data != nullptr;
+}
+
+/** @brief Returns the number of rows
+ *
+ *  @return returns the number of transactions in the archive
+ */
+unsigned long long columnarArchive::getRowCount() const
+{
+	return rowCount;
+}
+
+/** @brief Returns the number of blocks
+ *
+ *  @return returns the number of blocks in the archive
+ */
+size_t columnarArchive::getBlockCount() const
+{
+	return blocks.size();
+}
+
+/** @brief Reads the rows that match a time range and account
+ *
+ *  Blocks whose time or account range can't match are skipped without being decompressed. A row matches an account it was sent from,
+ *  or one it was received into unless it is an old send row, which has its own receive row.
+ *  @param fromTime Represents the start of the range in seconds since 1970, included
+ *  @param toTime Represents the end of the range in seconds since 1970, not included
+ *  @param accountID Represents the account to read, or -1 for every account
+ *  @param visit Called with each matching row, in ID order
+ *  @return returns true if every block read was intact, false otherwise
+ */
+bool columnarArchive::forEach(long long fromTime, long long toTime, int accountID, const function<void(const transactionRecord &)> &visit)
+{
+	vector<unsigned char> raw;
+	vector<long long> ids, times, cents, creditCents;
+	vector<int> senders, receivers;
+	transactionRecord record;
+
+	for (size_t b = 0; b < blocks.size(); b++)
+	{
+		const blockInfo &block = blocks[b];
+		if (block.maxTime < fromTime || block.minTime >= toTime)
+		{
+			continue;
+		}
+		if (accountID >= 0 && (accountID < block.minAccount || accountID > block.maxAccount))
+		{
+			continue;
+		}
+
+		raw.resize(block.rawSize);
+		uLongf rawSize = block.rawSize;
+		if (uncompress(raw.data(), &rawSize, data + block.offset, block.compressedSize) != Z_OK || rawSize != block.rawSize)
+		{
+			return false;
+		}
+
+		// Decodes each column in turn
+		const unsigned char *in = raw.data();
+		const unsigned char *end = in + rawSize;
+		unsigned int rows = block.rows;
+		ids.resize(rows);
+		times.resize(rows);
+		senders.resize(rows);
+		receivers.resize(rows);
+		cents.resize(rows);
+		creditCents.resize(rows);
+
+		long long previous = 0;
+		for (unsigned int i = 0; i < rows; i++)
+		{
+			long long delta;
+			if (!getSigned(in, end, delta))
+			{
+				return false;
+			}
+			ids[i] = previous += delta;
+		}
+		previous = 0;
+		for (unsigned int i = 0; i < rows; i++)
+		{
+			long long delta;
+			if (!getSigned(in, end, delta))
+			{
+				return false;
+			}
+			times[i] = previous += delta;
+		}
+		previous = 0;
+		for (unsigned int i = 0; i < rows; i++)
+		{
+			long long delta;
+			if (!getSigned(in, end, delta))
+			{
+				return false;
+			}
+			senders[i] = (int)(previous += delta);
+		}
+		for (unsigned int i = 0; i < rows; i++)
+		{
+			long long value;
+			if (!getSigned(in, end, value))
+			{
+				return false;
+			}
+			receivers[i] = (int)value;
+		}
+		if (end - in < (ptrdiff_t)rows)
+		{
+			return false;
+		}
+		const unsigned char *typeCodes = in;
+		in += rows;
+		for (unsigned int i = 0; i < rows; i++)
+		{
+			if (!getSigned(in, end, cents[i]))
+			{
+				return false;
+			}
+		}
+		for (unsigned int i = 0; i < rows; i++)
+		{
+			long long difference = 0;
+			if (version >= 2 && !getSigned(in, end, difference))
+			{
+				return false;
+			}
+			creditCents[i] = cents[i] + difference;
+		}
+
+		for (unsigned int i = 0; i < rows; i++)
+		{
+			if (times[i] < fromTime || times[i] >= toTime || typeCodes[i] >= types.size())
+			{
+				continue;
+			}
+			if (accountID >= 0 && senders[i] != accountID && (receivers[i] != accountID || types[typeCodes[i]] == "send"))
+			{
+				continue;
+			}
+			record.transactionID = ids[i];
+			record.senderAccountID = senders[i];
+			record.receiverAccountID = receivers[i];
+			record.transactionType = types[typeCodes[i]];
+			record.amount = cents[i] / 100.0;
+			record.creditAmount = creditCents[i] / 100.0;
+			record.transactionTime = formatTime(times[i]);
+			visit(record);
+		}
+	}
+	return true;
+}
+
+/** @brief Writes rows to a new archive file
+ *
+ *  The file is written under a temporary name and renamed into place once complete, so a crash never leaves a partial archive.
+ *  @param path Represents the archive file to create
+ *  @param rows Represents the rows, in ID order
+ *  @param blockRows Represents the most rows in one block
+ *  @return returns true if the archive was written, false otherwise
+ */
+bool columnarArchive::write(const string &path, const vector<archivedTransaction> &rows, unsigned int blockRows)
+{
+	if (blockRows == 0)
+	{
+		blockRows = 4096;
+	}
+
+	// Gives each transaction type a one-byte code
+	vector<string> typeNames;
+	unordered_map<string, unsigned char> typeCodes;
+	for (size_t i = 0; i < rows.size(); i++)
+	{
+		if (typeCodes.count(rows[i].transactionType) == 0)
+		{
+			if (typeNames.size() == 256 || rows[i].transactionType.size() > 255)
+			{
+				return false;
+			}
+			typeCodes[rows[i].transactionType] = (unsigned char)typeNames.size();
+			typeNames.push_back(rows[i].transactionType);
+		}
+	}
+
+	vector<blockInfo> index;
+	vector<unsigned char> body;
+	vector<unsigned char> raw;
+	vector<unsigned char> compressed;
+	for (size_t start = 0; start < rows.size(); start += blockRows)
+	{
+		size_t stop = min(rows.size(), start + blockRows);
+		blockInfo block = {};
+		block.rows = (unsigned int)(stop - start);
+		block.minID = block.maxID = rows[start].transactionID;
+		block.minTime = block.maxTime = rows[start].timestamp;
+		block.minAccount = block.maxAccount = rows[start].senderAccountID;
+
+		raw.clear();
+		long long previous = 0;
+		for (size_t i = start; i < stop; i++)
+		{
+			putSigned(raw, rows[i].transactionID - previous);
+			previous = rows[i].transactionID;
+			block.minID = min(block.minID, rows[i].transactionID);
+			block.maxID = max(block.maxID, rows[i].transactionID);
+		}
+		previous = 0;
+		for (size_t i = start; i < stop; i++)
+		{
+			putSigned(raw, rows[i].timestamp - previous);
+			previous = rows[i].timestamp;
+			block.minTime = min(block.minTime, rows[i].timestamp);
+			block.maxTime = max(block.maxTime, rows[i].timestamp);
+		}
+		previous = 0;
+		for (size_t i = start; i < stop; i++)
+		{
+			putSigned(raw, rows[i].senderAccountID - previous);
+			previous = rows[i].senderAccountID;
+			block.minAccount = min(block.minAccount, rows[i].senderAccountID);
+			block.maxAccount = max(block.maxAccount, rows[i].senderAccountID);
+		}
+		for (size_t i = start; i < stop; i++)
+		{
+			putSigned(raw, rows[i].receiverAccountID);
+			block.minAccount = min(block.minAccount, rows[i].receiverAccountID);
+			block.maxAccount = max(block.maxAccount, rows[i].receiverAccountID);
+		}
+		for (size_t i = start; i < stop; i++)
+		{
+			raw.push_back(typeCodes[rows[i].transactionType]);
+		}
+		for (size_t i = start; i < stop; i++)
+		{
+			putSigned(raw, llround(rows[i].amount * 100.0));
+		}
+		for (size_t i = start; i < stop; i++)
+		{
+			putSigned(raw, llround(rows[i].creditAmount * 100.0) - llround(rows[i].amount * 100.0));
+		}
+
+		uLongf compressedSize = compressBound(raw.size());
+		compressed.resize(compressedSize);
+		if (compress2(compressed.data(), &compressedSize, raw.data(), raw.size(), Z_BEST_COMPRESSION) != Z_OK)
+		{
+			return false;
+		}
+		block.offset = body.size(); // Made absolute once the size of the index is known
+		block.compressedSize = (unsigned int)compressedSize;
+		block.rawSize = (unsigned int)raw.size();
+		body.insert(body.end(), compressed.begin(), compressed.begin() + compressedSize);
+		index.push_back(block);
+	}
+
+	vector<unsigned char> header;
+	header.insert(header.end(), archiveMagic, archiveMagic + 4);
+	putFixed<unsigned int>(header, archiveVersion);
+	putFixed<unsigned int>(header, (unsigned int)typeNames.size());
+	putFixed<unsigned int>(header, (unsigned int)index.size());
+	putFixed<unsigned long long>(header, rows.size());
+	for (size_t i = 0; i < typeNames.size(); i++)
+	{
+		header.push_back((unsigned char)typeNames[i].size());
+		header.insert(header.end(), typeNames[i].begin(), typeNames[i].end());
+	}
+	unsigned long long bodyStart = header.size() + index.size() * indexEntrySize;
+	for (size_t i = 0; i < index.size(); i++)
+	{
+		putFixed<unsigned long long>(header, bodyStart + index[i].offset);
+		putFixed<unsigned int>(header, index[i].compressedSize);
+		putFixed<unsigned int>(header, index[i].rawSize);
+		putFixed<unsigned int>(header, index[i].rows);
+		putFixed<long long>(header, index[i].minID);
+		putFixed<long long>(header, index[i].maxID);
+		putFixed<long long>(header, index[i].minTime);
+		putFixed<long long>(header, index[i].maxTime);
+		putFixed<int>(header, index[i].minAccount);
+		putFixed<int>(header, index[i].maxAccount);
+	}
+
+	string temporary = path + ".tmp";
+	FILE *out = fopen(temporary.c_str(), "wb");
+	if (out == nullptr)
+	{
+		return false;
+	}
+	bool ok = fwrite(header.data(), 1, header.size(), out) == header.size() &&
+			  fwrite(body.data(), 1, body.size(), out) == body.size() &&
+			  fflush(out) == 0 && fsync(fileno(out)) == 0;
+	ok = fclose(out) == 0 && ok;
+	if (!ok || rename(temporary.c_str(), path.c_str()) != 0)
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
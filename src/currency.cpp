@@ -0,0 +1,291 @@
+/** @brief Converts amounts between currencies
+ *
+ *  Accounts are held in a currency, and rates between currencies are read from a local rates file. Each time the file is replaced a new
+ *  rateTable is built and published in place of the old one, which is freed once nothing is using it. A table is never changed after it
+ *  is published, so readers don't lock anything: they only check the version number, and reuse the table they already hold until it
+ *  changes.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file currency.cpp
+ *  @class exchangeRates "../include/currency.h"
+ */
+
+#include "currency.h"
+
+using namespace std;
+
+static atomic<unsigned long long> publishedTables(0); // Numbers every table published by any exchangeRates, so no two share a version
+
+/** @brief Gives the accounts table its currency column
+ *
+ *  Accounts from before currencies were added are taken to be in the base currency.
+ *  @param db Represents the database the accounts are kept in
+ *  @return returns true if the column exists afterwards, false otherwise
+ */
+bool addCurrencyColumn(database &db)
+{
+	if (db.queryValue<int>("SELECT COUNT(*) FROM pragma_table_info('accounts') WHERE name = 'currency';").value_or(0) > 0)
+	{
+		return true;
+	}
+	return db.exec("ALTER TABLE accounts ADD COLUMN currency varchar(3) NOT NULL DEFAULT 'CAD';");
+}
+
+unsigned int rateTable::pack(string_view code)
+{
+	unsigned int packed = 0;
+	for (size_t i = 0; i < code.size() && i < 4; i++)
+	{
+		packed = packed << 8 | (unsigned char)code[i];
+	}
+	return packed;
+}
+
+/** @brief Creates a table holding only the base currency
+ */
+rateTable::rateTable()
+{
+	set(baseCurrency, 1);
+}
+
+/** @brief Sets a currency's rate
+ *
+ *  Only called while the table is being built, before it is published.
+ *  @param code Represents the currency's code
+ *  @param rate Represents what one unit is worth in the base currency
+ *  @return returns true if the rate is valid
+ */
+bool rateTable::set(string_view code, double rate)
+{
+	if (code.empty() || code.size() > 3 || !(rate > 0))
+	{
+		return false;
+	}
+	unsigned int packed = pack(code);
+	for (size_t i = 0; i < codes.size(); i++)
+	{
+		if (codes[i] == packed)
+		{
+			rates[i] = rate;
+			return true;
+		}
+	}
+	codes.push_back(packed);
+	rates.push_back(rate);
+	return true;
+}
+
+double rateTable::getRate(string_view code) const
+{
+	unsigned int packed = pack(code);
+	for (size_t i = 0; i < codes.size(); i++)
+	{
+		if (codes[i] == packed)
+		{
+			return rates[i];
+		}
+	}
+	return 0;
+}
+
+/** @brief Converts an amount from one currency to another
+ *
+ *  @param amount Represents the amount, in from
+ *  @param from Represents the currency the amount is in
+ *  @param to Represents the currency to convert to
+ *  @param result Represents where the converted amount is stored
+ *  @return returns true if both currencies are known
+ */
+bool rateTable::convert(double amount, string_view from, string_view to, double &result) const
+{
+	if (from == to)
+	{
+		result = amount;
+		return true;
+	}
+	double fromRate = getRate(from);
+	double toRate = getRate(to);
+	if (fromRate == 0 || toRate == 0)
+	{
+		return false;
+	}
+	result = amount * fromRate / toRate;
+	return true;
+}
+
+/** @brief Adds up amounts held in any number of currencies
+ *
+ *  Every currency's rate is looked up first, and the amounts are then multiplied by their rates and added in one pass over two flat
+ *  arrays, which the compiler turns into vector instructions.
+ *  @param amounts Represents the amounts, usually one subtotal per currency
+ *  @param to Represents the currency the total is given in
+ *  @param result Represents where the total is stored
+ *  @return returns true if every currency is known
+ */
+bool rateTable::total(span<const currencyAmount> amounts, string_view to, double &result) const
+{
+	double toRate = getRate(to);
+	if (toRate == 0)
+	{
+		return false;
+	}
+
+	bool known = true;
+	vector<double> values(amounts.size());
+	vector<double> factors(amounts.size());
+	for (size_t i = 0; i < amounts.size(); i++)
+	{
+		values[i] = amounts[i].amount;
+		factors[i] = getRate(amounts[i].currency);
+		known = known && factors[i] != 0;
+	}
+
+	double sum = 0;
+	const double *value = values.data();
+	const double *factor = factors.data();
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		sum += value[i] * factor[i];
+	}
+	result = sum / toRate;
+	return known;
+}
+
+/** @brief Reads a rates file
+ *
+ *  @param path Represents the file
+ *  @return returns the table, or nullptr if the file can't be read or has a bad line
+ */
+shared_ptr<const rateTable> rateTable::load(const string &path)
+{
+	ifstream file(path);
+	if (!file)
+	{
+		return nullptr;
+	}
+
+	shared_ptr<rateTable> table = make_shared<rateTable>();
+	string line;
+	while (getline(file, line))
+	{
+		size_t start = line.find_first_not_of(" \t\r");
+		if (start == string::npos || line[start] == '#')
+		{
+			continue;
+		}
+		char code[8];
+		double rate;
+		if (sscanf(line.c_str() + start, "%7s %lf", code, &rate) != 2 || !table->set(code, rate))
+		{
+			cout << "Bad line in " << path << ": " << line << endl;
+			return nullptr;
+		}
+	}
+	return table;
+}
+
+/** @brief Loads the rates, and keeps them up to date
+ *
+ *  If the file doesn't exist, only the base currency can be used until it does.
+ *  @param path Represents the rates file
+ *  @param background Represents whether to start a thread that checks the file every second. Without one, refresh has to be called.
+ */
+exchangeRates::exchangeRates(string path, bool background)
+{
+	this->path = path;
+	loaded = {};
+	stopping = false;
+	table.store(make_shared<const rateTable>());
+	version.store(++publishedTables);
+	refresh();
+
+	if (background)
+	{
+		worker = thread(&exchangeRates::work, this);
+	}
+}
+
+exchangeRates::~exchangeRates()
+{
+	{
+		lock_guard<mutex> guard(stateLock);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+}
+
+/** @brief Publishes a new table if the rates file has been replaced
+ *
+ *  A file that can't be read leaves the current table in place. Callers and the background worker take turns, so a replaced file is
+ *  only loaded and published once.
+ *  @return returns true if a new table was published
+ */
+bool exchangeRates::refresh()
+{
+	lock_guard<mutex> guard(refreshLock);
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0 ||
+		(info.st_ino == loaded.st_ino && info.st_size == loaded.st_size && info.st_mtim.tv_sec == loaded.st_mtim.tv_sec &&
+		 info.st_mtim.tv_nsec == loaded.st_mtim.tv_nsec))
+	{
+		return false;
+	}
+
+	shared_ptr<const rateTable> next = rateTable::load(path);
+	loaded = info;
+	if (next == nullptr)
+	{
+		return false;
+	}
+	table.store(next);
+	version.store(++publishedTables, memory_order_release);
+	return true;
+}
+
+/** @brief Returns the newest table
+ *
+ *  Each thread keeps the table it last used, and only loads the shared one again once the version has changed, so the usual cost is
+ *  reading one number.
+ *  @return returns the table
+ */
+shared_ptr<const rateTable> exchangeRates::current()
+{
+	thread_local unsigned long long seen = 0;
+	thread_local shared_ptr<const rateTable> cached;
+
+	unsigned long long latest = version.load(memory_order_acquire);
+	if (seen != latest)
+	{
+		cached = table.load();
+		seen = latest;
+	}
+	return cached;
+}
+
+/** @brief Checks the rates file every second until the rates are destroyed
+ */
+void exchangeRates::work()
+{
+	unique_lock<mutex> guard(stateLock);
+	while (!stopping)
+	{
+		guard.unlock();
+		refresh();
+		guard.lock();
+		wakeUp.wait_for(guard, chrono::seconds(1), [this]
+						{ return stopping; });
+	}
+}
+
+/** @brief Returns the rates this process converts with
+ *
+ *  @return returns the rates read from the configured rates file
+ */
+exchangeRates &currencyRates()
+{
+	static exchangeRates rates(bankSettings().ratesPath);
+	return rates;
+}
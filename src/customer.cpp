@@ -11,75 +11,97 @@
 
 using namespace std;
 
-/** @brief Helps with executing sql.
- *
- *  This function is used when executing sql statements.
- *  @param unused This variable is not used and serves no purpose.
- *  @param numColumns The number of columns in the table.
- *  @param value List of the values from the current row from each column.
- *  @param columns Name of each column in the table.
- *  @return Always returns to fit the base necessities.
- */
-static int callback(void *unused, int numColumns, char **value, char **columns)
-{
-	for (int i = 0; i < numColumns; i++)
-	{
-		cout << "Name = " << columns[i] << "   Value = " << value[i] << endl;
-	}
-	return 0;
-}
-
 /** @brief Opens the database and fetches all existing accounts
  *
- *  Takes in a username, opens the database, and stores all accounts under the user into the accounts vector
+ *  Takes in a username, opens the database, looks up the user's ID once, and stores all accounts under the user into the accounts vector
  *
  *  @param username Represents the username of the regular user
+ *  @param resource Represents the memory the customer's accounts and indexes are allocated from
+ *  @param config Represents the settings the database is opened with
  */
-customer::customer(string username)
+customer::customer(string username, pmr::memory_resource *resource, const bankConfig &config)
+	: DB(new database()), accounts(resource), accountsByID(resource)
 {
-	this->username = username;
-
-	rc = sqlite3_open("newDatabase.db", &DB);
-
-	// Stores a list of all account types under the user.
-	vector<string> accountTypes;
-
-	// Runs a query to get the account types of the user, and for each one, stores the account type in the accountType vector.
-	sqlite3_stmt *stmt;
-	sql = "SELECT accountType FROM accounts WHERE username = \"" + username + "\";";
-	sqlite3_prepare_v2(DB, sql.c_str(), sql.length(), &stmt, nullptr);
+	this->username = move(username);
+	config.open(*DB);
+	addUserIDs(*DB);
+	createIdempotencyKeys(*DB);
+	createBalanceCheckpoints(*DB);
+	userID = userIDs().find(*DB, this->username);
+
+	// Fetches every account the user owns, and the user's data, and stores them.
+	accountsByKind.fill(-1);
+	loadAccounts();
+	storeValues();
+}
 
-	while (sqlite3_step(stmt) != SQLITE_DONE)
-	{
-		string fetchedAccountType = string(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)));
-		accountTypes.push_back(fetchedAccountType);
-	}
+/** @brief Takes over another customer's accounts and database connection
+ *
+ *  @param other Represents the customer being moved from. It is left without a database connection or accounts. The accounts keep
+ *  pointing at the same connection, since it is held by pointer and doesn't move.
+ */
+customer::customer(customer &&other) noexcept
+	: user(move(other)), DB(move(other.DB)), userID(other.userID), creditScore(other.creditScore), loanDebt(other.loanDebt), money(other.money),
+	  accounts(move(other.accounts)), accountsByID(move(other.accountsByID)), accountsByKind(other.accountsByKind)
+{
+}
 
-	// For each account type the user possesses, creates the account object, and adds it to the account list.
-	if (accountTypes.size() > 0)
+/** @brief Takes over another customer's accounts and database connection
+ *
+ *  @param other Represents the customer being moved from. It is left without a database connection or accounts.
+ *  @return returns this customer
+ */
+customer &customer::operator=(customer &&other) noexcept
+{
+	if (this != &other)
 	{
-		for (int i = 0; i < accountTypes.size(); i++)
-		{
-			account temp(accountTypes[i], username);
-			accounts.push_back(temp);
-		}
+		user::operator=(move(other));
+		DB = move(other.DB);
+		userID = other.userID;
+		creditScore = other.creditScore;
+		loanDebt = other.loanDebt;
+		money = other.money;
+		accounts = move(other.accounts);
+		accountsByID = move(other.accountsByID);
+		accountsByKind = other.accountsByKind;
 	}
-
-	sqlite3_finalize(stmt);
-
-	// fetches the user's data and stores it.
-	storeValues();
+	return *this;
 }
 
 /** @brief destructor for the customer object
  *
- *  This method is a destructor that will destroy the customer object onece it's no longer used.
+ *  This method is a destructor that will destroy the customer object onece it's no longer used, and closes the database connection
+ *  its accounts shared.
  *
  */
 customer::~customer()
 {
 }
 
+/** @brief Returns every account the user owns
+ *
+ *  @return returns the user's accounts, in no particular order
+ */
+const pmr::vector<account> &customer::getAccounts() const
+{
+	return accounts;
+}
+
+/** @brief Returns one of the user's accounts
+ *
+ *  @param accountID Represents the ID of the account
+ *  @return returns the account, or nullptr if the user doesn't own an account with that ID
+ */
+account *customer::getAccount(int accountID)
+{
+	auto found = accountsByID.find(accountID);
+	if (found == accountsByID.end())
+	{
+		return nullptr;
+	}
+	return &accounts[found->second];
+}
+
 /** @brief Returns the credit score of the user
  *
  *  This method returns the user's credit score.
@@ -94,18 +116,33 @@ int customer::getCreditScore()
 /** @brief Returns the total amount of money from all accounts
  *
  *  This method iterates through the user's list of accounts, takes the balance from each one, and adds it to the money variable, which is then
- *  returned to the user
- *  @return returns total money the user has across all accounts
+ *  returned to the user. Balances held in other currencies are converted to the base currency at the current rates.
+ *  @return returns total money the user has across all accounts, in the base currency
  *
  */
 double customer::getMoney()
 {
-	money = 0;
+	// Iterates through the user's account list, and adds their balances up by currency.
+	vector<currencyAmount> totals;
+	for (size_t i = 0; i < accounts.size(); i++)
+	{
+		size_t j = 0;
+		while (j < totals.size() && totals[j].currency != accounts[i].getCurrency())
+		{
+			j++;
+		}
+		if (j == totals.size())
+		{
+			totals.push_back({string(accounts[i].getCurrency()), 0});
+		}
+		totals[j].amount += accounts[i].getBalance();
+	}
 
-	// Iterates through the user's account list, and adds their balances to money.
-	for (int i = 0; i < accounts.size(); i++)
+	// Converts the totals to the base currency together.
+	money = 0;
+	if (!currencyRates().current()->total(totals, baseCurrency, money))
 	{
-		money += accounts[i].getBalance();
+		cout << "Some of your accounts are in a currency with no exchange rate." << endl;
 	}
 	return money;
 }
@@ -129,17 +166,31 @@ double customer::getLoanDebt()
  *  @return returns the account balance from the account of the specified account type.
  *
  */
-double customer::checkAccountBalance(string accountType)
+double customer::checkAccountBalance(string_view accountType)
 {
+	accountKind kind;
+	if (!parseAccountKind(accountType, kind))
+	{
+		return 0;
+	}
+	return checkAccountBalance(kind);
+}
 
-	// Iterates through the accounts list to find an account with the specified account type.
-	for (int i = 0; i < accounts.size(); i++)
+/** @brief returns the balance of the user account
+ *
+ *  This method takes in an account type, looks for the specified account,
+ *  and returns the balance of that account. If it doesn't exist, it returns 0.
+ *  @param kind Represents which account type the user is fetching the balance from
+ *  @return returns the account balance from the account of the specified account type.
+ *
+ */
+double customer::checkAccountBalance(accountKind kind)
+{
+	// If there is a match, returns the balance of that account.
+	account *found = findAccount(kind);
+	if (found != nullptr)
 	{
-		// If there is a match, returns the balance of that account.
-		if (accounts[i].getAccountType().compare(accountType) == 0)
-		{
-			return accounts[i].getBalance();
-		}
+		return found->getBalance();
 	}
 	return 0;
 }
@@ -149,24 +200,47 @@ double customer::checkAccountBalance(string accountType)
  *  This method takes in an account type and initial deposit value. It searches the user's account list to make sure there are no other accounts of *  the same type. If so, it creates a new account with that type, and adds it to the user's account list
  *  @param accountType Represents the type of account the customer wants to open
  *  @param smoney Represents the initial deposit into the new account
- *  @return returns total money the user has across all accounts
+ *  @param currency Represents the code of the currency the account is held in
+ *  @return returns true if the account was opened, false if the type or currency is unknown or the customer already has one
  *
  */
-bool customer::createAccount(string accountType, double smoney)
+bool customer::createAccount(string_view accountType, double smoney, string_view currency)
 {
-	// Iterates through the accounts list to see if the account type already exists
-	for (int i = 0; i < accounts.size(); i++)
+	accountKind kind;
+	if (!parseAccountKind(accountType, kind))
 	{
-		// If so, return false
-		if (accounts[i].getAccountType().compare(accountType) == 0)
-		{
-			return false;
-		}
+		return false;
+	}
+	return createAccount(kind, smoney, currency);
+}
+
+/** @brief creates a new account for the customer
+ *
+ *  This method takes in an account type and initial deposit value. It searches the user's account list to make sure there are no other accounts of *  the same type. If so, it creates a new account with that type, and adds it to the user's account list
+ *  @param kind Represents the type of account the customer wants to open
+ *  @param smoney Represents the initial deposit into the new account
+ *  @param currency Represents the code of the currency the account is held in
+ *  @return returns true if the account was opened, false if the currency is unknown, the customer already has one, or the customer
+ *  doesn't exist, or it
+ *  couldn't be written
+ *
+ */
+bool customer::createAccount(accountKind kind, double smoney, string_view currency)
+{
+	// If the user doesn't exist, the account type already exists, or there is no rate for the currency, return false
+	if (userID < 0 || findAccount(kind) != nullptr || currencyRates().current()->getRate(currency) == 0)
+	{
+		return false;
 	}
 
-	// Otherwise, create the new account, and add it to the account list.
-	account newAccount(accountType, username, smoney);
-	accounts.push_back(newAccount);
+	// Otherwise, create the new account in place in the account list, and drop it again if it couldn't be written.
+	accounts.emplace_back(DB.get(), kind, userID, username, smoney, currency, accounts.get_allocator().resource());
+	if (accounts.back().getID() <= 0)
+	{
+		accounts.pop_back();
+		return false;
+	}
+	indexAccount(accounts.size() - 1);
 
 	return true;
 }
@@ -174,35 +248,61 @@ bool customer::createAccount(string accountType, double smoney)
 /** @brief deletes a customer account
  *
  *  This method takes in an account type. It searches the user's account list for the specified account, and if found, deletes its record
- *  from the accounts table, and deletes all transactions associated with that account.
+ *  from the accounts table, and queues the account so its journal entries are detached in the background.
  *  Returns true upon success, and false if the account wasn't found.
  *  @param accountType Represents the type of account the customer wants to delete
  *  @return returns true if the account exists and is deleted, false otherwise.
  *
  */
-bool customer::deleteAccount(string accountType)
+bool customer::deleteAccount(string_view accountType)
 {
-	char *errorMessage = 0;
+	accountKind kind;
+	if (!parseAccountKind(accountType, kind))
+	{
+		return false;
+	}
+	return deleteAccount(kind);
+}
 
-	// Iterates through the accounts list to find the specified account
-	for (int i = 0; i < accounts.size(); i++)
+/** @brief deletes a customer account
+ *
+ *  This method takes in an account type. It searches the user's account list for the specified account, and if found, deletes its record
+ *  from the accounts table, and queues the account so its journal entries are detached in the background by accountPurger.
+ *  Returns true upon success, and false if the account wasn't found.
+ *  @param kind Represents the type of account the customer wants to delete
+ *  @return returns true if the account exists and is deleted, false otherwise.
+ *
+ */
+bool customer::deleteAccount(accountKind kind)
+{
+	int position = accountsByKind[(int)kind];
+	if (position < 0)
 	{
-		// If it exists, deletes the account's records from accounts, as well as its transactions from the transactions table.
-		if (accounts[i].getAccountType().compare(accountType) == 0)
-		{
-			sql = "DELETE FROM transactions WHERE senderAccountID = " + to_string(accounts[i].getID()) + ";";
-			rc = sqlite3_exec(DB, sql.c_str(), callback, 0, &errorMessage);
+		return false;
+	}
 
-			sql = "DELETE FROM accounts WHERE username = \"" + username + "\" AND accountType = \"" + accountType + "\";";
-			rc = sqlite3_exec(DB, sql.c_str(), callback, 0, &errorMessage);
+	// Deletes the account's row and queues its journal entries for the accountPurger, which detaches them in small batches later. Doing
+	// it here would hold the write lock for as long as the account's history is long.
+	int accountID = accounts[position].getID();
+	createPurgeQueue(*DB);
+	DB->exec("BEGIN;");
+	if (!DB->run("INSERT OR IGNORE INTO purgeQueue (accountID) VALUES (?);", accountID) ||
+		!DB->run("DELETE FROM accounts WHERE accountID = ?;", accountID))
+	{
+		cout << "Could not delete account: " << DB->getError() << endl;
+		DB->exec("ROLLBACK;");
+		return false;
+	}
+	if (!changeFeed().commit(*DB, {{changeType::accountClosed, accountID, 0, 0, username}}))
+	{
+		return false;
+	}
 
-			// Removes the account from the accounts list.
-			accounts.erase(accounts.begin() + i);
+	// Removes the account from the accounts list, and its recent transfers from fraud screening.
+	fraudScoring().forget(accountID);
+	removeAccount(position);
 
-			return true;
-		}
-	}
-	return false;
+	return true;
 }
 
 /** @brief sends money to another account
@@ -211,67 +311,166 @@ bool customer::deleteAccount(string accountType)
  *  from the accounts table, and deletes all transactions associated with that account.
  *  @param senderAccountID Represents sender account ID
  *  @param receiverAccountID Represents receiver account ID
- *  @param amount Represents the amount of the money the customer wants to send
- *  @return returns true if the user has enough funds, the sender/receiver account ID exists, and the SQL statements run successfully,
- *  false otherwise.
+ *  @param amount Represents the amount of the money the customer wants to send, in the sender account's currency. The receiver gets it
+ *  converted to their account's currency.
+ *  @param idempotencyKey Represents a key chosen by the client, so a retry with the same key returns the first call's result without
+ *  sending the money again, or an empty string
+ *  @return returns true if the user owns the sender account and has enough funds in it, the receiver account ID exists, the transfer
+ *  passes fraud screening, and the SQL statements run successfully, or if a transfer with the key was already made, false otherwise.
  */
-bool customer::transaction(int senderAccountID, int receiverAccountID, double amount)
+bool customer::transaction(int senderAccountID, int receiverAccountID, double amount, string_view idempotencyKey)
 {
-	sqlite3_stmt *stmt;
-	int idExists = 0;	// flag to track if the specified receiver account exists.
-	double balance = 0; // stores the balance of the sender account
+	double balance = 0;  // stores the balance of the sender account
+	double received = 0; // stores the amount the receiver gets, in the receiver account's currency
 
-	// Iterates through the accounts list, looks for the sender account, and compares its balance with the user amount
-	for (int i = 0; i < accounts.size(); i++)
+	// Looks up the sender account among the user's accounts, and compares its balance with the user amount
+	account *sender = getAccount(senderAccountID);
+	if (sender == nullptr)
 	{
-		if (accounts[i].getID() == senderAccountID)
-		{
-			balance = accounts[i].getBalance();
-
-			// Returns false if the user doesn't have enough funds in the account.
-			if (balance < amount)
-			{
-				cout << "Not enough funds remaining." << endl;
-				return false;
-			}
-		}
+		cout << "This account doesn't belong to you!" << endl;
+		return false;
+	}
+
+	// A retry of a transfer that was already made returns its result, even if the money it sent leaves too little for it now
+	idempotentCall call{"transfer", senderAccountID, receiverAccountID, amount};
+	idempotencyResult earlier = idempotencyKeys().check(*DB, idempotencyKey, call);
+	if (earlier != idempotencyResult::fresh)
+	{
+		return replayEarlier(earlier);
 	}
 
-	// Queries the database to see if the receiver account exists.
-	sql = "SELECT COUNT(*) FROM accounts WHERE accountID = " + to_string(receiverAccountID) + ";";
-	sqlite3_prepare_v2(DB, sql.c_str(), sql.length(), &stmt, nullptr);
-	step = sqlite3_step(stmt);
+	// The transfer is checked and made in one database transaction, which takes the write lock first, so another connection can't spend
+	// or hold the same funds between the check and the transfer.
+	if (!DB->exec("BEGIN IMMEDIATE;"))
+	{
+		cout << "Transaction Failed: " << DB->getError() << endl;
+		return false;
+	}
 
-	idExists = (sqlite3_column_int(stmt, 0));
+	// Funds held for card authorizations can't be sent
+	balance = sender->getAvailableBalance();
 
-	sqlite3_finalize(stmt);
+	// Returns false if the user doesn't have enough funds in the account.
+	if (balance < amount)
+	{
+		DB->exec("ROLLBACK;");
+		cout << "Not enough funds remaining." << endl;
+		return false;
+	}
 
-	// If the account exists, sends money to the receiver account, while updating account balances on both ends, and adding the transaction
-	// to the transactions table
-	if (idExists == 1)
+	// Queries the database to see if the receiver account exists, and which currency it is held in. An account the existence filters
+	// have never seen is turned away without the query.
+	optional<string> receiverCurrency;
+	if (existenceFilters().mightHaveAccount(receiverAccountID))
 	{
-		char *errorMessage = 0;
+		receiverCurrency = DB->queryValue<string>("SELECT currency FROM accounts WHERE accountID = ?;", receiverAccountID);
+	}
+	if (!receiverCurrency)
+	{
+		DB->exec("ROLLBACK;");
+		cout << "This account doesn't exist!" << endl;
+		return false;
+	}
 
-		sql = "INSERT INTO transactions(senderAccountID, receiverAccountID, transactionType, amount) VALUES (" + to_string(senderAccountID) + ", " + to_string(receiverAccountID) + ", \"send\", " + to_string(amount) + ");";
-		rc = sqlite3_exec(DB, sql.c_str(), callback, 0, &errorMessage);
+	// Converts the amount into the receiver's currency, if it is different.
+	if (!currencyRates().current()->convert(amount, sender->getCurrency(), *receiverCurrency, received))
+	{
+		DB->exec("ROLLBACK;");
+		cout << "No exchange rate from " << sender->getCurrency() << " to " << *receiverCurrency << "." << endl;
+		return false;
+	}
 
-		sql = "UPDATE accounts SET balance = balance - " + to_string(amount) + " WHERE accountID = " + to_string(senderAccountID) + ";";
-		rc = sqlite3_exec(DB, sql.c_str(), callback, 0, &errorMessage);
+	// Scores the transfer against the sender's recent transfers. A suspicious transfer is held for review instead of being sent,
+	// and a clearly fraudulent one is refused.
+	fraudDecision decision = screenTransfer(*DB, senderAccountID, receiverAccountID, amount);
+	if (decision == fraudDecision::reject)
+	{
+		DB->exec("ROLLBACK;");
+		cout << "Transaction Rejected." << endl;
+		return false;
+	}
+	if (decision == fraudDecision::hold)
+	{
+		if (!DB->exec("COMMIT;"))
+		{
+			DB->exec("ROLLBACK;");
+		}
+		cout << "Transaction Held For Review." << endl;
+		return false;
+	}
 
-		sql = "INSERT INTO transactions(senderAccountID, transactionType, amount) VALUES (" + to_string(receiverAccountID) + ", \"receive\", " + to_string(amount) + ");";
-		rc = sqlite3_exec(DB, sql.c_str(), callback, 0, &errorMessage);
+	// The transfer is one journal entry, which takes the money from the sender and gives it to the receiver together, and claims
+	// the key with it.
+	long long entryID = postEntry(*DB, "transfer", senderAccountID, receiverAccountID, amount, received);
+	if (entryID < 0)
+	{
+		cout << "Transaction Failed: " << DB->getError() << endl;
+		DB->exec("ROLLBACK;");
+		return false;
+	}
+	earlier = idempotencyKeys().claim(*DB, idempotencyKey, call, entryID);
+	if (earlier != idempotencyResult::fresh)
+	{
+		DB->exec("ROLLBACK;");
+		return replayEarlier(earlier);
+	}
+	if (!changeFeed().commit(*DB, {{changeType::transfer, senderAccountID, receiverAccountID, amount, username}}))
+	{
+		return false;
+	}
+	idempotencyKeys().remember(idempotencyKey, call, entryID);
 
-		sql = "UPDATE accounts SET balance = balance + " + to_string(amount) + " WHERE accountID = " + to_string(receiverAccountID) + ";";
-		rc = sqlite3_exec(DB, sql.c_str(), callback, 0, &errorMessage);
+	cout << "Transaction Completed." << endl;
+	return true;
+}
 
-		cout << "Transaction Completed." << endl;
-		return true;
+/** @brief Schedules a payment from one of the customer's accounts
+ *
+ *  The payment is made by the paymentScheduler when it falls due, and again at each frequency after that.
+ *  @param senderAccountID Represents the customer's account the money is sent from
+ *  @param receiverAccountID Represents the account the money is sent to
+ *  @param amount Represents the amount sent each time
+ *  @param firstDue Represents when the first payment is made, as YYYY-MM-DD HH:MM:SS in UTC
+ *  @param frequency Represents how often the payment repeats: once, daily, weekly or monthly
+ *  @param runs Represents how many payments are made, or -1 to keep paying until the payment is cancelled
+ *  @return returns the payment's ID, or -1 if the customer doesn't own the sender account, the receiver account doesn't exist, or
+ *  the time or frequency isn't valid
+ */
+long long customer::schedulePayment(int senderAccountID, int receiverAccountID, double amount, string_view firstDue, string_view frequency, int runs)
+{
+	paymentFrequency parsedFrequency;
+	long long due = parseTime(firstDue);
+	if (getAccount(senderAccountID) == nullptr)
+	{
+		cout << "This account doesn't belong to you!" << endl;
+		return -1;
 	}
-	else
+	if (!existenceFilters().mightHaveAccount(receiverAccountID) ||
+		DB->queryValue<int>("SELECT COUNT(*) FROM accounts WHERE accountID = ?;", receiverAccountID).value_or(0) != 1)
 	{
 		cout << "This account doesn't exist!" << endl;
-		return false;
+		return -1;
+	}
+	if (amount <= 0 || due == 0 || runs == 0 || !parsePaymentFrequency(frequency, parsedFrequency))
+	{
+		cout << "Invalid payment." << endl;
+		return -1;
 	}
+	return ::schedulePayment(*DB, senderAccountID, receiverAccountID, amount, due, parsedFrequency, runs);
+}
+
+/** @brief Cancels one of the customer's scheduled payments
+ *
+ *  @param paymentID Represents the payment's ID
+ *  @return returns true if the payment was sent from one of the customer's accounts and hadn't finished, false otherwise
+ */
+bool customer::cancelPayment(long long paymentID)
+{
+	createScheduledPayments(*DB);
+	return DB->run("UPDATE scheduledPayments SET active = 0, lastError = \"cancelled\" WHERE paymentID = ? AND active = 1 AND "
+				   "senderAccountID IN (SELECT accountID FROM accounts WHERE userID = ?);",
+				   paymentID, userID) &&
+		   DB->changes() == 1;
 }
 
 /** @brief Fetches the customer information from the database
@@ -281,69 +480,127 @@ bool customer::transaction(int senderAccountID, int receiverAccountID, double am
  */
 void customer::storeValues()
 {
-	// Declares the statement object
-	sqlite3_stmt *stmt;
+	// The customer's data, in the order it is selected
+	struct userRow
+	{
+		string password;
+		string name;
+		int creditScore;
+		double loanDebt;
+		string userType;
+		static auto columns() { return make_tuple(&userRow::password, &userRow::name, &userRow::creditScore, &userRow::loanDebt, &userRow::userType); }
+	};
 
 	// Retrieves the customer's password, name, credit score, loan debt, and user type
-	sql = "SELECT password, name, creditScore, loanDebt, userType FROM users WHERE username = \"" + username + "\";";
-	sqlite3_prepare_v2(DB, sql.c_str(), sql.length(), &stmt, nullptr);
-
-	// Runs the statement
-	step = sqlite3_step(stmt);
-
-	// Parses the returned row, and stores each value in its respective data members
-	password = string(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)));
-	name = string(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)));
-	creditScore = (sqlite3_column_int(stmt, 2));
-	loanDebt = (sqlite3_column_double(stmt, 3));
-	userType = string(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 4)));
+	optional<userRow> row = DB->queryRow<userRow>("SELECT password, name, creditScore, loanDebt, userType FROM users WHERE userID = ?;", userID);
 
-	// Destroys the statement object
-	sqlite3_finalize(stmt);
+	// Stores each value in its respective data members
+	if (row)
+	{
+		password = move(row->password);
+		name = move(row->name);
+		creditScore = row->creditScore;
+		loanDebt = row->loanDebt;
+		userType = move(row->userType);
+	}
+	else
+	{
+		creditScore = 0;
+		loanDebt = 0;
+	}
 }
 
-/** @brief Opens the database and fetches all existing accounts.
+/** @brief Fetches all existing accounts of another user.
  *
- *  Takes in a username, opens the database, and stores all accounts under the user into the accounts vector. This method is used
- *  for GUI purposes
+ *  Takes in a username, and stores all accounts under the user into the accounts vector, using the connection the customer was
+ *  built with. This method is used for GUI purposes
  *  @param username Represents the username of the regular user
  */
 void customer::fill(string username)
 {
-	this->username = username;
-
-	rc = sqlite3_open("newDatabase.db", &DB);
+	this->username = move(username);
+	userID = userIDs().find(*DB, this->username);
 
-	vector<string> accountTypes;
+	accounts.clear();
+	accountsByID.clear();
+	accountsByKind.fill(-1);
+	loadAccounts();
 
-	sqlite3_stmt *stmt;
-	sql = "SELECT accountType FROM accounts WHERE username = \"" + username + "\";";
-	sqlite3_prepare_v2(DB, sql.c_str(), sql.length(), &stmt, nullptr);
-	int rc = sqlite3_step(stmt);
-	while (rc != SQLITE_DONE)
+	if (accounts.empty())
 	{
-		string fetchedAccountType = string(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)));
-		cout << fetchedAccountType << endl;
-		accountTypes.push_back(fetchedAccountType);
-		rc = sqlite3_step(stmt);
+		cout << "No Accounts" << endl;
 	}
 
-	cout << "Size of accountTypes is: " << accountTypes.size() << endl;
+	storeValues();
+}
 
-	if (accountTypes.size() > 0)
+/** @brief Fetches every account the user owns
+ *
+ *  Reads the ID, type and balance of all the user's accounts in one query, and builds each account in place in the accounts vector.
+ *  Accounts of a type this program doesn't know are skipped.
+ */
+void customer::loadAccounts()
+{
+	// One account, in the order its columns are selected
+	struct accountRow
 	{
-		for (int i = 0; i < accountTypes.size(); i++)
-		{
-			account temp(accountTypes[i], username);
-			accounts.push_back(temp);
-		}
-	}
-	else
+		int accountID;
+		string_view accountType;
+		double balance;
+		string_view currency;
+		static auto columns() { return make_tuple(&accountRow::accountID, &accountRow::accountType, &accountRow::balance, &accountRow::currency); }
+	};
+
+	createLedger(*DB);
+	DB->forEach<accountRow>("SELECT accountID, accountType, balance, currency FROM accounts WHERE userID = ?;", [&](const accountRow &row)
+							{
+								accountKind kind;
+								if (parseAccountKind(row.accountType, kind))
+								{
+									accounts.emplace_back(DB.get(), row.accountID, kind, userID, username, row.balance, row.currency, accounts.get_allocator().resource());
+									indexAccount(accounts.size() - 1);
+								}
+							},
+							userID);
+}
+
+/** @brief Adds an account to the indexes
+ *
+ *  @param position Represents where the account is stored in the accounts vector
+ */
+void customer::indexAccount(size_t position)
+{
+	accountsByID[accounts[position].getID()] = position;
+	accountsByKind[(int)accounts[position].getAccountKind()] = (int)position;
+}
+
+/** @brief Removes an account from the accounts vector and the indexes
+ *
+ *  Moves the last account into the removed account's place, so nothing after it has to shift down, and updates the moved account's index
+ *  entries.
+ *  @param position Represents where the account is stored in the accounts vector
+ */
+void customer::removeAccount(size_t position)
+{
+	accountsByID.erase(accounts[position].getID());
+	accountsByKind[(int)accounts[position].getAccountKind()] = -1;
+
+	size_t last = accounts.size() - 1;
+	if (position != last)
 	{
-		cout << "No Accounts" << endl;
+		accounts[position] = move(accounts[last]);
+		indexAccount(position);
 	}
+	accounts.pop_back();
+}
 
-	sqlite3_finalize(stmt);
-
-	storeValues();
-}
\ No newline at end of file
+/** @brief Finds the user's account of a type
+ *
+ *  @param kind Represents the type of account to find
+ *  @return returns the account, or nullptr if the user doesn't have one of that type
+ */
+account *customer::findAccount(accountKind kind)
+{
+	int position = accountsByKind[(int)kind];
+	return position >= 0 ? &accounts[position] : nullptr;
+}
@@ -0,0 +1,369 @@
+/** @brief Shared access to the bank's SQLite database.
+ *
+ *  This class represents one connection to the database. Every other class runs its queries through it, so every query binds its
+ *  parameters instead of pasting them into the SQL, checks the result of each step, reads NULL columns safely, and decodes rows straight
+ *  into the fields of a row type. Prepared statements are kept and reused for as long as the connection is open.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file database.cpp
+ *  @class database "../include/database.h"
+ */
+
+#include "database.h"
+
+using namespace std;
+
+/** @brief Reads an integer column
+ *
+ *  @param stmt Represents the statement holding the current row
+ *  @param column Represents the column to read
+ *  @param field Set to the column's value
+ */
+void readColumn(sqlite3_stmt *stmt, int column, int &field)
+{
+	field = sqlite3_column_int(stmt, column);
+}
+
+/** @brief Reads a 64-bit integer column
+ *
+ *  @param stmt Represents the statement holding the current row
+ *  @param column Represents the column to read
+ *  @param field Set to the column's value
+ */
+void readColumn(sqlite3_stmt *stmt, int column, long long &field)
+{
+	field = sqlite3_column_int64(stmt, column);
+}
+
+/** @brief Reads a decimal column
+ *
+ *  @param stmt Represents the statement holding the current row
+ *  @param column Represents the column to read
+ *  @param field Set to the column's value
+ */
+void readColumn(sqlite3_stmt *stmt, int column, double &field)
+{
+	field = sqlite3_column_double(stmt, column);
+}
+
+/** @brief Reads a text column into a string
+ *
+ *  @param stmt Represents the statement holding the current row
+ *  @param column Represents the column to read
+ *  @param field Set to the column's text, or an empty string if it is NULL
+ */
+void readColumn(sqlite3_stmt *stmt, int column, string &field)
+{
+	const char *text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, column));
+	if (text == nullptr)
+	{
+		field.clear();
+		return;
+	}
+	field.assign(text, sqlite3_column_bytes(stmt, column));
+}
+
+/** @brief Reads a text column into a string from a memory resource
+ *
+ *  @param stmt Represents the statement holding the current row
+ *  @param column Represents the column to read
+ *  @param field Set to the column's text, or an empty string if it is NULL
+ */
+void readColumn(sqlite3_stmt *stmt, int column, pmr::string &field)
+{
+	const char *text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, column));
+	if (text == nullptr)
+	{
+		field.clear();
+		return;
+	}
+	field.assign(text, sqlite3_column_bytes(stmt, column));
+}
+
+/** @brief Reads a text column without copying it
+ *
+ *  @param stmt Represents the statement holding the current row
+ *  @param column Represents the column to read
+ *  @param field Set to view the column's text, or an empty view if it is NULL. Only valid until the next row is read.
+ */
+void readColumn(sqlite3_stmt *stmt, int column, string_view &field)
+{
+	const char *text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, column));
+	field = text != nullptr ? string_view(text, sqlite3_column_bytes(stmt, column)) : string_view();
+}
+
+/** @brief Binds an integer parameter
+ *
+ *  @param stmt Represents the statement
+ *  @param index Represents the parameter's position, starting at 1
+ *  @param value Represents the value to bind
+ *  @return returns the SQLite result code
+ */
+int bindParameter(sqlite3_stmt *stmt, int index, int value)
+{
+	return sqlite3_bind_int(stmt, index, value);
+}
+
+/** @brief Binds a 64-bit integer parameter
+ *
+ *  @param stmt Represents the statement
+ *  @param index Represents the parameter's position, starting at 1
+ *  @param value Represents the value to bind
+ *  @return returns the SQLite result code
+ */
+int bindParameter(sqlite3_stmt *stmt, int index, long long value)
+{
+	return sqlite3_bind_int64(stmt, index, value);
+}
+
+/** @brief Binds a decimal parameter
+ *
+ *  @param stmt Represents the statement
+ *  @param index Represents the parameter's position, starting at 1
+ *  @param value Represents the value to bind
+ *  @return returns the SQLite result code
+ */
+int bindParameter(sqlite3_stmt *stmt, int index, double value)
+{
+	return sqlite3_bind_double(stmt, index, value);
+}
+
+/** @brief Binds a text parameter
+ *
+ *  The text is not copied, so it has to stay alive until the statement has finished running.
+ *  @param stmt Represents the statement
+ *  @param index Represents the parameter's position, starting at 1
+ *  @param value Represents the value to bind
+ *  @return returns the SQLite result code
+ */
+int bindParameter(sqlite3_stmt *stmt, int index, string_view value)
+{
+	return sqlite3_bind_text(stmt, index, value.data(), (int)value.size(), SQLITE_STATIC);
+}
+
+/** @brief Creates a database object with no open connection
+ */
+database::database()
+	: db(nullptr)
+{
+}
+
+/** @brief Opens a connection to a database file
+ *
+ *  @param path Represents the database file, which is created if it doesn't exist
+ */
+database::database(const char *path)
+	: db(nullptr)
+{
+	open(path);
+}
+
+/** @brief Takes over another object's connection
+ *
+ *  @param other Represents the object being moved from. It is left with no open connection.
+ */
+database::database(database &&other) noexcept
+	: db(other.db), lastError(move(other.lastError)), statements(move(other.statements))
+{
+	other.db = nullptr;
+	other.statements.clear();
+}
+
+/** @brief Takes over another object's connection
+ *
+ *  @param other Represents the object being moved from. It is left with no open connection.
+ *  @return returns this object
+ */
+database &database::operator=(database &&other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		db = other.db;
+		lastError = move(other.lastError);
+		statements = move(other.statements);
+		other.db = nullptr;
+		other.statements.clear();
+	}
+	return *this;
+}
+
+/** @brief Closes the connection
+ */
+database::~database()
+{
+	close();
+}
+
+/** @brief Opens a connection to a database file
+ *
+ *  Closes any connection that was already open first.
+ *  @param path Represents the database file, which is created if it doesn't exist
+ *  @return returns true if the connection was opened, false otherwise
+ */
+bool database::open(const char *path)
+{
+	close();
+	if (sqlite3_open(path, &db) != SQLITE_OK)
+	{
+		lastError = db != nullptr ? sqlite3_errmsg(db) : "out of memory";
+		sqlite3_close(db);
+		db = nullptr;
+		return false;
+	}
+	return true;
+}
+
+/** @brief Closes the connection
+ *
+ *  Destroys every kept statement and closes the connection, if one is open.
+ */
+void database::close()
+{
+	for (unordered_map<string_view, sqlite3_stmt *>::iterator it = statements.begin(); it != statements.end(); it++)
+	{
+		sqlite3_finalize(it->second);
+	}
+	statements.clear();
+	sqlite3_close(db);
+	db = nullptr;
+}
+
+/** @brief Returns whether a connection is open
+ *
+ *  @return returns true if a connection is open
+ */
+bool database::isOpen() const
+{
+	return db != nullptr;
+}
+
+/** @brief Returns the SQLite connection
+ *
+ *  @return returns the connection, for the rare call this class doesn't wrap
+ */
+sqlite3 *database::handle()
+{
+	return db;
+}
+
+/** @brief Returns the last error
+ *
+ *  @return returns the message of the last statement that failed
+ */
+const string &database::getError() const
+{
+	return lastError;
+}
+
+/** @brief Returns the ID of the last inserted row
+ *
+ *  @return returns the rowid of the last row inserted on this connection
+ */
+long long database::lastInsertID()
+{
+	return sqlite3_last_insert_rowid(db);
+}
+
+/** @brief Returns the number of rows the last statement changed
+ *
+ *  @return returns the number of rows inserted, updated or deleted by the last statement
+ */
+int database::changes()
+{
+	return sqlite3_changes(db);
+}
+
+/** @brief Runs statements without parameters or results
+ *
+ *  Used for schema changes, pragmas and transaction control.
+ *  @param sql Represents one or more statements
+ *  @return returns true if every statement ran, false otherwise
+ */
+bool database::exec(const char *sql)
+{
+	if (db == nullptr)
+	{
+		lastError = "database is not open";
+		return false;
+	}
+	char *errorMessage = 0;
+	if (sqlite3_exec(db, sql, nullptr, 0, &errorMessage) != SQLITE_OK)
+	{
+		lastError = errorMessage != nullptr ? errorMessage : sqlite3_errmsg(db);
+		sqlite3_free(errorMessage);
+		return false;
+	}
+	return true;
+}
+
+/** @brief Finds or prepares a statement
+ *
+ *  Statements are kept after they are first prepared, keyed by their SQL. If the kept statement is in use, for example by a query inside a
+ *  forEach over the same SQL, a separate statement is prepared for this call only.
+ *  @param sql Represents the statement
+ *  @param cached Set to whether the returned statement is kept
+ *  @return returns the statement, or nullptr if it could not be prepared
+ */
+sqlite3_stmt *database::prepare(string_view sql, bool &cached)
+{
+	cached = false;
+	if (db == nullptr)
+	{
+		lastError = "database is not open";
+		return nullptr;
+	}
+
+	unordered_map<string_view, sqlite3_stmt *>::iterator found = statements.find(sql);
+	if (found != statements.end() && !sqlite3_stmt_busy(found->second))
+	{
+		cached = true;
+		return found->second;
+	}
+
+	sqlite3_stmt *stmt = nullptr;
+	if (sqlite3_prepare_v3(db, sql.data(), (int)sql.size(), SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK)
+	{
+		lastError = sqlite3_errmsg(db);
+		sqlite3_finalize(stmt);
+		return nullptr;
+	}
+
+	if (found == statements.end())
+	{
+		statements[string_view(sqlite3_sql(stmt))] = stmt;
+		cached = true;
+	}
+	return stmt;
+}
+
+/** @brief Finishes with a statement
+ *
+ *  Kept statements are reset and their parameters cleared, ready for the next call. Others are destroyed.
+ *  @param stmt Represents the statement
+ *  @param cached Represents whether the statement is kept
+ */
+void database::release(sqlite3_stmt *stmt, bool cached)
+{
+	if (cached)
+	{
+		sqlite3_reset(stmt);
+		sqlite3_clear_bindings(stmt);
+	}
+	else
+	{
+		sqlite3_finalize(stmt);
+	}
+}
+
+/** @brief Records a failed statement
+ *
+ *  @param stmt Represents the statement that failed
+ *  @param cached Represents whether the statement is kept
+ *  @return returns false, so callers can return it directly
+ */
+bool database::fail(sqlite3_stmt *stmt, bool cached)
+{
+	lastError = sqlite3_errmsg(db);
+	release(stmt, cached);
+	return false;
+}
@@ -0,0 +1,356 @@
+/** @brief Answers whether an account or user might exist without reading the database.
+ *
+ *  Transfers, scheduled payments and the administrator's checks all ask whether an account ID or username exists before doing anything
+ *  else. The existenceFilter keeps a counting Bloom filter of each, so a key that isn't there is turned away in memory, and only keys
+ *  that might be there are looked up in the database.
+ *
+ *  The filters are built from the tables by several threads at once, each reading its own range of rows through its own connection.
+ *  After that they follow the change log, which every process appends its opened and closed accounts and created and removed users
+ *  to, so they never miss a key another process adds. Reading the log only costs a read of mapped memory when nothing has changed. If
+ *  any process commits a change it can't append to the log, the filters would miss it, so they are built again from the tables, and
+ *  answer "maybe" until that succeeds.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file existenceFilter.cpp
+ *  @class existenceFilter "../include/existenceFilter.h"
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <climits>
+#include <thread>
+#include "existenceFilter.h"
+
+using namespace std;
+
+static const int filterHashes = 7;            // Best for 1 in 100 answering "maybe"
+static const double countersPerKey = 9.6;     // Also for 1 in 100
+static const size_t minimumCapacity = 1024;
+static const long long rowsPerThread = 65536; // Fewer rows than this aren't worth another thread and connection
+static const chrono::seconds retryDelay(5);    // Time between attempts to build filters that couldn't be built
+
+// The lowest and highest row of a table, and how many rows it has
+struct keyRange
+{
+	long long first;
+	long long last;
+	long long count;
+	static auto columns() { return make_tuple(&keyRange::first, &keyRange::last, &keyRange::count); }
+};
+
+struct accountKey
+{
+	int accountID;
+	static auto columns() { return make_tuple(&accountKey::accountID); }
+};
+
+struct userKey
+{
+	string_view username;
+	static auto columns() { return make_tuple(&userKey::username); }
+};
+
+/** @brief Spreads a key's bits over the whole hash
+ *
+ *  @param key Represents the key
+ *  @return returns the hash
+ */
+static unsigned long long mix(unsigned long long key)
+{
+	key += 0x9E3779B97F4A7C15ull;
+	key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ull;
+	key = (key ^ (key >> 27)) * 0x94D049BB133111EBull;
+	return key ^ (key >> 31);
+}
+
+static unsigned long long hashAccount(int accountID)
+{
+	return mix((unsigned int)accountID);
+}
+
+static unsigned long long hashUser(string_view username)
+{
+	return mix(hash<string_view>()(username));
+}
+
+/** @brief Creates an empty filter
+ *
+ *  @param capacity Represents how many keys the filter is sized for
+ */
+countingBloomFilter::countingBloomFilter(size_t capacity)
+	: counters((size_t)ceil(max(capacity, minimumCapacity) * countersPerKey)), hashes(filterHashes)
+{
+}
+
+/** @brief Calls visitCounter with each counter a key sets
+ *
+ *  The counters are picked by double hashing, so one hash of the key is enough for all of them.
+ *  @param hash Represents the key's hash
+ *  @param visitCounter Represents what is done with each counter's index
+ */
+template <typename Visit>
+void countingBloomFilter::visit(unsigned long long hash, Visit visitCounter) const
+{
+	unsigned long long first = hash & 0xFFFFFFFF;
+	unsigned long long step = (hash >> 32) | 1;
+	for (int i = 0; i < hashes; i++)
+	{
+		visitCounter((size_t)((first + i * step) % counters.size()));
+	}
+}
+
+void countingBloomFilter::add(unsigned long long hash)
+{
+	visit(hash, [&](size_t index)
+		  {
+			  if (counters[index] < 255)
+			  {
+				  counters[index]++;
+			  } });
+}
+
+/** @brief Removes a key
+ *
+ *  @param hash Represents the key's hash
+ */
+void countingBloomFilter::remove(unsigned long long hash)
+{
+	if (!mightContain(hash))
+	{
+		return;
+	}
+	visit(hash, [&](size_t index)
+		  {
+			  if (counters[index] < 255)
+			  {
+				  counters[index]--;
+			  } });
+}
+
+/** @brief Checks for a key
+ *
+ *  @param hash Represents the key's hash
+ *  @return returns false if the key was never added, or has been removed, and true if it might be in the filter
+ */
+bool countingBloomFilter::mightContain(unsigned long long hash) const
+{
+	bool found = true;
+	visit(hash, [&](size_t index)
+		  { found = found && counters[index] > 0; });
+	return found;
+}
+
+/** @brief Adds every key of another filter
+ *
+ *  @param other Represents a filter made with the same capacity
+ */
+void countingBloomFilter::merge(const countingBloomFilter &other)
+{
+	for (size_t i = 0; i < counters.size() && i < other.counters.size(); i++)
+	{
+		counters[i] = (unsigned char)min(255, counters[i] + other.counters[i]);
+	}
+}
+
+/** @brief Builds the filters from the accounts and users tables
+ *
+ *  Each thread reads one range of account IDs and one range of users into filters of its own, which are merged once every thread is
+ *  done. The log's end and its count of lost commits are taken before the tables are read. The filters then replay the log from there,
+ *  so a key committed while the tables were being read is added either way, and a commit lost after it makes them build again.
+ *  @param config Represents the settings the tables are read with
+ *  @return returns true if the filters were built
+ */
+bool existenceFilter::rebuild(const bankConfig &config)
+{
+	loaded = false;
+	failed = true;
+	retryAt = chrono::steady_clock::now() + retryDelay;
+	database db;
+	if (!config.open(db))
+	{
+		return false;
+	}
+
+	unsigned long long lost = changeFeed().getLostCount();
+	unsigned long long start = changeFeed().getEndOffset();
+	optional<keyRange> accountRange = db.queryRow<keyRange>("SELECT MIN(accountID), MAX(accountID), COUNT(*) FROM accounts;");
+	optional<keyRange> userRange = db.queryRow<keyRange>("SELECT MIN(rowid), MAX(rowid), COUNT(*) FROM users;");
+	if (!accountRange || !userRange)
+	{
+		cout << "Could not build existence filters: " << db.getError() << endl;
+		return false;
+	}
+
+	long long rows = max(accountRange->count, userRange->count);
+	int numThreads = config.filterThreads > 0 ? config.filterThreads : max(1u, thread::hardware_concurrency());
+	numThreads = (int)min<long long>(numThreads, 1 + rows / rowsPerThread);
+	capacity = max<size_t>(2 * (size_t)rows, minimumCapacity);
+
+	// Splits a table's rows into numThreads ranges. The last range is left open, so it can't miss a row added since.
+	auto slice = [&](const keyRange &range, int index, bool end)
+	{
+		if (end && index == numThreads - 1)
+		{
+			return LLONG_MAX;
+		}
+		long long span = range.last - range.first + 1;
+		return range.first + span * (index + (end ? 1 : 0)) / numThreads;
+	};
+
+	vector<countingBloomFilter> accountParts(numThreads, countingBloomFilter(capacity));
+	vector<countingBloomFilter> userParts(numThreads, countingBloomFilter(capacity));
+	vector<char> read(numThreads, 0);
+	vector<thread> threads;
+	for (int t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&, t]()
+							 {
+								 database part;
+								 if (!config.open(part))
+								 {
+									 return;
+								 }
+								 read[t] = part.forEach<accountKey>("SELECT accountID FROM accounts WHERE accountID >= ? AND accountID < ?;",
+																	[&](const accountKey &row)
+																	{ accountParts[t].add(hashAccount(row.accountID)); },
+																	slice(*accountRange, t, false), slice(*accountRange, t, true)) &&
+										   part.forEach<userKey>("SELECT username FROM users WHERE rowid >= ? AND rowid < ?;",
+																 [&](const userKey &row)
+																 { userParts[t].add(hashUser(row.username)); },
+																 slice(*userRange, t, false), slice(*userRange, t, true));
+								 if (!read[t])
+								 {
+									 cout << "Could not build existence filters: " << part.getError() << endl;
+								 } });
+	}
+	for (thread &worker : threads)
+	{
+		worker.join();
+	}
+	if (count(read.begin(), read.end(), 0) > 0)
+	{
+		return false;
+	}
+
+	accounts = move(accountParts[0]);
+	users = move(userParts[0]);
+	for (int t = 1; t < numThreads; t++)
+	{
+		accounts.merge(accountParts[t]);
+		users.merge(userParts[t]);
+	}
+
+	loadedAt = changeFeed().getEndOffset();
+	lostAt = lost;
+	changes = make_unique<changeLogReader>(bankSettings().changeLogDirectory, start);
+	added = 0;
+	loaded = true;
+	failed = false;
+	return true;
+}
+
+/** @brief Builds the filters if they aren't built, and adds and removes the keys of changes appended to the log since the last call
+ *
+ *  A change from before loadedAt may be to a row that was already read from the tables. Adding its key again only costs the filter
+ *  some accuracy, but removing it could remove it twice, so those changes only add keys. Once the filters hold more keys than they
+ *  were sized for, they are built again, larger. They are also built again if a commit went missing from the log, and filters that
+ *  couldn't be built are tried again once retryDelay has passed.
+ *  @return returns true if the filters can be trusted, false if lookups must go to the database
+ */
+bool existenceFilter::refresh()
+{
+	if (loaded && changeFeed().getLostCount() != lostAt)
+	{
+		cout << "Changes are missing from the log, rebuilding existence filters" << endl;
+		loaded = false;
+		failed = false;
+	}
+	if (!loaded && (!failed || chrono::steady_clock::now() >= retryAt))
+	{
+		rebuild(bankSettings());
+	}
+	if (!loaded)
+	{
+		return false;
+	}
+
+	changeRecord record;
+	while (changes->next(record))
+	{
+		bool afterLoad = record.offset >= loadedAt;
+		switch (record.type)
+		{
+		case changeType::accountOpened:
+			accounts.add(hashAccount(record.accountID));
+			added++;
+			break;
+		case changeType::userCreated:
+			users.add(hashUser(record.username));
+			added++;
+			break;
+		case changeType::accountClosed:
+			if (afterLoad)
+			{
+				accounts.remove(hashAccount(record.accountID));
+			}
+			break;
+		case changeType::userRemoved:
+			if (afterLoad)
+			{
+				users.remove(hashUser(record.username));
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (added > capacity)
+	{
+		rebuild(bankSettings());
+	}
+	return loaded;
+}
+
+/** @brief Builds the filters, usually when the bank starts
+ *
+ *  Lookups build them the first time if this is never called.
+ *  @param config Represents the settings the tables are read with
+ *  @return returns true if the filters are built
+ */
+bool existenceFilter::load(const bankConfig &config)
+{
+	lock_guard<mutex> guard(lock);
+	return loaded || rebuild(config);
+}
+
+/** @brief Checks whether an account might exist
+ *
+ *  @param accountID Represents the account's ID
+ *  @return returns false if the account certainly doesn't exist, true if it might and has to be looked up
+ */
+bool existenceFilter::mightHaveAccount(int accountID)
+{
+	lock_guard<mutex> guard(lock);
+	return !refresh() || accounts.mightContain(hashAccount(accountID));
+}
+
+/** @brief Checks whether a user might exist
+ *
+ *  @param username Represents the user's username
+ *  @return returns false if the user certainly doesn't exist, true if they might and have to be looked up
+ */
+bool existenceFilter::mightHaveUser(string_view username)
+{
+	lock_guard<mutex> guard(lock);
+	return !refresh() || users.mightContain(hashUser(username));
+}
+
+/** @brief Returns the filters this process checks
+ *
+ *  @return returns the filters, which are built the first time they are used
+ */
+existenceFilter &existenceFilters()
+{
+	static existenceFilter filters;
+	return filters;
+}
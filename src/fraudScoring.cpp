@@ -0,0 +1,256 @@
+/** @brief Scores transfers for fraud before they are committed
+ *
+ *  Every transfer a customer makes is screened by a fraudScorer first. The scorer keeps the last few dozen transfers of each sending
+ *  account in memory and runs a set of rules over them, so screening never waits on the database. The rules each give the transfer a
+ *  score, and the highest score decides whether the transfer goes ahead, is held for review, or is rejected. Rules can be added for
+ *  new kinds of fraud without changing the customer class.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file fraudScoring.cpp
+ *  @class fraudScorer "../include/fraudScoring.h"
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "fraudScoring.h"
+
+using namespace std;
+
+/** @brief Adds a transfer to the window, overwriting the oldest once the window is full
+ *
+ *  @param time Represents when the transfer was made, in microseconds
+ *  @param amount Represents the amount sent
+ *  @param receiverAccountID Represents the account it was sent to
+ */
+void accountWindow::add(long long time, double amount, int receiverAccountID)
+{
+	times[next] = time;
+	amounts[next] = amount;
+	receivers[next] = receiverAccountID;
+	next = (next + 1) % capacity;
+	if (count < capacity)
+	{
+		count++;
+	}
+}
+
+int accountWindow::countSince(long long time) const
+{
+	int found = 0;
+	for (int i = 0; i < count; i++)
+	{
+		found += times[i] >= time;
+	}
+	return found;
+}
+
+double accountWindow::percentile(double fraction) const
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+	array<double, capacity> sorted;
+	copy(amounts.begin(), amounts.begin() + count, sorted.begin());
+	int position = clamp((int)ceil(fraction * count) - 1, 0, count - 1);
+	nth_element(sorted.begin(), sorted.begin() + position, sorted.begin() + count);
+	return sorted[position];
+}
+
+bool accountWindow::hasSentTo(int receiverAccountID) const
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (receivers[i] == receiverAccountID)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/** @brief Makes a rule that rejects a sender making too many transfers in a minute
+ *
+ *  @param perMinute Represents the most transfers allowed from one account in any minute
+ *  @return returns the rule
+ */
+fraudRule velocityRule(int perMinute)
+{
+	return [perMinute](const transferAttempt &attempt, const accountWindow &window)
+	{
+		return window.countSince(attempt.time - 60000000LL) + 1 > perMinute ? 1.0 : 0.0;
+	};
+}
+
+/** @brief Makes a rule that holds amounts well above the sender's usual transfers, and rejects ones far above them
+ *
+ *  @param minimumHistory Represents how many transfers the sender must have made before the rule judges them
+ *  @return returns the rule
+ */
+fraudRule amountRule(int minimumHistory)
+{
+	return [minimumHistory](const transferAttempt &attempt, const accountWindow &window)
+	{
+		if (window.count < minimumHistory)
+		{
+			return 0.0;
+		}
+		double usual = window.percentile(0.95);
+		if (usual <= 0)
+		{
+			return 0.0;
+		}
+		return attempt.amount >= 10 * usual ? 0.95 : attempt.amount >= 3 * usual ? 0.6 : 0.0;
+	};
+}
+
+/** @brief Makes a rule that holds a large first transfer to an account the sender hasn't sent to recently
+ *
+ *  @param minimumHistory Represents how many transfers the sender must have made before the rule judges them
+ *  @return returns the rule
+ */
+fraudRule newReceiverRule(int minimumHistory)
+{
+	return [minimumHistory](const transferAttempt &attempt, const accountWindow &window)
+	{
+		if (window.count < minimumHistory || window.hasSentTo(attempt.receiverAccountID))
+		{
+			return 0.0;
+		}
+		return attempt.amount > 5 * window.percentile(0.5) ? 0.6 : 0.0;
+	};
+}
+
+/** @brief Creates the table of held transfers
+ *
+ *  @param db Represents the database the transfers are held in
+ *  @return returns true if the table exists afterwards, false otherwise
+ */
+bool createHeldTransfers(database &db)
+{
+	return db.exec("create table if not exists heldTransfers ("
+				   "heldID INTEGER PRIMARY KEY, "
+				   "senderAccountID INTEGER NOT NULL, "
+				   "receiverAccountID INTEGER NOT NULL, "
+				   "amount DOUBLE NOT NULL, "
+				   "score DOUBLE NOT NULL, "
+				   "reason TEXT NOT NULL, "
+				   "heldAt DATETIME default CURRENT_TIMESTAMP NOT NULL);");
+}
+
+/** @brief Creates a scorer
+ *
+ *  @param holdScore Represents the score at which a transfer is held
+ *  @param rejectScore Represents the score at which a transfer is rejected
+ *  @param defaultRules Represents whether to start with the velocity, amount and new receiver rules
+ */
+fraudScorer::fraudScorer(double holdScore, double rejectScore, bool defaultRules)
+{
+	this->holdScore = holdScore;
+	this->rejectScore = rejectScore;
+	if (defaultRules)
+	{
+		addRule("velocity", velocityRule(20));
+		addRule("amount", amountRule(8));
+		addRule("newReceiver", newReceiverRule(8));
+	}
+}
+
+/** @brief Adds a rule every later transfer is scored by
+ *
+ *  @param name Represents the name given as the reason when the rule decides a transfer
+ *  @param rule Represents the rule
+ */
+void fraudScorer::addRule(string name, fraudRule rule)
+{
+	unique_lock<shared_mutex> guard(rulesLock);
+	rules.push_back({name, rule});
+}
+
+/** @brief Scores a transfer
+ *
+ *  Only the sender's shard is locked, so transfers from accounts in different shards are screened at the same time.
+ *  @param senderAccountID Represents the account sending the money
+ *  @param receiverAccountID Represents the account receiving it
+ *  @param amount Represents the amount sent
+ *  @return returns the decision, the score, and the rule that gave it
+ */
+fraudVerdict fraudScorer::screen(int senderAccountID, int receiverAccountID, double amount)
+{
+	long long now = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+	transferAttempt attempt = {senderAccountID, receiverAccountID, amount, now};
+	fraudVerdict verdict = {fraudDecision::allow, 0, {}};
+
+	shard &accounts = shards[(unsigned int)senderAccountID % shardCount];
+	lock_guard<mutex> guard(accounts.lock);
+	accountWindow &window = accounts.windows[senderAccountID];
+	{
+		shared_lock<shared_mutex> rulesGuard(rulesLock);
+		for (const namedRule &rule : rules)
+		{
+			double score = rule.rule(attempt, window);
+			if (score > verdict.score)
+			{
+				verdict.score = score;
+				verdict.reason = rule.name;
+			}
+		}
+	}
+
+	if (verdict.score >= rejectScore)
+	{
+		verdict.decision = fraudDecision::reject;
+	}
+	else if (verdict.score >= holdScore)
+	{
+		verdict.decision = fraudDecision::hold;
+	}
+	else
+	{
+		window.add(now, amount, receiverAccountID);
+	}
+	return verdict;
+}
+
+/** @brief Drops an account's recent transfers
+ *
+ *  @param accountID Represents the account
+ */
+void fraudScorer::forget(int accountID)
+{
+	shard &accounts = shards[(unsigned int)accountID % shardCount];
+	lock_guard<mutex> guard(accounts.lock);
+	accounts.windows.erase(accountID);
+}
+
+/** @brief Returns the scorer this process screens transfers with
+ *
+ *  @return returns the scorer, with the default rules
+ */
+fraudScorer &fraudScoring()
+{
+	static fraudScorer scorer;
+	return scorer;
+}
+
+/** @brief Screens a transfer inside the database transaction that would send it
+ *
+ *  Every path that sends a customer's money calls this after it has checked the transfer and before it posts the journal entry. A held
+ *  transfer is written to heldTransfers in the caller's transaction, which the caller commits without posting the entry.
+ *  @param db Represents the connection, inside the transfer's database transaction
+ *  @param senderAccountID Represents the account the money is sent from
+ *  @param receiverAccountID Represents the account the money is sent to
+ *  @param amount Represents the amount sent, in the sender account's currency
+ *  @return returns the decision, which is reject if a held transfer could not be written
+ */
+fraudDecision screenTransfer(database &db, int senderAccountID, int receiverAccountID, double amount)
+{
+	fraudVerdict verdict = fraudScoring().screen(senderAccountID, receiverAccountID, amount);
+	if (verdict.decision == fraudDecision::hold &&
+		!(createHeldTransfers(db) &&
+		  db.run("INSERT INTO heldTransfers(senderAccountID, receiverAccountID, amount, score, reason) VALUES (?, ?, ?, ?, ?);",
+				 senderAccountID, receiverAccountID, amount, verdict.score, verdict.reason)))
+	{
+		return fraudDecision::reject;
+	}
+	return verdict.decision;
+}
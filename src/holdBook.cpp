@@ -0,0 +1,430 @@
+/** @brief Keeps the funds reserved by card authorizations.
+ *
+ *  A card authorization has to be answered at once, and most are captured or released within days. The holdBook keeps every active hold
+ *  in memory, by account, so checking whether an account can cover an authorization, and reserving the funds, only reads its balance.
+ *  New holds are written to the holds table in batches of holdBatchSize, together with any capture, release or expiry, so the table lets
+ *  them outlast the process. Hold IDs come from blocks reserved in the table, so no two processes give out the same one.
+ *
+ *  Captures and releases are also made in batches: many holds are settled in one database transaction. A captured hold is posted to the
+ *  journal as a withdrawal to the bank's cash, which is where card payments leave the bank.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file holdBook.cpp
+ *  @class holdBook "../include/holdBook.h"
+ */
+
+#include <chrono>
+#include <algorithm>
+#include "holdBook.h"
+
+using namespace std;
+
+static const long long holdIDBlockSize = 4096; // Hold IDs reserved at a time
+
+static long long secondsNow()
+{
+	return chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/** @brief Creates the tables holds are kept in
+ *
+ *  @param db Represents the database the tables are created in
+ *  @return returns true if the tables exist afterwards
+ */
+bool createHolds(database &db)
+{
+	return db.exec("create table if not exists holds ("
+				   "holdID INTEGER PRIMARY KEY, "
+				   "accountID INTEGER NOT NULL, "
+				   "amount decimal(15,2) NOT NULL, "
+				   "expiresAt INTEGER NOT NULL, "
+				   "status varchar(10) NOT NULL DEFAULT 'active', "
+				   "entryID INTEGER);") &&
+		   db.exec("create index if not exists activeHolds on holds(accountID) WHERE status = 'active';") &&
+		   db.exec("create table if not exists holdIDBlocks (block INTEGER PRIMARY KEY AUTOINCREMENT);");
+}
+
+/** @brief Creates an empty book
+ *
+ *  @param config Represents the settings with the number of holds written together, and how long a hold lasts
+ */
+holdBook::holdBook(const bankConfig &config)
+	: batchSize((size_t)max(config.holdBatchSize, 1)), lifetime(config.holdSeconds)
+{
+}
+
+/** @brief Reads the active holds from the table, the first time the book is used
+ *
+ *  @param db Represents the database the holds are kept in
+ *  @return returns true if the holds are in memory
+ */
+bool holdBook::load(database &db)
+{
+	if (loaded)
+	{
+		return true;
+	}
+	loaded = createHolds(db) &&
+			 db.forEach<hold>("SELECT holdID, accountID, amount, expiresAt FROM holds WHERE status = 'active' AND expiresAt > ?;", [&](const hold &row)
+							  {
+								  active[row.accountID].push_back(row);
+								  accountOf[row.holdID] = row.accountID;
+							  },
+							  secondsNow());
+	if (!loaded)
+	{
+		cout << "Could not load holds: " << db.getError() << endl;
+	}
+	return loaded;
+}
+
+/** @brief Totals an account's active holds
+ *
+ *  Holds that have expired are dropped from memory on the way. Their rows are marked expired by the next call to expire.
+ *  @param accountID Represents the account
+ *  @param now Represents the time, in seconds since 1970
+ *  @return returns the total held
+ */
+double holdBook::activeTotal(int accountID, long long now)
+{
+	auto found = active.find(accountID);
+	if (found == active.end())
+	{
+		return 0;
+	}
+
+	double total = 0;
+	vector<hold> &holds = found->second;
+	for (size_t i = 0; i < holds.size();)
+	{
+		if (holds[i].expiresAt <= now)
+		{
+			accountOf.erase(holds[i].holdID);
+			holds[i] = holds.back();
+			holds.pop_back();
+			continue;
+		}
+		total += holds[i].amount;
+		i++;
+	}
+	if (holds.empty())
+	{
+		active.erase(found);
+	}
+	return total;
+}
+
+/** @brief Writes the holds placed since the last batch
+ *
+ *  @param db Represents the database, which must be inside a database transaction
+ *  @return returns true if every hold was written. The caller clears unsaved once the transaction commits.
+ */
+bool holdBook::writeUnsaved(database &db)
+{
+	for (const hold &placed : unsaved)
+	{
+		if (!db.run("INSERT INTO holds (holdID, accountID, amount, expiresAt) VALUES (?, ?, ?, ?);", placed.holdID, placed.accountID,
+					placed.amount, placed.expiresAt))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/** @brief Drops a settled hold from memory
+ *
+ *  @param holdID Represents the hold
+ */
+void holdBook::forget(long long holdID)
+{
+	auto owner = accountOf.find(holdID);
+	if (owner == accountOf.end())
+	{
+		return;
+	}
+	auto found = active.find(owner->second);
+	accountOf.erase(owner);
+	if (found == active.end())
+	{
+		return;
+	}
+	vector<hold> &holds = found->second;
+	holds.erase(remove_if(holds.begin(), holds.end(), [&](const hold &each)
+						  { return each.holdID == holdID; }),
+				holds.end());
+	if (holds.empty())
+	{
+		active.erase(found);
+	}
+}
+
+/** @brief Reserves funds on an account for a card authorization
+ *
+ *  Whether the account can cover the hold is decided in memory, from balance and the account's other holds. The hold is written to the
+ *  table with the next batch, so most authorizations write nothing to the database.
+ *  @param db Represents the database the holds are kept in
+ *  @param accountID Represents the account
+ *  @param amount Represents the amount reserved, in the account's currency
+ *  @param balance Represents the account's ledger balance
+ *  @param seconds Represents how long the hold lasts, or 0 for holdSeconds
+ *  @return returns the hold's ID, or -1 if the account's available balance doesn't cover it
+ */
+long long holdBook::place(database &db, int accountID, double amount, double balance, int seconds)
+{
+	lock_guard<mutex> guard(lock);
+	long long now = secondsNow();
+	if (amount <= 0 || !load(db) || balance - activeTotal(accountID, now) < amount)
+	{
+		return -1;
+	}
+
+	// Reserves the next block of IDs. AUTOINCREMENT never gives a block out twice, even to another process.
+	if (nextID > lastID)
+	{
+		if (!db.run("INSERT INTO holdIDBlocks DEFAULT VALUES;"))
+		{
+			cout << "Could not reserve hold IDs: " << db.getError() << endl;
+			return -1;
+		}
+		long long block = db.lastInsertID();
+		db.run("DELETE FROM holdIDBlocks WHERE block < ?;", block);
+		nextID = block * holdIDBlockSize;
+		lastID = nextID + holdIDBlockSize - 1;
+	}
+
+	hold placed{nextID++, accountID, amount, now + (seconds > 0 ? seconds : lifetime)};
+	active[accountID].push_back(placed);
+	accountOf[placed.holdID] = accountID;
+	unsaved.push_back(placed);
+
+	if (unsaved.size() >= batchSize)
+	{
+		db.exec("BEGIN;");
+		if (writeUnsaved(db) && db.exec("COMMIT;"))
+		{
+			unsaved.clear();
+		}
+		else
+		{
+			cout << "Could not write holds: " << db.getError() << endl;
+			db.exec("ROLLBACK;");
+		}
+	}
+	return placed.holdID;
+}
+
+/** @brief Returns the total of an account's active holds
+ *
+ *  @param db Represents the database the holds are kept in, read only the first time the book is used
+ *  @param accountID Represents the account
+ *  @return returns the total held, which the account can't spend
+ */
+double holdBook::held(database &db, int accountID)
+{
+	lock_guard<mutex> guard(lock);
+	return load(db) ? activeTotal(accountID, secondsNow()) : 0;
+}
+
+/** @brief Captures holds
+ *
+ *  Each hold is posted to the journal as a withdrawal of its amount, and marked captured, all in one database transaction. Holds that
+ *  aren't active, because they were settled, here or by another process, or have expired, are skipped.
+ *  @param db Represents the database the holds are kept in
+ *  @param holdIDs Represents the holds
+ *  @return returns the number of holds captured, or 0 if the batch failed
+ */
+int holdBook::capture(database &db, const vector<long long> &holdIDs)
+{
+	lock_guard<mutex> guard(lock);
+	if (!load(db))
+	{
+		return 0;
+	}
+
+	long long now = secondsNow();
+	vector<hold> captured;
+	for (long long holdID : holdIDs)
+	{
+		auto owner = accountOf.find(holdID);
+		if (owner == accountOf.end())
+		{
+			continue;
+		}
+		for (const hold &each : active[owner->second])
+		{
+			if (each.holdID == holdID && each.expiresAt > now)
+			{
+				captured.push_back(each);
+			}
+		}
+	}
+	if (captured.empty())
+	{
+		return 0;
+	}
+
+	// A hold is only posted if this transaction is the one that marks it captured
+	vector<changeEvent> events;
+	db.exec("BEGIN;");
+	bool ok = writeUnsaved(db);
+	for (size_t i = 0; ok && i < captured.size(); i++)
+	{
+		const hold &each = captured[i];
+		ok = db.run("UPDATE holds SET status = 'captured' WHERE holdID = ? AND status = 'active';", each.holdID);
+		if (!ok || db.changes() == 0)
+		{
+			continue;
+		}
+		long long entryID = postEntry(db, "withdraw", each.accountID, cashAccountID, each.amount);
+		ok = entryID >= 0 && db.run("UPDATE holds SET entryID = ? WHERE holdID = ?;", entryID, each.holdID);
+		events.push_back({changeType::withdraw, each.accountID, 0, each.amount,
+						  db.queryValue<string>("SELECT u.username FROM accounts AS a, users AS u WHERE a.accountID = ? AND u.userID = a.userID;",
+												each.accountID)
+							  .value_or("")});
+	}
+	if (!ok)
+	{
+		cout << "Could not capture holds: " << db.getError() << endl;
+		db.exec("ROLLBACK;");
+		return 0;
+	}
+	if (!changeFeed().commit(db, events))
+	{
+		return 0;
+	}
+
+	unsaved.clear();
+	for (const hold &each : captured)
+	{
+		forget(each.holdID);
+	}
+	return (int)events.size();
+}
+
+/** @brief Releases holds
+ *
+ *  Every hold is marked released in one statement, which is given the hold IDs as a JSON array.
+ *  @param db Represents the database the holds are kept in
+ *  @param holdIDs Represents the holds
+ *  @return returns the number of holds released, or 0 if the batch failed
+ */
+int holdBook::release(database &db, const vector<long long> &holdIDs)
+{
+	lock_guard<mutex> guard(lock);
+	if (!load(db))
+	{
+		return 0;
+	}
+
+	vector<long long> released;
+	string ids = "[";
+	for (long long holdID : holdIDs)
+	{
+		if (accountOf.count(holdID) == 0)
+		{
+			continue;
+		}
+		ids += (released.empty() ? "" : ",") + to_string(holdID);
+		released.push_back(holdID);
+	}
+	ids += "]";
+	if (released.empty())
+	{
+		return 0;
+	}
+
+	db.exec("BEGIN;");
+	bool ok = writeUnsaved(db) &&
+			  db.run("UPDATE holds SET status = 'released' WHERE status = 'active' AND holdID IN (SELECT value FROM json_each(?));", ids) &&
+			  db.exec("COMMIT;");
+	if (!ok)
+	{
+		cout << "Could not release holds: " << db.getError() << endl;
+		db.exec("ROLLBACK;");
+		return 0;
+	}
+
+	unsaved.clear();
+	for (long long holdID : released)
+	{
+		forget(holdID);
+	}
+	return (int)released.size();
+}
+
+/** @brief Marks holds that have passed their time as expired
+ *
+ *  Expired holds stopped counting against their accounts as soon as their time passed. This only settles their rows, including the rows
+ *  of other processes' holds.
+ *  @param db Represents the database the holds are kept in
+ *  @return returns the number of holds marked expired, or -1 if they could not be
+ */
+int holdBook::expire(database &db)
+{
+	lock_guard<mutex> guard(lock);
+	if (!load(db))
+	{
+		return -1;
+	}
+
+	long long now = secondsNow();
+	db.exec("BEGIN;");
+	bool ok = writeUnsaved(db) && db.run("UPDATE holds SET status = 'expired' WHERE status = 'active' AND expiresAt <= ?;", now);
+	int expired = db.changes();
+	if (!ok || !db.exec("COMMIT;"))
+	{
+		cout << "Could not expire holds: " << db.getError() << endl;
+		db.exec("ROLLBACK;");
+		return -1;
+	}
+
+	unsaved.clear();
+	vector<int> accounts;
+	for (const auto &each : active)
+	{
+		accounts.push_back(each.first);
+	}
+	for (int accountID : accounts)
+	{
+		activeTotal(accountID, now);
+	}
+	return expired;
+}
+
+/** @brief Writes every hold placed since the last batch
+ *
+ *  @param db Represents the database the holds are kept in
+ *  @return returns true if every hold is in the table
+ */
+bool holdBook::flush(database &db)
+{
+	lock_guard<mutex> guard(lock);
+	if (!load(db))
+	{
+		return false;
+	}
+	if (unsaved.empty())
+	{
+		return true;
+	}
+
+	db.exec("BEGIN;");
+	if (!writeUnsaved(db) || !db.exec("COMMIT;"))
+	{
+		cout << "Could not write holds: " << db.getError() << endl;
+		db.exec("ROLLBACK;");
+		return false;
+	}
+	unsaved.clear();
+	return true;
+}
+
+/** @brief Returns the holds this process checks
+ *
+ *  @return returns the book, created the first time it is asked for
+ */
+holdBook &authorizationHolds()
+{
+	static holdBook book;
+	return book;
+}
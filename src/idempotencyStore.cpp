@@ -0,0 +1,287 @@
+/** @brief Remembers the keys clients send with deposits, withdrawals and transfers, so a retried call doesn't move money twice.
+ *
+ *  A key is written to the idempotencyKeys table in the same database transaction as the journal entry it goes with, so the entry can't
+ *  commit without it, and two processes can't both claim it. Once committed, the key is also kept in memory, in one of several small
+ *  least recently used lists chosen by its hash, so a retry finds it with one hash lookup under a lock only calls in the same shard
+ *  share. Keys expire after idempotencyKeySeconds, and their rows are deleted as new keys are claimed.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file idempotencyStore.cpp
+ *  @class idempotencyStore "../include/idempotencyStore.h"
+ */
+
+#include <chrono>
+#include "idempotencyStore.h"
+
+using namespace std;
+
+static const unsigned int cleanupEvery = 1024; // Claims between deletions of expired keys
+
+// A key's row, as it is read back
+struct keyRow
+{
+	string operation;
+	int accountID;
+	int otherAccountID;
+	double amount;
+	long long entryID;
+	long long expiresAt;
+	static auto columns() { return make_tuple(&keyRow::operation, &keyRow::accountID, &keyRow::otherAccountID, &keyRow::amount, &keyRow::entryID, &keyRow::expiresAt); }
+};
+
+static long long secondsNow()
+{
+	return chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/** @brief Creates the table idempotency keys are kept in
+ *
+ *  @param db Represents the database the table is created in
+ *  @return returns true if the table exists afterwards
+ */
+bool createIdempotencyKeys(database &db)
+{
+	return db.exec("create table if not exists idempotencyKeys ("
+				   "idempotencyKey TEXT PRIMARY KEY, "
+				   "operation varchar(10) NOT NULL, "
+				   "accountID INTEGER NOT NULL, "
+				   "otherAccountID INTEGER NOT NULL, "
+				   "amount decimal(15,2) NOT NULL, "
+				   "entryID INTEGER NOT NULL, "
+				   "expiresAt INTEGER NOT NULL) WITHOUT ROWID;") &&
+		   db.exec("create index if not exists idempotencyKeysByExpiry on idempotencyKeys(expiresAt);");
+}
+
+/** @brief Returns why a call with a key can't go ahead
+ *
+ *  @param result Represents what checking or claiming the key found
+ *  @return returns the message to print, or nullptr if the call is fresh or replays one that succeeded
+ */
+const char *idempotencyFailure(idempotencyResult result)
+{
+	switch (result)
+	{
+	case idempotencyResult::mismatched:
+		return "This idempotency key was already used for a different request.";
+	case idempotencyResult::failed:
+		return "Could not check the idempotency key.";
+	default:
+		return nullptr;
+	}
+}
+
+/** @brief Finishes a call whose key was already used
+ *
+ *  @param result Represents what checking or claiming the key found
+ *  @return returns true if the call replays one that succeeded, and false, after printing why, otherwise
+ */
+bool replayEarlier(idempotencyResult result)
+{
+	const char *failure = idempotencyFailure(result);
+	if (failure != nullptr)
+	{
+		cout << failure << endl;
+	}
+	return result == idempotencyResult::replayed;
+}
+
+/** @brief Creates an empty store
+ *
+ *  @param config Represents the settings with the number of keys kept in memory, and how long a key lasts
+ */
+idempotencyStore::idempotencyStore(const bankConfig &config)
+	: shardCapacity((size_t)max(config.idempotencyCacheSize / shardCount, 1)), lifetime(config.idempotencyKeySeconds)
+{
+}
+
+idempotencyStore::shard &idempotencyStore::shardFor(string_view key)
+{
+	return shards[hash<string_view>()(key) % shardCount];
+}
+
+/** @brief Compares a used key with the call now using it
+ *
+ *  @param used Represents the key and the call that first used it
+ *  @param call Represents the call now using it
+ *  @return returns replayed if both calls asked for the same thing, mismatched otherwise
+ */
+idempotencyResult idempotencyStore::compare(const usedKey &used, const idempotentCall &call)
+{
+	bool same = used.operation == call.operation && used.accountID == call.accountID && used.otherAccountID == call.otherAccountID &&
+				used.amount == call.amount;
+	return same ? idempotencyResult::replayed : idempotencyResult::mismatched;
+}
+
+/** @brief Puts a key at the front of its shard
+ *
+ *  Must be called with the shard locked, and the key not in it. The least recently used key is dropped if the shard is full.
+ *  @param keys Represents the shard
+ *  @param used Represents the key and the call that used it
+ */
+void idempotencyStore::keep(shard &keys, usedKey used)
+{
+	keys.recent.push_front(move(used));
+	keys.index.emplace(keys.recent.front().key, keys.recent.begin());
+	if (keys.recent.size() > shardCapacity)
+	{
+		keys.index.erase(keys.recent.back().key);
+		keys.recent.pop_back();
+	}
+}
+
+/** @brief Looks a key up in the table, and keeps it in memory if it is there
+ *
+ *  @param db Represents the database the table is in
+ *  @param key Represents the key
+ *  @param call Represents the call using it
+ *  @return returns fresh if the key is unused or has expired, failed if the table can't be read, otherwise how the calls compare
+ */
+idempotencyResult idempotencyStore::lookUp(database &db, string_view key, const idempotentCall &call)
+{
+	optional<keyRow> stored;
+	bool read = db.forEach<keyRow>("SELECT operation, accountID, otherAccountID, amount, entryID, expiresAt FROM idempotencyKeys "
+								   "WHERE idempotencyKey = ? AND expiresAt > ?;",
+								   [&](const keyRow &row)
+								   { stored = row; },
+								   key, secondsNow());
+	if (!read)
+	{
+		cout << "Could not read idempotency key: " << db.getError() << endl;
+		return idempotencyResult::failed;
+	}
+	if (!stored)
+	{
+		return idempotencyResult::fresh;
+	}
+
+	usedKey used{string(key), stored->operation, stored->accountID, stored->otherAccountID, stored->amount, stored->entryID, stored->expiresAt};
+	idempotencyResult result = compare(used, call);
+
+	shard &keys = shardFor(key);
+	lock_guard<mutex> guard(keys.lock);
+	if (keys.index.find(key) == keys.index.end())
+	{
+		keep(keys, move(used));
+	}
+	return result;
+}
+
+/** @brief Checks a key before a call does anything
+ *
+ *  @param db Represents the database the table is in, read only if the key isn't kept in memory
+ *  @param key Represents the key, or an empty string if the call has none
+ *  @param call Represents the call using it
+ *  @return returns fresh if the call can go ahead, replayed if the same call already succeeded, and mismatched or failed otherwise
+ */
+idempotencyResult idempotencyStore::check(database &db, string_view key, const idempotentCall &call)
+{
+	if (key.empty())
+	{
+		return idempotencyResult::fresh;
+	}
+
+	{
+		shard &keys = shardFor(key);
+		lock_guard<mutex> guard(keys.lock);
+		auto found = keys.index.find(key);
+		if (found != keys.index.end())
+		{
+			if (found->second->expiresAt > secondsNow())
+			{
+				keys.recent.splice(keys.recent.begin(), keys.recent, found->second);
+				return compare(*found->second, call);
+			}
+			keys.recent.erase(found->second);
+			keys.index.erase(found);
+		}
+	}
+	return lookUp(db, key, call);
+}
+
+/** @brief Writes a key inside the database transaction of the call using it
+ *
+ *  An expired key is taken over. Every so often, the keys that have expired are deleted in the same transaction.
+ *  @param db Represents the database the table is in, which must be inside the call's database transaction
+ *  @param key Represents the key, or an empty string if the call has none
+ *  @param call Represents the call using it
+ *  @param entryID Represents the journal entry the call posted
+ *  @return returns fresh if the key is now the call's, or what the call that claimed it first found
+ */
+idempotencyResult idempotencyStore::claim(database &db, string_view key, const idempotentCall &call, long long entryID)
+{
+	if (key.empty())
+	{
+		return idempotencyResult::fresh;
+	}
+	if (++claims % cleanupEvery == 0)
+	{
+		removeExpired(db);
+	}
+
+	long long now = secondsNow();
+	bool ok = db.run("INSERT INTO idempotencyKeys (idempotencyKey, operation, accountID, otherAccountID, amount, entryID, expiresAt) "
+					 "VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7) ON CONFLICT (idempotencyKey) DO UPDATE SET operation = ?2, accountID = ?3, "
+					 "otherAccountID = ?4, amount = ?5, entryID = ?6, expiresAt = ?7 WHERE expiresAt <= ?8;",
+					 key, call.operation, call.accountID, call.otherAccountID, call.amount, entryID, now + lifetime, now);
+	if (!ok)
+	{
+		cout << "Could not write idempotency key: " << db.getError() << endl;
+		return idempotencyResult::failed;
+	}
+	if (db.changes() == 1)
+	{
+		return idempotencyResult::fresh;
+	}
+
+	// Another call committed the key first
+	idempotencyResult earlier = lookUp(db, key, call);
+	return earlier == idempotencyResult::fresh ? idempotencyResult::failed : earlier;
+}
+
+/** @brief Keeps a key in memory once it is committed
+ *
+ *  A key dropped from memory is still in the table until it expires.
+ *  @param key Represents the key, or an empty string if the call had none
+ *  @param call Represents the call that used it
+ *  @param entryID Represents the journal entry the call posted
+ */
+void idempotencyStore::remember(string_view key, const idempotentCall &call, long long entryID)
+{
+	if (key.empty())
+	{
+		return;
+	}
+
+	shard &keys = shardFor(key);
+	lock_guard<mutex> guard(keys.lock);
+	auto found = keys.index.find(key);
+	if (found != keys.index.end())
+	{
+		keys.recent.erase(found->second);
+		keys.index.erase(found);
+	}
+	keep(keys, {string(key), string(call.operation), call.accountID, call.otherAccountID, call.amount, entryID, secondsNow() + lifetime});
+}
+
+/** @brief Deletes expired keys from the table
+ *
+ *  @param db Represents the database the table is in
+ *  @return returns the number of keys deleted, or -1 if they could not be
+ */
+int idempotencyStore::removeExpired(database &db)
+{
+	if (!db.run("DELETE FROM idempotencyKeys WHERE expiresAt <= ?;", secondsNow()))
+	{
+		return -1;
+	}
+	return db.changes();
+}
+
+/** @brief Returns the keys this process checks
+ *
+ *  @return returns the store, created the first time it is asked for
+ */
+idempotencyStore &idempotencyKeys()
+{
+	static idempotencyStore store;
+	return store;
+}
@@ -0,0 +1,242 @@
+/** @brief Posts end-of-day interest to savings accounts.
+ *
+ *  This class represents the end-of-day interest run. Savings balances are loaded from the accounts table in chunks ordered by accountID,
+ *  stored column by column, and the interest for a whole chunk is computed in one pass. Each chunk is then written in a single database
+ *  transaction together with the run's progress, so a run that crashes partway through picks up after the last chunk that was committed.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file interest.cpp
+ *  @class interest "../include/interest.h"
+ */
+
+#include "interest.h"
+
+using namespace std;
+
+/** @brief Prepares an interest run for today
+ *
+ *  Opens the database and loads the progress of today's run if one was already started.
+ *  @param annualRate Represents the yearly interest rate paid on savings accounts, for example 0.02 for 2%
+ *  @param config Represents the settings the database is opened with, and the number of accounts loaded, computed and committed together
+ */
+interest::interest(double annualRate, const bankConfig &config)
+{
+	dailyRate = annualRate / 365.0;
+	chunkSize = config.interestChunkSize > 0 ? config.interestChunkSize : 1;
+	lastAccountID = 0;
+	accountsPosted = 0;
+
+	// The run is keyed by its date, so running the job twice in one day never pays interest twice. The date is taken in UTC, like the
+	// journal's entry times, so it doesn't move when the clock changes for daylight saving time.
+	char date[11];
+	time_t now = time(nullptr);
+	strftime(date, sizeof(date), "%Y-%m-%d", gmtime(&now));
+	runDate = date;
+
+	accountIDs.reserve(chunkSize);
+	balances.reserve(chunkSize);
+	accrued.reserve(chunkSize);
+
+	// Opens the database
+	config.open(DB);
+	createLedger(DB);
+
+	loadProgress();
+}
+
+/** @brief destructor for the interest object
+ *
+ *  The database closes itself, along with the statements it kept for the run.
+ */
+interest::~interest()
+{
+}
+
+/** @brief Posts today's interest to every savings account
+ *
+ *  This method loads, computes and posts one chunk of savings accounts at a time until every account has been visited. If today's run
+ *  already finished, nothing is posted again. If it was interrupted, only the accounts after the last committed chunk are posted.
+ *  @return returns the number of accounts credited by today's run, or -1 if a chunk could not be committed
+ */
+int interest::postDailyInterest()
+{
+	// Checks whether today's run already completed
+	bool completed = DB.queryValue<int>("SELECT completed FROM interestRuns WHERE runDate = ?;", runDate).value_or(0) == 1;
+
+	if (completed)
+	{
+		return accountsPosted;
+	}
+
+	// Works through the accounts one chunk at a time. A short chunk means there are no accounts left.
+	bool lastChunk = false;
+	while (!lastChunk)
+	{
+		if (!loadChunk())
+		{
+			return -1;
+		}
+		lastChunk = (int)accountIDs.size() < chunkSize;
+
+		computeChunk();
+
+		if (!postChunk(lastChunk))
+		{
+			return -1;
+		}
+	}
+	return accountsPosted;
+}
+
+/** @brief Returns the number of accounts credited today
+ *
+ *  @return returns the number of accounts credited by today's run so far
+ */
+int interest::getAccountsPosted()
+{
+	return accountsPosted;
+}
+
+/** @brief Returns the date of the run
+ *
+ *  @return returns the date of the run, as YYYY-MM-DD
+ */
+string interest::getRunDate()
+{
+	return runDate;
+}
+
+/** @brief Loads the progress of today's run
+ *
+ *  This method creates the interestRuns table if needed, starts a row for today's run if there isn't one, and stores the last account that
+ *  was committed so the run can resume after it.
+ */
+void interest::loadProgress()
+{
+	// Creates the table that tracks each day's run
+	DB.exec("create table if not exists interestRuns ("
+			"runDate varchar(10) PRIMARY KEY, "
+			"lastAccountID INTEGER DEFAULT 0, "
+			"accountsPosted INTEGER DEFAULT 0, "
+			"completed INTEGER DEFAULT 0);");
+
+	DB.run("insert or ignore into interestRuns (runDate) values (?);", runDate);
+
+	struct progressRow
+	{
+		int lastAccountID;
+		int accountsPosted;
+		static auto columns() { return make_tuple(&progressRow::lastAccountID, &progressRow::accountsPosted); }
+	};
+
+	optional<progressRow> progress = DB.queryRow<progressRow>("SELECT lastAccountID, accountsPosted FROM interestRuns WHERE runDate = ?;", runDate);
+	if (progress)
+	{
+		lastAccountID = progress->lastAccountID;
+		accountsPosted = progress->accountsPosted;
+	}
+}
+
+/** @brief Loads the next chunk of savings accounts
+ *
+ *  This method reads the next chunkSize savings accounts after lastAccountID, and stores their IDs and balances in separate columns.
+ *  @return returns true if the chunk was read successfully, false otherwise
+ */
+bool interest::loadChunk()
+{
+	accountIDs.clear();
+	balances.clear();
+
+	struct balanceRow
+	{
+		int accountID;
+		double balance;
+		static auto columns() { return make_tuple(&balanceRow::accountID, &balanceRow::balance); }
+	};
+
+	return DB.forEach<balanceRow>("SELECT accountID, balance FROM accounts WHERE accountType = \"savings\" AND accountID > ? ORDER BY accountID LIMIT ?;",
+								  [&](const balanceRow &row)
+								  {
+									  accountIDs.push_back(row.accountID);
+									  balances.push_back(row.balance);
+								  },
+								  lastAccountID, chunkSize);
+}
+
+/** @brief Computes the interest for the loaded chunk
+ *
+ *  This method computes one day of interest for every balance in the chunk, rounded to the cent. The loop has no branches or calls other
+ *  than rounding, and reads and writes contiguous arrays, so the compiler can vectorize it. Accounts that are empty or overdrawn earn nothing.
+ */
+void interest::computeChunk()
+{
+	size_t count = balances.size();
+	accrued.resize(count);
+
+	const double *balance = balances.data();
+	double *result = accrued.data();
+	const double rate = dailyRate * 100.0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		double cents = nearbyint(balance[i] * rate);
+		result[i] = (cents > 0.0 ? cents : 0.0) / 100.0;
+	}
+}
+
+/** @brief Writes the loaded chunk to the database
+ *
+ *  This method posts an "interest" entry from the bank's interest account to every account in the chunk that earned interest, and moves the run's
+ *  progress past the chunk, all in one database transaction. If any write fails, the whole chunk is rolled back.
+ *  @param lastChunk Represents whether this is the final chunk of the run
+ *  @return returns true if the chunk was committed, false otherwise
+ */
+bool interest::postChunk(bool lastChunk)
+{
+	if (accountIDs.empty() && !lastChunk)
+	{
+		return true;
+	}
+
+	if (!DB.exec("BEGIN IMMEDIATE;"))
+	{
+		cout << "Could not start interest batch: " << DB.getError() << endl;
+		return false;
+	}
+
+	bool ok = true;
+	int posted = 0;
+	for (size_t i = 0; i < accountIDs.size() && ok; i++)
+	{
+		if (accrued[i] <= 0.0)
+		{
+			continue;
+		}
+
+		ok = postEntry(DB, "interest", interestAccountID, accountIDs[i], accrued[i]) >= 0;
+
+		posted++;
+	}
+
+	// Records the progress in the same transaction as the postings, so the two can never disagree after a crash.
+	int newLastAccountID = accountIDs.empty() ? lastAccountID : accountIDs.back();
+	ok = ok && DB.run("UPDATE interestRuns SET lastAccountID = ?, accountsPosted = ?, completed = ? WHERE runDate = ?;",
+					  newLastAccountID, accountsPosted + posted, lastChunk ? 1 : 0, runDate);
+
+	if (!ok)
+	{
+		cout << "Interest batch failed: " << DB.getError() << endl;
+		DB.exec("ROLLBACK;");
+		return false;
+	}
+
+	if (!DB.exec("COMMIT;"))
+	{
+		cout << "Could not commit interest batch: " << DB.getError() << endl;
+		DB.exec("ROLLBACK;");
+		return false;
+	}
+
+	lastAccountID = newLastAccountID;
+	accountsPosted += posted;
+	return true;
+}
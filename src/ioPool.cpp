@@ -0,0 +1,136 @@
+/** @brief Runs database work on a pool of threads for coroutines.
+ *
+ *  This class represents the threads that do the bank's SQLite I/O. Each thread opens its own connection when it starts and keeps it until
+ *  the pool is destroyed. Coroutines hand their database work to the pool and suspend. When the work is done, the coroutine is queued to be
+ *  resumed by the front-end thread, so one thread can keep many requests in flight without a thread per session.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file ioPool.cpp
+ *  @class ioPool "../include/ioPool.h"
+ */
+
+#include "ioPool.h"
+
+using namespace std;
+
+/** @brief Starts the pool's threads
+ *
+ *  @param config Represents the settings every connection is opened with, and the number of threads, and so the number of connections
+ */
+ioPool::ioPool(const bankConfig &config)
+	: config(config)
+{
+	stopping = false;
+
+	unsigned int numThreads = config.ioThreads;
+	if (numThreads == 0)
+	{
+		numThreads = 1;
+	}
+	for (unsigned int i = 0; i < numThreads; i++)
+	{
+		workers.emplace_back(&ioPool::work, this);
+	}
+}
+
+/** @brief Stops the pool's threads
+ *
+ *  Work already queued is finished first. Each thread closes its connection as it exits.
+ */
+ioPool::~ioPool()
+{
+	{
+		lock_guard<mutex> guard(jobsLock);
+		stopping = true;
+	}
+	jobsReady.notify_all();
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
+
+/** @brief Queues database work
+ *
+ *  @param work Represents the work, called with the connection of whichever thread picks it up
+ */
+void ioPool::submit(function<void(database &)> work)
+{
+	{
+		lock_guard<mutex> guard(jobsLock);
+		jobs.push_back(move(work));
+	}
+	jobsReady.notify_one();
+}
+
+/** @brief Hands a coroutine back to the front-end thread
+ *
+ *  Called by a pool thread once a coroutine's database work is done. The coroutine is not resumed here, so it never runs on a pool thread.
+ *  @param waiting Represents the coroutine to resume
+ */
+void ioPool::complete(coroutine_handle<> waiting)
+{
+	{
+		lock_guard<mutex> guard(completedLock);
+		completed.push_back(waiting);
+	}
+	completedReady.notify_one();
+}
+
+/** @brief Resumes every coroutine whose work has finished
+ *
+ *  Called by the front-end thread. The coroutines run until their next co_await or until they finish.
+ *  @return returns the number of coroutines resumed
+ */
+size_t ioPool::runCompleted()
+{
+	vector<coroutine_handle<>> ready;
+	{
+		lock_guard<mutex> guard(completedLock);
+		ready.swap(completed);
+	}
+	for (size_t i = 0; i < ready.size(); i++)
+	{
+		ready[i].resume();
+	}
+	return ready.size();
+}
+
+/** @brief Waits for a coroutine to be ready
+ *
+ *  Blocks the front-end thread until at least one coroutine's database work has finished.
+ */
+void ioPool::waitCompleted()
+{
+	unique_lock<mutex> guard(completedLock);
+	completedReady.wait(guard, [this]
+						{ return !completed.empty(); });
+}
+
+/** @brief Runs queued work until the pool is destroyed
+ *
+ *  Each thread opens its own connection. Connections wait on each other's write locks, for the configured busy timeout, instead of
+ *  failing straight away.
+ */
+void ioPool::work()
+{
+	database db;
+	config.open(db);
+	db.exec("PRAGMA foreign_keys = ON;");
+
+	while (true)
+	{
+		function<void(database &)> next;
+		{
+			unique_lock<mutex> guard(jobsLock);
+			jobsReady.wait(guard, [this]
+						   { return stopping || !jobs.empty(); });
+			if (jobs.empty())
+			{
+				return;
+			}
+			next = move(jobs.front());
+			jobs.pop_front();
+		}
+		next(db);
+	}
+}
@@ -0,0 +1,144 @@
+/** @brief Writes the bank's double-entry ledger
+ *
+ *  A business event, such as a transfer, deposit or interest payment, is written as one journal entry that debits one account and
+ *  credits another. A transfer used to be stored as a send row and a receive row that could be written without each other; an entry
+ *  can't be half written, so the ledger always balances. The accounts table keeps each account's balance, updated in the same database
+ *  transaction as the entry.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file ledger.cpp
+ */
+
+#include "ledger.h"
+
+using namespace std;
+
+/** @brief Moves the rows of the old transactions table into the journal
+ *
+ *  A transfer was stored as a send row directly followed by the receive row for the same transfer, and becomes one entry with the send
+ *  row's ID. Deposits, withdrawals, interest and unmatched receive rows are posted against the system accounts. Rows the journal
+ *  can't hold, such as ones of no amount, are dropped. The old table is removed in the same database transaction.
+ *  @param db Represents the database the old table is in
+ *  @return returns true if the rows were moved, or there was nothing to move
+ */
+static bool migrateTransactions(database &db)
+{
+	const char *findOldTable = "SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = 'transactions';";
+	if (db.queryValue<int>(findOldTable).value_or(0) == 0)
+	{
+		return true;
+	}
+
+	// Another process may have moved the rows while this one waited for the lock
+	if (!db.exec("BEGIN IMMEDIATE;"))
+	{
+		return false;
+	}
+	if (db.queryValue<int>(findOldTable).value_or(0) == 0)
+	{
+		return db.exec("COMMIT;");
+	}
+
+	bool ok = db.run("INSERT OR IGNORE INTO journal (entryID, entryType, debitAccountID, creditAccountID, amount, creditAmount, entryTime) "
+					 "SELECT t.transactionID, "
+					 "CASE t.transactionType WHEN 'send' THEN 'transfer' WHEN 'receive' THEN 'deposit' ELSE t.transactionType END, "
+					 "CASE t.transactionType WHEN 'deposit' THEN ? WHEN 'receive' THEN ? WHEN 'interest' THEN ? ELSE t.senderAccountID END, "
+					 "CASE t.transactionType WHEN 'send' THEN t.receiverAccountID WHEN 'withdraw' THEN ? ELSE t.senderAccountID END, "
+					 "t.amount, COALESCE(r.amount, t.amount), t.transactionTime "
+					 "FROM transactions AS t LEFT JOIN transactions AS r ON t.transactionType = 'send' AND r.transactionID = t.transactionID + 1 "
+					 "AND r.transactionType = 'receive' AND r.senderAccountID = t.receiverAccountID "
+					 "WHERE NOT (t.transactionType = 'receive' AND EXISTS (SELECT 1 FROM transactions AS s WHERE s.transactionID = t.transactionID - 1 "
+					 "AND s.transactionType = 'send' AND s.receiverAccountID = t.senderAccountID));",
+					 cashAccountID, cashAccountID, interestAccountID, cashAccountID) &&
+			  db.exec("DROP TABLE transactions;") &&
+			  db.exec("COMMIT;");
+	if (!ok)
+	{
+		cout << "Could not move transactions into the journal: " << db.getError() << endl;
+		db.exec("ROLLBACK;");
+	}
+	return ok;
+}
+
+/** @brief Creates the journal
+ *
+ *  @param db Represents the database the journal is kept in
+ *  @return returns true if the journal exists afterwards, and holds every row of the old transactions table
+ */
+bool createLedger(database &db)
+{
+	bool ok = db.exec("create table if not exists journal ("
+					  "entryID INTEGER PRIMARY KEY AUTOINCREMENT, "
+					  "entryType varchar(10) NOT NULL, "
+					  "debitAccountID INTEGER NOT NULL, "
+					  "creditAccountID INTEGER NOT NULL, "
+					  "amount decimal(15,2) NOT NULL CHECK (amount > 0), "
+					  "creditAmount decimal(15,2) NOT NULL CHECK (creditAmount > 0), "
+					  "entryTime DATETIME default CURRENT_TIMESTAMP NOT NULL);") &&
+			  db.exec("create index if not exists journalByDebit on journal(debitAccountID);") &&
+			  db.exec("create index if not exists journalByCredit on journal(creditAccountID);") &&
+			  db.exec("create index if not exists journalByTime on journal(entryTime);");
+	return ok && migrateTransactions(db);
+}
+
+/** @brief Writes one entry
+ *
+ *  @param db Represents the database the journal is kept in
+ *  @param entryType Represents the kind of event, such as "transfer"
+ *  @param debitAccountID Represents the account the money leaves
+ *  @param creditAccountID Represents the account the money arrives in
+ *  @param amount Represents the amount taken from the debited account, in its currency
+ *  @param creditAmount Represents the amount given to the credited account, in its currency
+ *  @return returns the new entry's ID, or -1 if it could not be written
+ */
+long long recordEntry(database &db, string_view entryType, int debitAccountID, int creditAccountID, double amount, double creditAmount)
+{
+	if (!db.run("INSERT INTO journal(entryType, debitAccountID, creditAccountID, amount, creditAmount) VALUES (?, ?, ?, ?, ?);",
+				entryType, debitAccountID, creditAccountID, amount, creditAmount))
+	{
+		return -1;
+	}
+	return db.lastInsertID();
+}
+
+/** @brief Writes one entry and applies it to the accounts' balances
+ *
+ *  System accounts have no row in the accounts table, so only the customer accounts' balances are changed.
+ *  @param db Represents the database the journal is kept in, which must be inside a database transaction
+ *  @param entryType Represents the kind of event, such as "transfer"
+ *  @param debitAccountID Represents the account the money leaves
+ *  @param creditAccountID Represents the account the money arrives in
+ *  @param amount Represents the amount taken from the debited account, in its currency
+ *  @param creditAmount Represents the amount given to the credited account, in its currency
+ *  @return returns the new entry's ID, or -1 if the entry or either balance could not be written
+ */
+long long postEntry(database &db, string_view entryType, int debitAccountID, int creditAccountID, double amount, double creditAmount)
+{
+	long long entryID = recordEntry(db, entryType, debitAccountID, creditAccountID, amount, creditAmount);
+	if (entryID < 0)
+	{
+		return -1;
+	}
+	if (debitAccountID >= 0 && (!db.run("UPDATE accounts SET balance = balance - ? WHERE accountID = ?;", amount, debitAccountID) || db.changes() != 1))
+	{
+		return -1;
+	}
+	if (creditAccountID >= 0 && (!db.run("UPDATE accounts SET balance = balance + ? WHERE accountID = ?;", creditAmount, creditAccountID) || db.changes() != 1))
+	{
+		return -1;
+	}
+	return entryID;
+}
+
+/** @brief Writes one entry between accounts of the same currency and applies it to their balances
+ *
+ *  @param db Represents the database the journal is kept in, which must be inside a database transaction
+ *  @param entryType Represents the kind of event, such as "deposit"
+ *  @param debitAccountID Represents the account the money leaves
+ *  @param creditAccountID Represents the account the money arrives in
+ *  @param amount Represents the amount moved
+ *  @return returns the new entry's ID, or -1 if the entry or either balance could not be written
+ */
+long long postEntry(database &db, string_view entryType, int debitAccountID, int creditAccountID, double amount)
+{
+	return postEntry(db, entryType, debitAccountID, creditAccountID, amount, amount);
+}
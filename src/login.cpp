@@ -11,85 +11,99 @@
 
 using namespace std;
 
-/** @brief Helps with executing sql.
- *  @param unused This variable is not used and serves no purpose.
- *  @param numColumns The number of columns in the table.
- *  @param value List of the values from the current row from each column.
- *  @param columns Name of each column in the table.
- *  @return Always returns to fit the base necessities.
- * 
- *  This function is used when executing sql statements.
-*/  
-static int callback(void *unused, int numColumns, char **value, char **columns) {
-    for (int i = 0; i < numColumns; i++) {
-        cout << "Name = " << columns[i] << "   Value = " << value[i] << endl;
-        }
-    return 0;
-}
-
-/** @brief Creats the bank's database.
- *  
- *  Creates an sqlite database for the bank including a users table, accounts table, and transactions table.
+/** @brief Creates the bank's tables.
+ *  @param db The database to create the tables in.
+ *  @return Returns true if every table exists afterwards, and false otherwise.
+ *
+ *  Creates the users table, accounts table, journal, and idempotency keys if they don't exist yet, and turns on foreign keys for the connection. Users are
+ *  keyed by an integer userID, which accounts refer to, and the username is only looked up once to find it.
 */
-login::login() {
-    errorMessage = 0;
-	// opens the database file, returns an error if it fails
-    rc = sqlite3_open("bankDatabase.db", &db);
-    if (rc) {
-        cout << "Can't open database" << endl;
-	}
-
+bool createBankTables(database &db) {
     //Allowing the compatibility of foreign keys
-    sql = "PRAGMA foreign_keys = ON;";
-    rc = sqlite3_exec(db, sql.c_str(), callback, 0, &errorMessage);
+    db.exec("PRAGMA foreign_keys = ON;");
 
 	// Creates the user table
-    sql = "create table if not exists users (" \
-    "username varchar(20) PRIMARY KEY, " \
+    bool ok = db.exec("create table if not exists users (" \
+    "userID INTEGER PRIMARY KEY AUTOINCREMENT, " \
+    "username varchar(20) NOT NULL UNIQUE, " \
     "password varchar(20) NOT NULL, " \
     "name varchar(20), " \
     "creditScore INTEGER DEFAULT 300, " \
     "loanDebt decimal(15,2) DEFAULT 0, " \
-    "userType varchar(10) NOT NULL);";
-    rc = sqlite3_exec(db, sql.c_str(), callback, 0, &errorMessage);
+    "userType varchar(10) NOT NULL);");
 
     // Creates the accounts table
-    sql = "create table if not exists accounts (" \
+    ok = ok && db.exec("create table if not exists accounts (" \
     "accountID INTEGER PRIMARY KEY AUTOINCREMENT, " \
-    "username varchar(20), " \
+    "userID INTEGER NOT NULL, " \
     "accountType varchar(15) NOT NULL, " \
     "initialBalance decimal(15,2), " \
     "balance decimal(15,2), " \
-    "FOREIGN KEY (username) REFERENCES users(username) ON DELETE CASCADE);";
-    rc = sqlite3_exec(db, sql.c_str(), callback, 0, &errorMessage);
+    "currency varchar(3) NOT NULL DEFAULT 'CAD', " \
+    "FOREIGN KEY (userID) REFERENCES users(userID) ON DELETE CASCADE);");
+    ok = ok && addCurrencyColumn(db);
+    ok = ok && addUserIDs(db);
+    ok = ok && db.exec("create index if not exists accountsByUser on accounts(userID);");
 
-    // Creates the transactions table
-    sql = "create table if not exists transactions (" \
-    "transactionID INTEGER PRIMARY KEY AUTOINCREMENT, " \
-    "senderAccountID INTEGER, " \
-    "receiverAccountID INTEGER, " \
-    "transactionType varchar(10) NOT NULL, " \
-    "amount decimal(15,2) NOT NULL, " \
-    "transactionTime DATETIME default CURRENT_TIMESTAMP NOT NULL, " \
-    "FOREIGN KEY(senderAccountID) REFERENCES accounts(accountID) ON DELETE CASCADE);";
-    rc = sqlite3_exec(db, sql.c_str(), callback, 0, &errorMessage);
+    // Creates the journal every movement of money is written to, the keys that stop a retry writing to it twice, and the end of day
+    // balances past balances are read from
+    ok = ok && createLedger(db);
+    ok = ok && createIdempotencyKeys(db);
+    ok = ok && createBalanceCheckpoints(db);
+    return ok;
+}
+
+/** @brief Creats the bank's database.
+ *  @param config The settings the database is opened with.
+ *  
+ *  Creates an sqlite database for the bank including a users table, accounts table, and journal, and builds the existence filters
+ *  from them.
+*/
+login::login(const bankConfig &config) {
+	// opens the database file with the configured pragmas, returns an error if it fails
+    config.open(db);
+
+    createBankTables(db);
+
+    // The seeds are inserted and published to the change log together, like any other new user or account, so every process's
+    // existence filters see them
+    db.exec("BEGIN IMMEDIATE;");
+    int lastUserID = db.queryValue<int>("SELECT COALESCE(MAX(userID), 0) FROM users;").value_or(0);
+    int lastAccountID = db.queryValue<int>("SELECT COALESCE(MAX(accountID), 0) FROM accounts;").value_or(0);
 
 	// Inserting four users including one admin into the users table
-    sql = "insert or ignore into users " \
+    db.exec("insert or ignore into users " \
     "(username, password, name, userType) values " \
     "(\"admin001\",\"adminpassword\",\"bankAdmin\",\"admin\")," \
 	"(\"user001\",\"oneuser\",\"bob\",\"regular\")," \
 	"(\"user002\",\"twouser\",\"jannet\",\"regular\")," \
-	"(\"user003\",\"threeuser\",\"sarah\",\"regular\");";
-    rc = sqlite3_exec(db, sql.c_str(), callback, 0, &errorMessage);
+	"(\"user003\",\"threeuser\",\"sarah\",\"regular\");");
+
+    // Inserting three accounts into the accounts table, under the IDs the users were given
+    db.exec("insert or ignore into accounts " \
+    "(userID, accountType, initialBalance, balance) " \
+    "select userID, \"chequing\", 1234.22, 1234.55 from users where username = \"user001\" union all " \
+    "select userID, \"savings\", 12134.22, 12434.55 from users where username = \"user001\" union all " \
+    "select userID, \"savings\", 130.60, 654.89 from users where username = \"user003\";");
 
-    // Inserting three accounts into the accounts table
-    sql = "insert or ignore into accounts " \
-    "(username, accountType, initialBalance, balance) values " \
-    "(\"user001\",\"chequing\",1234.22,1234.55), " \
-    "(\"user001\",\"savings\",12134.22,12434.55), " \
-    "(\"user003\",\"savings\",130.60,654.89);";
-    rc = sqlite3_exec(db, sql.c_str(), callback, 0, &errorMessage);
+    struct seedRow {
+        int accountID;
+        double balance;
+        string username;
+        static auto columns() { return make_tuple(&seedRow::accountID, &seedRow::balance, &seedRow::username); }
+    };
+    vector<changeEvent> seeded;
+    db.forEach<seedRow>("select 0, 0, username from users where userID > ?;", [&](const seedRow &row) {
+        seeded.push_back({changeType::userCreated, 0, 0, 0, row.username});
+    }, lastUserID);
+    db.forEach<seedRow>("select a.accountID, a.balance, u.username from accounts as a, users as u " \
+                        "where a.accountID > ? and u.userID = a.userID;", [&](const seedRow &row) {
+        seeded.push_back({changeType::accountOpened, row.accountID, 0, row.balance, row.username});
+    }, lastAccountID);
+    changeFeed().commit(db, seeded);
+
+    // Reads every account ID and username into memory, so lookups of ones that don't exist never reach the database
+    existenceFilters().load(config);
 }
 
 /** @brief Checks if the user can login with their information.
@@ -97,39 +111,24 @@ login::login() {
  *  @param password The inserted password that will be checked in the database.
  *  @return Returns true if the user can login with their inserted information, and false otherwise.
  * 
- *  Takes a username and password, and searchs the user table for a row that contains both the given username and password.
+ *  Takes a username and password, and searchs the user table for a row that contains both the given username and password. The user's
+ *  ID is remembered, so nothing after login has to look the username up again.
 */
 bool login::verifyLogin(string username, string password) {
-    accountFound = false;
-    sql = "SELECT username, password FROM users;";
-    sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr);
-    step = sqlite3_step(stmt);
-
-    // Looping through each row
-    while (step == 100) {
-        string user(reinterpret_cast<char const*>(sqlite3_column_text(stmt, 0)));
-        string pass(reinterpret_cast<char const*>(sqlite3_column_text(stmt, 1)));
-        if (username == user && password == pass) {
-            accountFound = true;
-        }
-        step = sqlite3_step(stmt);
+    optional<int> userID = db.queryValue<int>("SELECT userID FROM users WHERE username = ? AND password = ?;", username, password);
+    accountFound = userID.has_value();
+    if (accountFound) {
+        userIDs().remember(username, *userID);
     }
-    sqlite3_finalize(stmt);
 	return accountFound;
 }
 
 /** @brief Checks the user type.
  *  @param username The username of the user where we will check the user type for.
- *  @return The user type of the user, which is either "regular" or "admin".
+ *  @return The user type of the user, which is either "regular" or "admin", or an empty string if the user does not exist.
  *  
  *  Takes a username, searches the users table for the user's account type, and returns it.
 */
 string login::checkUserType(string username) {
-	sqlite3_stmt* stmt;
-	string command = "SELECT userType FROM users WHERE username = \"" + username + "\";";
-	sqlite3_prepare_v2(db, command.c_str(), -1, &stmt, 0);
-	sqlite3_step(stmt);
-	string result = string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
-	return result;
+	return db.queryValue<string>("SELECT userType FROM users WHERE username = ?;", username).value_or("");
 }
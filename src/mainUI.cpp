@@ -5,7 +5,10 @@
 *	Description: 	The main control of the program
 */
 
-#include "login.h"
+#include "sessionManager.h"
+#include "accountPurger.h"
+#include "paymentScheduler.h"
+#include "balanceCheckpoints.h"
 
 using namespace std;
 
@@ -16,21 +19,25 @@ using namespace std;
 */ 
 int main() {
     string username, password;      // Username and password that the user is about to enter
-    bool loginVerification = false; // Verifies if the entered username and password are in the database
-    login loginPage;                // Object to activate login.cpp's constructor
+    string token;                   // Session token given to the user once their login is verified
+    const bankConfig &config = bankSettings(); // Read from bank.conf and BANK_ environment variables
+    sessionManager sessions(config);    // Verifies logins and keeps each logged in user's data between requests
+    accountPurger purger(config);       // Detaches the journal entries of accounts customers delete and users administrators remove
+    paymentScheduler scheduler(config); // Makes customers' scheduled payments as they fall due
+    checkpointWriter checkpoints(config); // Writes every account's end of day balance after each midnight UTC
 
-    // Asks the user to enter a username and password until their login is verified with loginVerification
-    while (!loginVerification) {
+    // Asks the user to enter a username and password until their login is verified and a session is started
+    while (token.empty()) {
         cout << "Enter username: ";
         getline(cin, username);
         cout << "Enter password: ";
         getline(cin, password);
 
         // Checks if the username and password are in the database
-        if (loginPage.verifyLogin(username, password)) {
+        token = sessions.startSession(username, password);
+        if (!token.empty()) {
             cout << "Log in accepted" << endl;
-            loginVerification = true;
-            cout << "Account Type for " << username << " is: " << loginPage.checkUserType(username) << endl;
+            cout << "Account Type for " << username << " is: " << sessions.getUserType(token) << endl;
         } else {
             cout << "Username and password do not match. Please try again." << endl;
         }
@@ -0,0 +1,514 @@
+/** @brief Makes scheduled and recurring payments when they fall due
+ *
+ *  Scheduled payments are kept in the scheduledPayments table. The scheduler only holds the payments due within the next hour or so,
+ *  in a timing wheel with one slot per second, and loads more from the table as time moves on. Each tick it takes every payment that
+ *  has fallen due, groups them by sending account, and makes them in large batches: each sender's balance is read once and debited
+ *  once per batch, however many standing orders it has. A payment the sender can't cover is tried again later, and given up on after
+ *  a few attempts.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file paymentScheduler.cpp
+ *  @class paymentScheduler "../include/paymentScheduler.h"
+ */
+
+#include <algorithm>
+#include <map>
+#include <climits>
+#include "paymentScheduler.h"
+
+using namespace std;
+
+// One scheduled payment, as it is read from the table
+struct scheduledRow
+{
+    long long paymentID;
+    long long nextDue;
+    int senderAccountID;
+    int receiverAccountID;
+    double amount;
+    string_view frequency;
+    int dayOfMonth;
+    int remainingRuns;
+    int attempts;
+
+    static auto columns()
+    {
+        return make_tuple(&scheduledRow::paymentID, &scheduledRow::nextDue, &scheduledRow::senderAccountID, &scheduledRow::receiverAccountID,
+                          &scheduledRow::amount, &scheduledRow::frequency, &scheduledRow::dayOfMonth, &scheduledRow::remainingRuns,
+                          &scheduledRow::attempts);
+    }
+};
+
+// The sending account of a group of payments
+struct senderRow
+{
+    double balance;
+    string username;
+    string currency;
+
+    static auto columns()
+    {
+        return make_tuple(&senderRow::balance, &senderRow::username, &senderRow::currency);
+    }
+};
+
+static const char *selectScheduled = "SELECT paymentID, nextDue, senderAccountID, receiverAccountID, amount, frequency, dayOfMonth, "
+                                     "remainingRuns, attempts FROM scheduledPayments ";
+
+bool parsePaymentFrequency(string_view name, paymentFrequency &frequency)
+{
+	if (name == "once")
+	{
+		frequency = paymentFrequency::once;
+	}
+	else if (name == "daily")
+	{
+		frequency = paymentFrequency::daily;
+	}
+	else if (name == "weekly")
+	{
+		frequency = paymentFrequency::weekly;
+	}
+	else if (name == "monthly")
+	{
+		frequency = paymentFrequency::monthly;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+string_view paymentFrequencyName(paymentFrequency frequency)
+{
+	switch (frequency)
+	{
+	case paymentFrequency::daily:
+		return "daily";
+	case paymentFrequency::weekly:
+		return "weekly";
+	case paymentFrequency::monthly:
+		return "monthly";
+	default:
+		return "once";
+	}
+}
+
+/** @brief Works out when a recurring payment is next due
+ *
+ *  Monthly payments stay on the same day of the month, or the month's last day in months too short for it.
+ *  @param due Represents when the payment was last due, in seconds since 1970
+ *  @param frequency Represents how often the payment repeats
+ *  @param dayOfMonth Represents the day of the month a monthly payment is made on
+ *  @return returns when the payment is due next, or due if it doesn't repeat
+ */
+long long nextPaymentTime(long long due, paymentFrequency frequency, int dayOfMonth)
+{
+	switch (frequency)
+	{
+	case paymentFrequency::daily:
+		return due + 86400;
+	case paymentFrequency::weekly:
+		return due + 7 * 86400;
+	case paymentFrequency::monthly:
+	{
+		time_t when = (time_t)due;
+		struct tm parts;
+		gmtime_r(&when, &parts);
+		parts.tm_mon += 1;
+		parts.tm_mday = 1;
+		timegm(&parts); // Normalizes the month and year
+		static const int monthDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+		int year = parts.tm_year + 1900;
+		int lastDay = monthDays[parts.tm_mon] + (parts.tm_mon == 1 && (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)));
+		parts.tm_mday = min(dayOfMonth, lastDay);
+		return (long long)timegm(&parts);
+	}
+	default:
+		return due;
+	}
+}
+
+/** @brief Creates the table of scheduled payments
+ *
+ *  Payment IDs are never reused, so the scheduler can tell new payments apart by ID alone.
+ *  @param db Represents the database the payments are kept in
+ *  @return returns true if the table exists afterwards, false otherwise
+ */
+bool createScheduledPayments(database &db)
+{
+	return db.exec("create table if not exists scheduledPayments ("
+				   "paymentID INTEGER PRIMARY KEY AUTOINCREMENT, "
+				   "senderAccountID INTEGER NOT NULL, "
+				   "receiverAccountID INTEGER NOT NULL, "
+				   "amount DOUBLE NOT NULL, "
+				   "frequency TEXT NOT NULL, "
+				   "dayOfMonth INTEGER NOT NULL, "
+				   "nextDue INTEGER NOT NULL, "
+				   "remainingRuns INTEGER NOT NULL default -1, "
+				   "attempts INTEGER NOT NULL default 0, "
+				   "active INTEGER NOT NULL default 1, "
+				   "lastError TEXT NOT NULL default '');"
+				   "create index if not exists scheduledPaymentsByDue on scheduledPayments(active, nextDue);");
+}
+
+/** @brief Schedules a payment
+ *
+ *  @param db Represents the database the payment is kept in
+ *  @param senderAccountID Represents the account the money is sent from
+ *  @param receiverAccountID Represents the account the money is sent to
+ *  @param amount Represents the amount sent each time
+ *  @param firstDue Represents when the first payment is made, in seconds since 1970
+ *  @param frequency Represents how often the payment repeats
+ *  @param runs Represents how many payments are made, or -1 to keep paying until the payment is cancelled
+ *  @return returns the payment's ID, or -1 if it couldn't be stored
+ */
+long long schedulePayment(database &db, int senderAccountID, int receiverAccountID, double amount, long long firstDue,
+						  paymentFrequency frequency, int runs)
+{
+	time_t when = (time_t)firstDue;
+	struct tm parts;
+	gmtime_r(&when, &parts);
+
+	createScheduledPayments(db);
+	if (!db.run("INSERT INTO scheduledPayments(senderAccountID, receiverAccountID, amount, frequency, dayOfMonth, nextDue, remainingRuns) "
+				"VALUES (?, ?, ?, ?, ?, ?, ?);",
+				senderAccountID, receiverAccountID, amount, paymentFrequencyName(frequency), parts.tm_mday, firstDue, runs))
+	{
+		cout << "Could not schedule payment: " << db.getError() << endl;
+		return -1;
+	}
+	return db.lastInsertID();
+}
+
+/** @brief Opens the database and starts making payments
+ *
+ *  @param config Represents the settings the database is opened with, how far ahead payments are loaded into the wheel, the most
+ *  payments made in one database transaction, how many times a payment the sender can't cover is tried before it is given up on, and
+ *  the time between attempts
+ *  @param background Represents whether to start a thread that runs every second. Without one, runDue has to be called.
+ */
+paymentScheduler::paymentScheduler(const bankConfig &config, bool background)
+{
+	horizon = max(config.schedulerHorizon, 2);
+	batchSize = max(config.schedulerBatchSize, 1);
+	maxAttempts = max(config.schedulerMaxAttempts, 1);
+	retrySeconds = max(config.schedulerRetrySeconds, 1);
+	wheel.resize(2 * horizon);
+	currentSecond = LLONG_MIN;
+	loadedUntil = LLONG_MIN;
+	lastPaymentID = 0;
+	loaded = 0;
+	stopping = false;
+
+	config.open(DB);
+	createScheduledPayments(DB);
+	addUserIDs(DB);
+	createLedger(DB);
+
+	if (background)
+	{
+		worker = thread(&paymentScheduler::work, this);
+	}
+}
+
+/** @brief Stops making payments
+ *
+ *  Waits for the current tick to finish. Payments left due are made the next time a scheduler runs.
+ */
+paymentScheduler::~paymentScheduler()
+{
+	{
+		lock_guard<mutex> guard(stateLock);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+}
+
+/** @brief Puts a payment in the slot of the second it is due, or the current slot if it is overdue
+ *
+ *  @param payment Represents the payment
+ */
+void paymentScheduler::add(const duePayment &payment)
+{
+	wheel[(size_t)(max(payment.due, currentSecond) % (long long)wheel.size())].push_back(payment);
+	loaded++;
+}
+
+/** @brief Brings the wheel up to date with the table
+ *
+ *  Payments added since the last load are put in the wheel if they are due before loadedUntil, and the rest wait for the horizon to
+ *  reach them. Once less than half the horizon is loaded, the payments due up to a full horizon ahead are loaded.
+ *  @param now Represents the current time
+ */
+void paymentScheduler::load(long long now)
+{
+	auto addRow = [this](const scheduledRow &row)
+	{
+		duePayment payment = {row.paymentID, row.nextDue, row.senderAccountID, row.receiverAccountID, row.amount,
+							  paymentFrequency::once, row.dayOfMonth, row.remainingRuns, row.attempts};
+		parsePaymentFrequency(row.frequency, payment.frequency);
+		add(payment);
+	};
+
+	if (loadedUntil == LLONG_MIN)
+	{
+		// The first load takes every payment already due. Payments added after the newest ID read here are found by the next load.
+		lastPaymentID = DB.queryValue<long long>("SELECT COALESCE(MAX(paymentID), 0) FROM scheduledPayments;").value_or(0);
+		loadedUntil = now + horizon;
+		DB.forEach<scheduledRow>(string(selectScheduled) + "WHERE active = 1 AND nextDue < ? AND paymentID <= ?;", addRow,
+								 loadedUntil, lastPaymentID);
+		return;
+	}
+
+	DB.forEach<scheduledRow>(string(selectScheduled) + "WHERE paymentID > ? AND active = 1 ORDER BY paymentID;", [&](const scheduledRow &row)
+							 {
+								 lastPaymentID = row.paymentID;
+								 if (row.nextDue < loadedUntil)
+								 {
+									 addRow(row);
+								 } },
+							 lastPaymentID);
+
+	if (loadedUntil - now < horizon / 2)
+	{
+		long long until = now + horizon;
+		DB.forEach<scheduledRow>(string(selectScheduled) + "WHERE active = 1 AND nextDue >= ? AND nextDue < ? AND paymentID <= ?;", addRow,
+								 loadedUntil, until, lastPaymentID);
+		loadedUntil = until;
+	}
+}
+
+/** @brief Makes a list of due payments
+ *
+ *  Each batch is made in three passes, so each table is written in key order rather than jumping about:
+ *
+ *      decide      every sender's balance, less its card holds, is read once, and its payments are paid, in the order they fell due,
+ *                  while it covers them
+ *      schedule    the payments' rows are moved on, in ID order, but only if each is still active and still due when it was loaded,
+ *                  so a payment cancelled since it was loaded, or already made by another scheduler, is skipped
+ *      move money  one journal entry is written for each payment, converted to the receiver's currency, and each account's balance
+ *                  is changed once by its net amount, in ID order
+ *
+ *  A batch that fails is rolled back and put back in the wheel to be tried on the next tick.
+ *  @param payments Represents the payments that are due
+ *  @param now Represents the current time
+ *  @return returns the number of payments made
+ */
+int paymentScheduler::execute(vector<duePayment> &payments, long long now)
+{
+	// What a batch does with one payment
+	struct plan
+	{
+		duePayment payment;
+		duePayment next;
+		bool pay;
+		bool finished;
+		string_view error;
+		bool moved;    // The payment's row was moved on, so the plan goes ahead
+		double credit; // The amount the receiver gets, in the receiver's currency
+		const senderRow *sender;
+	};
+
+	// Batches are taken in ID order, so each one writes a narrow range of the table, and then grouped by sender
+	sort(payments.begin(), payments.end(), [](const duePayment &a, const duePayment &b)
+		 { return a.paymentID < b.paymentID; });
+
+	int sent = 0;
+	for (size_t start = 0; start < payments.size(); start += batchSize)
+	{
+		size_t end = min(payments.size(), start + batchSize);
+		sort(payments.begin() + start, payments.begin() + end, [](const duePayment &a, const duePayment &b)
+			 { return a.senderAccountID != b.senderAccountID ? a.senderAccountID < b.senderAccountID : a.due != b.due ? a.due < b.due : a.paymentID < b.paymentID; });
+		vector<plan> plans;
+		vector<senderRow> senders; // Kept for the senders' currencies, and their usernames for the change log
+		plans.reserve(end - start);
+		senders.reserve(end - start);
+		bool ok = DB.exec("BEGIN IMMEDIATE;");
+
+		for (size_t i = start; ok && i < end;)
+		{
+			int senderAccountID = payments[i].senderAccountID;
+			optional<senderRow> sender = DB.queryRow<senderRow>("SELECT a.balance, u.username, a.currency FROM accounts AS a, users AS u "
+																"WHERE a.accountID = ? AND u.userID = a.userID;", senderAccountID);
+			senders.push_back(sender.value_or(senderRow{0, "", string(baseCurrency)}));
+			double balance = sender ? sender->balance - authorizationHolds().held(DB, senderAccountID) : 0;
+
+			for (; i < end && payments[i].senderAccountID == senderAccountID; i++)
+			{
+				plan next = {payments[i], payments[i], sender && balance >= payments[i].amount, false, "", false, 0, &senders.back()};
+				if (next.pay)
+				{
+					balance -= next.payment.amount;
+					next.next.attempts = 0;
+					next.next.remainingRuns -= next.next.remainingRuns > 0;
+					next.finished = next.payment.frequency == paymentFrequency::once || next.next.remainingRuns == 0;
+					next.next.due = next.finished ? next.payment.due : nextPaymentTime(next.payment.due, next.payment.frequency, next.payment.dayOfMonth);
+				}
+				else
+				{
+					next.next.attempts++;
+					next.finished = !sender || next.next.attempts >= maxAttempts;
+					next.next.due = now + retrySeconds;
+					next.error = sender ? "insufficient funds" : "sender account closed";
+				}
+				plans.push_back(next);
+			}
+		}
+
+		// Payments to closed accounts are given up on, and the rest are converted to the receiver's currency. A payment between
+		// currencies with no rate is tried again later.
+		shared_ptr<const rateTable> rates = currencyRates().current();
+		vector<int> receivers;
+		for (const plan &next : plans)
+		{
+			receivers.push_back(next.payment.receiverAccountID);
+		}
+		sort(receivers.begin(), receivers.end());
+		receivers.erase(unique(receivers.begin(), receivers.end()), receivers.end());
+		vector<optional<string>> receiverCurrencies(receivers.size());
+		for (size_t i = 0; ok && i < receivers.size(); i++)
+		{
+			receiverCurrencies[i] = DB.queryValue<string>("SELECT currency FROM accounts WHERE accountID = ?;", receivers[i]);
+		}
+		for (plan &next : plans)
+		{
+			size_t position = lower_bound(receivers.begin(), receivers.end(), next.payment.receiverAccountID) - receivers.begin();
+			if (next.pay && !receiverCurrencies[position])
+			{
+				next.pay = false;
+				next.finished = true;
+				next.error = "receiver account closed";
+			}
+			else if (next.pay && !rates->convert(next.payment.amount, next.sender->currency, *receiverCurrencies[position], next.credit))
+			{
+				next.pay = false;
+				next.next = next.payment;
+				next.next.attempts++;
+				next.next.due = now + retrySeconds;
+				next.finished = next.next.attempts >= maxAttempts;
+				next.error = "no exchange rate";
+			}
+		}
+
+		vector<plan *> byID;
+		for (plan &next : plans)
+		{
+			byID.push_back(&next);
+		}
+		sort(byID.begin(), byID.end(), [](const plan *a, const plan *b)
+			 { return a->payment.paymentID < b->payment.paymentID; });
+		for (size_t i = 0; ok && i < byID.size(); i++)
+		{
+			plan &next = *byID[i];
+			ok = DB.run("UPDATE scheduledPayments SET nextDue = ?, remainingRuns = ?, attempts = ?, active = ?, lastError = ? "
+						"WHERE paymentID = ? AND active = 1 AND nextDue = ?;",
+						next.next.due, next.next.remainingRuns, next.next.attempts, next.finished ? 0 : 1, next.error,
+						next.payment.paymentID, next.payment.due);
+			next.moved = ok && DB.changes() == 1;
+		}
+
+		vector<changeEvent> events;
+		map<int, double> netChange;
+		for (size_t i = 0; ok && i < plans.size(); i++)
+		{
+			const plan &next = plans[i];
+			if (next.moved && next.pay)
+			{
+				ok = recordEntry(DB, "transfer", next.payment.senderAccountID, next.payment.receiverAccountID, next.payment.amount, next.credit) >= 0;
+				netChange[next.payment.senderAccountID] -= next.payment.amount;
+				netChange[next.payment.receiverAccountID] += next.credit;
+				events.push_back({changeType::transfer, next.payment.senderAccountID, next.payment.receiverAccountID, next.payment.amount, next.sender->username});
+			}
+		}
+		for (map<int, double>::iterator change = netChange.begin(); ok && change != netChange.end(); change++)
+		{
+			ok = change->second == 0 || DB.run("UPDATE accounts SET balance = balance + ? WHERE accountID = ?;", change->second, change->first);
+		}
+
+		if (!ok)
+		{
+			cout << "Could not make scheduled payments: " << DB.getError() << endl;
+			DB.exec("ROLLBACK;");
+		}
+		if (!ok || !changeFeed().commit(DB, events))
+		{
+			for (size_t i = start; i < end; i++)
+			{
+				add(payments[i]);
+			}
+			continue;
+		}
+
+		// Payments due again before loadedUntil are put back in the wheel, as the next load won't pick them up
+		sent += (int)events.size();
+		for (const plan &next : plans)
+		{
+			if (next.moved && !next.finished && next.next.due < loadedUntil)
+			{
+				add(next.next);
+			}
+		}
+	}
+	return sent;
+}
+
+/** @brief Makes every payment that has fallen due
+ *
+ *  @param now Represents the current time, in seconds since 1970
+ *  @return returns the number of payments made
+ */
+int paymentScheduler::runDue(long long now)
+{
+	lock_guard<mutex> guard(databaseLock);
+	if (currentSecond == LLONG_MIN)
+	{
+		currentSecond = now;
+	}
+	load(now);
+
+	// Empties the slots from the last tick up to now. Payments due later in the same slot are left where they are.
+	vector<duePayment> due;
+	long long slots = (long long)wheel.size();
+	for (long long second = currentSecond; second <= now && second < currentSecond + slots; second++)
+	{
+		vector<duePayment> &slot = wheel[(size_t)(second % slots)];
+		vector<duePayment>::iterator later = partition(slot.begin(), slot.end(), [now](const duePayment &payment)
+													   { return payment.due > now; });
+		due.insert(due.end(), later, slot.end());
+		slot.erase(later, slot.end());
+	}
+	loaded -= due.size();
+	currentSecond = max(currentSecond, now);
+
+	return due.empty() ? 0 : execute(due, now);
+}
+
+/** @brief Returns the number of payments waiting in the wheel
+ *
+ *  @return returns the number of payments loaded and not yet made
+ */
+size_t paymentScheduler::getLoaded()
+{
+	lock_guard<mutex> guard(databaseLock);
+	return loaded;
+}
+
+/** @brief Runs a tick every second until the scheduler is destroyed
+ */
+void paymentScheduler::work()
+{
+	unique_lock<mutex> guard(stateLock);
+	while (!stopping)
+	{
+		guard.unlock();
+		runDue((long long)time(nullptr));
+		guard.lock();
+		wakeUp.wait_for(guard, chrono::seconds(1), [this]
+						{ return stopping; });
+	}
+}
@@ -0,0 +1,88 @@
+/** @brief Holds the memory used by one request.
+ *
+ *  This class represents the memory for one request, or for the requests of one session. The customer and accounts built for them take
+ *  their strings and containers from it instead of the heap. Allocating just moves a pointer forward, freeing does nothing, and everything
+ *  is given back at once when they are done. Every object built from the arena must be destroyed before the arena is reset.
+ *  sessionManager gives each session one, since the session keeps its customer between requests. Memory a customer frees, such as an
+ *  account list that grew, isn't reused, so the arena counts what it has handed out, and the session rebuilds its customer in a fresh
+ *  arena once that passes a limit.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file requestArena.cpp
+ *  @class requestArena "../include/requestArena.h"
+ */
+
+#include "requestArena.h"
+
+using namespace std;
+
+/** @brief Creates an empty arena
+ *
+ *  The first allocations come from a buffer inside the arena itself, so a small request never touches the heap. Larger requests take
+ *  further blocks from the heap, each bigger than the last.
+ */
+requestArena::requestArena()
+	: resource(initialBuffer, initialSize)
+{
+	used = 0;
+}
+
+/** @brief Returns the arena's memory resource
+ *
+ *  @return returns the memory resource to pass to the request's objects
+ */
+pmr::memory_resource *requestArena::get()
+{
+	return this;
+}
+
+/** @brief Returns how much of the arena has been used
+ *
+ *  @return returns the bytes handed out since the arena was created or last reset
+ */
+size_t requestArena::size() const
+{
+	return used;
+}
+
+/** @brief Frees everything allocated for the request
+ *
+ *  Gives back every block taken from the heap and starts again from the inside buffer, ready for the next request.
+ */
+void requestArena::reset()
+{
+	resource.release();
+	used = 0;
+}
+
+/** @brief Hands out memory from the arena
+ *
+ *  @param bytes Represents the size asked for
+ *  @param alignment Represents the alignment asked for
+ *  @return returns the memory
+ */
+void *requestArena::do_allocate(size_t bytes, size_t alignment)
+{
+	used += bytes;
+	return resource.allocate(bytes, alignment);
+}
+
+/** @brief Takes back memory, which does nothing until the arena is reset
+ *
+ *  @param p Represents the memory
+ *  @param bytes Represents its size
+ *  @param alignment Represents its alignment
+ */
+void requestArena::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+	resource.deallocate(p, bytes, alignment);
+}
+
+/** @brief Checks whether memory from one resource can be freed by another
+ *
+ *  @param other Represents the other resource
+ *  @return returns true only if other is this arena
+ */
+bool requestArena::do_is_equal(const pmr::memory_resource &other) const noexcept
+{
+	return this == &other;
+}
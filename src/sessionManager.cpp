@@ -0,0 +1,277 @@
+/** @brief Keeps logged in users and their loaded data between requests.
+ *
+ *  This class issues a session token when a user logs in, and keeps the customer or administrator object built for that user so later
+ *  requests in the same session don't reload the user row and every account. At most capacity sessions are kept, the least recently used
+ *  ones are dropped first, and sessions that sit idle too long expire. When an administrator changes a user, any objects cached for that
+ *  user are dropped and rebuilt on the next request. Each session's customer and its accounts are allocated from the session's own
+ *  arena, which is freed in one reset when the customer is dropped. The arena lasts as long as the customer it holds, not one request,
+ *  and never reuses memory the customer frees, so a customer whose arena has grown past the configured limit is rebuilt in a fresh one.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file sessionManager.cpp
+ *  @class sessionManager "../include/sessionManager.h"
+ */
+
+#include "sessionManager.h"
+
+using namespace std;
+
+/** @brief Creates an empty session manager
+ *
+ *  @param config Represents the settings the database is opened with, the most sessions kept at once, and how long a session may go
+ *  unused before it expires
+ */
+sessionManager::sessionManager(const bankConfig &config)
+	: config(config), loginPage(config)
+{
+	capacity = config.sessionCapacity > 0 ? config.sessionCapacity : 1;
+	idleSeconds = config.sessionIdleSeconds;
+	arenaLimit = config.sessionArenaBytes > 0 ? config.sessionArenaBytes : 0;
+}
+
+/** @brief Logs a user in and starts a session
+ *
+ *  Checks the username and password, and if they match, starts a new session for the user. The user's customer or administrator object is
+ *  only built when it is first asked for.
+ *  @param username Represents the username entered
+ *  @param password Represents the password entered
+ *  @return returns the new session's token, or an empty string if the username and password don't match or no token could be made
+ */
+string sessionManager::startSession(string username, string password)
+{
+	if (!loginPage.verifyLogin(username, password))
+	{
+		return "";
+	}
+
+	expireIdle();
+
+	// Makes room by dropping the least recently used session
+	while (sessions.size() >= capacity)
+	{
+		tokens.erase(sessions.back().token);
+		sessions.pop_back();
+	}
+
+	session newSession;
+	newSession.token = newToken();
+	if (newSession.token.empty())
+	{
+		return "";
+	}
+	newSession.username = username;
+	newSession.userType = loginPage.checkUserType(username);
+	newSession.lastUsed = time(nullptr);
+	newSession.arena = make_unique<requestArena>();
+
+	sessions.push_front(move(newSession));
+	tokens[sessions.front().token] = sessions.begin();
+	return sessions.front().token;
+}
+
+/** @brief Ends a session
+ *
+ *  @param token Represents the token of the session to end
+ */
+void sessionManager::endSession(string token)
+{
+	unordered_map<string, list<session>::iterator>::iterator found = tokens.find(token);
+	if (found != tokens.end())
+	{
+		sessions.erase(found->second);
+		tokens.erase(found);
+	}
+}
+
+/** @brief Returns the username of a session
+ *
+ *  @param token Represents the session's token
+ *  @return returns the username logged in to the session, or an empty string if the session doesn't exist
+ */
+string sessionManager::getUserName(string token)
+{
+	session *current = find(token);
+	return current != nullptr ? current->username : "";
+}
+
+/** @brief Returns the user type of a session
+ *
+ *  @param token Represents the session's token
+ *  @return returns "regular" or "admin", or an empty string if the session doesn't exist
+ */
+string sessionManager::getUserType(string token)
+{
+	session *current = find(token);
+	return current != nullptr ? current->userType : "";
+}
+
+/** @brief Returns the customer for a session
+ *
+ *  Builds the customer the first time it is asked for, and returns the same object for every later request in the session. If the
+ *  customer's arena has grown past the limit, the customer is dropped and built again in the emptied arena.
+ *  @param token Represents the session's token
+ *  @return returns the session's customer, or nullptr if the session doesn't exist or doesn't belong to a regular user
+ */
+customer *sessionManager::getCustomer(string token)
+{
+	session *current = find(token);
+	if (current == nullptr || current->userType != "regular")
+	{
+		return nullptr;
+	}
+
+	if (current->customerState && current->arena->size() > arenaLimit)
+	{
+		current->customerState.reset();
+		current->arena->reset();
+	}
+	if (!current->customerState)
+	{
+		pmr::polymorphic_allocator<customer> allocator(current->arena->get());
+		current->customerState.reset(allocator.new_object<customer>(current->username, current->arena->get(), config));
+	}
+	return current->customerState.get();
+}
+
+/** @brief Returns the administrator for a session
+ *
+ *  Builds the administrator the first time it is asked for, and returns the same object for every later request in the session. Every user
+ *  the administrator changes has their cached objects dropped.
+ *  @param token Represents the session's token
+ *  @return returns the session's administrator, or nullptr if the session doesn't exist or doesn't belong to an administrator
+ */
+administrator *sessionManager::getAdministrator(string token)
+{
+	session *current = find(token);
+	if (current == nullptr || current->userType != "admin")
+	{
+		return nullptr;
+	}
+
+	if (!current->administratorState)
+	{
+		current->administratorState.reset(new administrator(config));
+		current->administratorState->onUserChanged([this](string username)
+												   { invalidateUser(username); });
+	}
+	return current->administratorState.get();
+}
+
+/** @brief Drops the cached objects for a user
+ *
+ *  Every session belonging to the user keeps going, but its customer is rebuilt from the database on the next request. If the user was
+ *  removed, their sessions are ended instead, so their tokens stop working. A session whose administrator is making the change can't be
+ *  freed while it runs, so it loses its token and is moved to the back of the list to be dropped by the next expiry.
+ *  @param username Represents the user that was changed
+ */
+void sessionManager::invalidateUser(string username)
+{
+	bool removed = loginPage.checkUserType(username).empty();
+	list<session>::iterator it = sessions.begin();
+	while (it != sessions.end())
+	{
+		list<session>::iterator next = std::next(it);
+		if (it->username == username)
+		{
+			it->customerState.reset();
+			it->arena->reset();
+			if (removed && tokens.erase(it->token) > 0)
+			{
+				if (it->administratorState)
+				{
+					it->lastUsed = 0;
+					sessions.splice(sessions.end(), sessions, it);
+				}
+				else
+				{
+					sessions.erase(it);
+				}
+			}
+		}
+		it = next;
+	}
+}
+
+/** @brief Returns the number of live sessions
+ *
+ *  @return returns the number of sessions kept
+ */
+size_t sessionManager::size()
+{
+	return sessions.size();
+}
+
+/** @brief Creates a new session token
+ *
+ *  The bytes come from the kernel's random number generator, so a token can't be predicted from the ones issued before it.
+ *  @return returns 32 random hexadecimal characters that no live session uses, or an empty string if no random bytes could be read
+ */
+string sessionManager::newToken()
+{
+	const char digits[] = "0123456789abcdef";
+	string token;
+	do
+	{
+		unsigned char bytes[16];
+		size_t filled = 0;
+		while (filled < sizeof(bytes))
+		{
+			ssize_t got = getrandom(bytes + filled, sizeof(bytes) - filled, 0);
+			if (got < 0 && errno != EINTR)
+			{
+				cout << "Could not read random bytes for a session token" << endl;
+				return "";
+			}
+			filled += got > 0 ? got : 0;
+		}
+
+		token.clear();
+		for (unsigned char byte : bytes)
+		{
+			token += digits[byte >> 4];
+			token += digits[byte & 0xF];
+		}
+	} while (tokens.count(token) > 0);
+	return token;
+}
+
+/** @brief Finds a live session
+ *
+ *  Finds the session with the given token. If it has been idle too long it is ended, otherwise it is marked as just used and moved to the
+ *  front of the list.
+ *  @param token Represents the session's token
+ *  @return returns the session, or nullptr if it doesn't exist or has expired
+ */
+sessionManager::session *sessionManager::find(string token)
+{
+	unordered_map<string, list<session>::iterator>::iterator found = tokens.find(token);
+	if (found == tokens.end())
+	{
+		return nullptr;
+	}
+
+	time_t now = time(nullptr);
+	if (now - found->second->lastUsed > idleSeconds)
+	{
+		sessions.erase(found->second);
+		tokens.erase(found);
+		return nullptr;
+	}
+
+	found->second->lastUsed = now;
+	sessions.splice(sessions.begin(), sessions, found->second);
+	return &sessions.front();
+}
+
+/** @brief Ends every idle session
+ *
+ *  The least recently used sessions are at the back of the list, so this stops at the first one that is still live.
+ */
+void sessionManager::expireIdle()
+{
+	time_t now = time(nullptr);
+	while (!sessions.empty() && now - sessions.back().lastUsed > idleSeconds)
+	{
+		tokens.erase(sessions.back().token);
+		sessions.pop_back();
+	}
+}
@@ -0,0 +1,319 @@
+/** @brief Spreads the bank's data across several database files.
+ *
+ *  This class splits users, accounts and transactions across a fixed number of SQLite files by a hash of the username, so writers for
+ *  different users take different write locks. A user, their accounts, and the journal entries taking money from those accounts always live
+ *  in the same shard. Account IDs are handed out so that accountID % numShards is the account's shard, so an account can be found without a
+ *  lookup. Each shard gives out its own userIDs, so usernames are resolved in their shard's tables rather than through userIDs(). A transfer
+ *  within one shard only touches that shard's file. A transfer between shards attaches the receiver's file for as long as it runs, and the
+ *  shards use a rollback journal rather than WAL, since SQLite only commits several attached files atomically with a rollback journal.
+ *  Analytics queries run on all shards at once and are combined.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file shardedDatabase.cpp
+ *  @class shardedDatabase "../include/shardedDatabase.h"
+ */
+
+#include "shardedDatabase.h"
+
+using namespace std;
+
+/** @brief Opens every shard
+ *
+ *  Opens or creates the files baseName0.db to baseName(numShards - 1).db and creates the bank's tables in each. The number of shards is
+ *  stored in each file, since changing it would send users to the wrong shard.
+ *  @param baseName Represents the start of each shard's file name
+ *  @param numShards Represents the number of shards, from 1 to maxShards
+ *  @param config Represents the settings each shard's connection is opened with. Its database path isn't used.
+ */
+shardedDatabase::shardedDatabase(string baseName, int numShards, const bankConfig &config)
+{
+	this->baseName = move(baseName);
+	numShards = max(1, min(numShards, maxShards));
+
+	shards.resize(numShards);
+	for (int i = 0; i < numShards; i++)
+	{
+		string path = this->baseName + to_string(i) + ".db";
+		if (!shards[i].open(path.c_str()))
+		{
+			cout << "Can't open database " << path << endl;
+			continue;
+		}
+		config.apply(shards[i]);
+		string mode = shards[i].queryValue<string>("PRAGMA journal_mode;").value_or("");
+		if (mode != "delete" && mode != "truncate" && mode != "persist")
+		{
+			// In WAL mode, a commit across attached files can be half applied by a crash
+			shards[i].exec("PRAGMA journal_mode = DELETE;");
+		}
+		createBankTables(shards[i]);
+
+		shards[i].exec("create table if not exists shardInfo (shardIndex INTEGER, numShards INTEGER);");
+		shards[i].run("insert into shardInfo (shardIndex, numShards) select ?, ? where not exists (select 1 from shardInfo);", i, numShards);
+		optional<int> stored = shards[i].queryValue<int>("SELECT numShards FROM shardInfo;");
+		if (stored && *stored != numShards)
+		{
+			cout << path << " was created for " << *stored << " shards, not " << numShards << endl;
+		}
+	}
+}
+
+/** @brief Returns the number of shards
+ *
+ *  @return returns the number of shard files
+ */
+int shardedDatabase::getNumShards()
+{
+	return (int)shards.size();
+}
+
+/** @brief Finds the shard a user belongs to
+ *
+ *  Uses the FNV-1a hash, which unlike std::hash gives the same result on every run and every platform.
+ *  @param username Represents the user
+ *  @return returns the index of the shard holding the user
+ */
+int shardedDatabase::shardFor(string_view username)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < username.size(); i++)
+	{
+		hash ^= (unsigned char)username[i];
+		hash *= 1099511628211ULL;
+	}
+	return (int)(hash % shards.size());
+}
+
+/** @brief Finds the shard an account belongs to
+ *
+ *  @param accountID Represents the account
+ *  @return returns the index of the shard holding the account, or -1 if the ID is not valid
+ */
+int shardedDatabase::shardOfAccount(int accountID)
+{
+	return accountID > 0 ? accountID % (int)shards.size() : -1;
+}
+
+/** @brief Returns one shard's connection
+ *
+ *  @param index Represents the shard
+ *  @return returns the shard's connection
+ */
+database &shardedDatabase::shard(int index)
+{
+	return shards[index];
+}
+
+/** @brief Creates a user in their shard
+ *
+ *  @param username Represents the new user's username
+ *  @param password Represents the new user's password
+ *  @param name Represents the new user's name
+ *  @param userType Represents "regular" or "admin"
+ *  @return returns true if the user was created, false if the username is taken
+ */
+bool shardedDatabase::createUser(string username, string password, string name, string userType)
+{
+	database &db = shards[shardFor(username)];
+	return db.run("insert or ignore into users (username, password, name, userType) values (?, ?, ?, ?);", username, password, name, userType) &&
+		   db.changes() == 1;
+}
+
+/** @brief Checks a user's username and password
+ *
+ *  @param username Represents the username entered
+ *  @param password Represents the password entered
+ *  @return returns true if they match a user, false otherwise
+ */
+bool shardedDatabase::verifyLogin(string username, string password)
+{
+	return shards[shardFor(username)].queryValue<int>("SELECT EXISTS(SELECT 1 FROM users WHERE username = ? AND password = ?);", username, password).value_or(0) == 1;
+}
+
+/** @brief Creates an account in its owner's shard
+ *
+ *  The new ID is the shard's highest account ID plus the number of shards, so it always points back to this shard. The first account in
+ *  shard i gets the ID i, or numShards for shard 0.
+ *  @param username Represents the owner, who must already exist
+ *  @param kind Represents the type of account
+ *  @param initialMoney Represents the account's opening balance
+ *  @return returns the new account's ID, or -1 if it could not be created
+ */
+int shardedDatabase::createAccount(string username, accountKind kind, double initialMoney)
+{
+	int index = shardFor(username);
+	int numShards = (int)shards.size();
+	int first = index > 0 ? index : numShards;
+	database &db = shards[index];
+
+	bool ok = db.run("INSERT INTO accounts (accountID, userID, accountType, initialBalance, balance) "
+					 "SELECT COALESCE(MAX(accountID) + ?, ?), (SELECT userID FROM users WHERE username = ?), ?, ?, ? FROM accounts;",
+					 numShards, first, username, accountKindName(kind), initialMoney, initialMoney);
+	if (!ok)
+	{
+		cout << "Could not create account: " << db.getError() << endl;
+		return -1;
+	}
+	return (int)db.lastInsertID();
+}
+
+/** @brief Returns an account's balance
+ *
+ *  @param accountID Represents the account
+ *  @return returns the account's balance, or -1 if it doesn't exist
+ */
+double shardedDatabase::getBalance(int accountID)
+{
+	int index = shardOfAccount(accountID);
+	if (index < 0)
+	{
+		return -1;
+	}
+	return shards[index].queryValue<double>("SELECT balance FROM accounts WHERE accountID = ?;", accountID).value_or(-1);
+}
+
+/** @brief Returns the total money a user holds
+ *
+ *  @param username Represents the user
+ *  @return returns the sum of the balances of all the user's accounts
+ */
+double shardedDatabase::getMoney(string username)
+{
+	return shards[shardFor(username)].queryValue<double>("SELECT COALESCE(SUM(a.balance), 0) FROM accounts AS a, users AS u "
+														 "WHERE u.username = ? AND a.userID = u.userID;",
+														 username)
+		.value_or(0);
+}
+
+/** @brief Sends money from one account to another
+ *
+ *  Runs on the sender's shard. A transfer within the shard only locks that shard's file. If the receiver is in another shard, its file is
+ *  attached for this transfer only, its balance is written in the same transaction, and SQLite's rollback journals commit both files
+ *  together or neither. The sender's balance is checked by the statement that takes the money out, so two transfers can't both spend it.
+ *  The commit goes through the change log, like customer::transaction.
+ *  @param senderAccountID Represents the account the money is sent from
+ *  @param receiverAccountID Represents the account the money is sent to
+ *  @param amount Represents the amount sent
+ *  @return returns true if the transfer was made, false otherwise
+ */
+bool shardedDatabase::transfer(int senderAccountID, int receiverAccountID, double amount)
+{
+	int from = shardOfAccount(senderAccountID);
+	int to = shardOfAccount(receiverAccountID);
+	if (from < 0 || to < 0)
+	{
+		cout << "This account doesn't exist!" << endl;
+		return false;
+	}
+
+	database &db = shards[from];
+	string receiver = "main";
+	if (from != to)
+	{
+		string path = baseName + to_string(to) + ".db";
+		if (!db.run("ATTACH DATABASE ? AS receiver;", path))
+		{
+			cout << "Transaction Failed: " << db.getError() << endl;
+			return false;
+		}
+		receiver = "receiver";
+	}
+
+	bool ok = db.exec("BEGIN;");
+	string error = ok ? "" : db.getError();
+	if (ok && db.queryValue<int>("SELECT COUNT(*) FROM " + receiver + ".accounts WHERE accountID = ?;", receiverAccountID).value_or(0) != 1)
+	{
+		ok = false;
+		error = "This account doesn't exist!";
+	}
+	if (ok && (!db.run("UPDATE accounts SET balance = balance - ? WHERE accountID = ? AND balance >= ?;", amount, senderAccountID, amount) ||
+			   db.changes() != 1))
+	{
+		ok = false;
+		error = "Not enough funds remaining.";
+	}
+
+	// The entry is kept in the sender's shard. The receiver's balance is changed in its own shard, in the same database transaction.
+	ok = ok && recordEntry(db, "transfer", senderAccountID, receiverAccountID, amount, amount) >= 0 &&
+		 db.run("UPDATE " + receiver + ".accounts SET balance = balance + ? WHERE accountID = ?;", amount, receiverAccountID);
+	if (!ok)
+	{
+		cout << (error.empty() ? "Transaction Failed: " + db.getError() : error) << endl;
+		db.exec("ROLLBACK;");
+	}
+	else
+	{
+		string username = db.queryValue<string>("SELECT u.username FROM accounts AS a, users AS u WHERE a.accountID = ? AND u.userID = a.userID;",
+												senderAccountID)
+							  .value_or("");
+		ok = changeFeed().commit(db, {{changeType::transfer, senderAccountID, receiverAccountID, amount, username}});
+	}
+	if (from != to)
+	{
+		db.exec("DETACH DATABASE receiver;");
+	}
+	if (ok)
+	{
+		cout << "Transaction Completed." << endl;
+	}
+	return ok;
+}
+
+/** @brief Gets the number of regular users
+ *
+ *  @return returns the number of regular users across every shard
+ */
+int shardedDatabase::getNumUsers()
+{
+	vector<int> counts = fanOut<int>([](database &db)
+									 { return db.queryValue<int>("SELECT COUNT(*) FROM users WHERE userType = \"regular\";").value_or(0); });
+	int total = 0;
+	for (size_t i = 0; i < counts.size(); i++)
+	{
+		total += counts[i];
+	}
+	return total;
+}
+
+/** @brief Gets the number of transactions
+ *
+ *  @return returns the number of journal entries across every shard
+ */
+int shardedDatabase::getNumTransactions()
+{
+	vector<int> counts = fanOut<int>([](database &db)
+									 { return db.queryValue<int>("SELECT COUNT(*) FROM journal;").value_or(0); });
+	int total = 0;
+	for (size_t i = 0; i < counts.size(); i++)
+	{
+		total += counts[i];
+	}
+	return total;
+}
+
+/** @brief Gets the total balance of the regular users
+ *
+ *  @return returns the total balance of every regular user's accounts across every shard
+ */
+double shardedDatabase::getTotalBalance()
+{
+	vector<double> totals = fanOut<double>([](database &db)
+										   { return db.queryValue<double>("SELECT COALESCE(SUM(a.balance), 0) FROM accounts AS a, users AS u "
+																		  "WHERE a.userID = u.userID AND u.userType = \"regular\";")
+												 .value_or(0); });
+	double total = 0;
+	for (size_t i = 0; i < totals.size(); i++)
+	{
+		total += totals[i];
+	}
+	return total;
+}
+
+/** @brief Gets the average balance of the regular users
+ *
+ *  @return returns the total balance of every regular user divided by the number of regular users, or 0 if there are none
+ */
+double shardedDatabase::getAverageBalance()
+{
+	int numUsers = getNumUsers();
+	return numUsers > 0 ? getTotalBalance() / numUsers : 0;
+}
@@ -0,0 +1,24 @@
+#include "accountPurger.h"
+#include "administrator.h"
+using namespace std;
+
+int main() {
+    // Purges on demand only, in small batches so the loop below shows each step
+    bankConfig config = bankSettings();
+    config.purgeBatchSize = 2;
+    config.purgePauseMilliseconds = 0;
+    config.purgeIdleMilliseconds = 0;
+    accountPurger purger(config, false);
+    administrator admin1;
+
+    // Removing a user only queues their accounts, however many journal entries they have
+    admin1.removeUser("user003");
+    cout << "Accounts waiting to be purged = " << purger.getPending() << endl;
+
+    int removed;
+    while ((removed = purger.purgeBatch()) > 0) {
+        cout << "Purged " << removed << " journal entries" << endl;
+    }
+    cout << "Accounts waiting to be purged = " << purger.getPending() << endl;
+    return 1;
+}
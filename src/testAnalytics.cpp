@@ -4,6 +4,9 @@ using namespace std;
 int main() {
     analytics analyticsPage;
 
+    // Every figure below comes from the same point in time
+    analyticsPage.beginSnapshot();
+
     cout << "Num users = " << analyticsPage.getNumUsers() << endl;
     cout << "balance user1 = " << fixed << setprecision(2) << showpoint << analyticsPage.getBalance("user001") << endl;
     cout << "balance user2 = " << analyticsPage.getBalance("user002") << endl;
@@ -15,5 +18,6 @@ int main() {
     cout << "average credit = " << analyticsPage.getAverageCreditScore() << endl;
     cout << "credit score user1 = " << analyticsPage.getCreditScore("user001") << endl;
     cout << "credit score NONEXISTANT = " << analyticsPage.getCreditScore("user01232131201") << endl;
+    analyticsPage.endSnapshot();
     return 1;
 }
\ No newline at end of file
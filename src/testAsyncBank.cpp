@@ -0,0 +1,42 @@
+#include "asyncBank.h"
+using namespace std;
+
+int main() {
+    asyncBank bank;
+    ioPool &pool = bank.getPool();
+
+    task<double> balance = bank.getBalanceAsync(1);
+    cout << "balance account1 = " << pool.wait(balance) << endl;
+
+    task<bool> transfer = bank.transferAsync("user001", 1, 2, 10);
+    bool sent = pool.wait(transfer);
+    cout << "transfer = " << sent << endl;
+
+    task<bool> notOwned = bank.transferAsync("user002", 1, 2, 10);
+    sent = pool.wait(notOwned);
+    cout << "transfer from someone else's account = " << sent << endl;
+
+    // Transfers are screened for fraud the same way as customer::transaction
+    fraudScoring().addRule("test amounts", [](const transferAttempt &attempt, const accountWindow &)
+                           { return attempt.amount == 13 ? 0.6 : attempt.amount == 17 ? 0.95 : 0.0; });
+    task<bool> suspicious = bank.transferAsync("user001", 1, 2, 13);
+    sent = pool.wait(suspicious);
+    cout << "suspicious transfer = " << sent << endl;
+    task<bool> fraudulent = bank.transferAsync("user001", 1, 2, 17);
+    sent = pool.wait(fraudulent);
+    cout << "fraudulent transfer = " << sent << endl;
+    database db("bankDatabase.db");
+    cout << "held transfers of 13 = " << db.queryValue<int>("SELECT COUNT(*) FROM heldTransfers WHERE amount = 13;").value_or(0) << endl;
+
+    // Many requests in flight at once, all driven from this thread
+    vector<task<double>> requests;
+    for (int i = 0; i < 1000; i++) {
+        requests.push_back(bank.getMoneyAsync("user001"));
+    }
+    pool.waitAll(requests);
+    cout << "money user1 = " << requests[0].result() << " (" << requests.size() << " requests)" << endl;
+
+    task<double> average = bank.getAverageBalanceAsync();
+    cout << "average bal = " << pool.wait(average) << endl;
+    return 1;
+}
@@ -0,0 +1,36 @@
+#include "customer.h"
+#include <ctime>
+using namespace std;
+
+int main() {
+    customer user1("user001");
+    account chequing = user1.getAccounts().front();
+    cout << "Balance = " << chequing.getBalance() << endl;
+
+    // A deposit today, after the end of yesterday's checkpoint
+    chequing.deposit(100);
+    database db("bankDatabase.db");
+    cout << "Days checkpointed = " << writeBalanceCheckpoints(db) << endl;
+    cout << "Days checkpointed again = " << writeBalanceCheckpoints(db) << endl;
+
+    // Today's start is read from yesterday's checkpoint, and now from it and today's entries
+    time_t now = time(nullptr);
+    time_t nextSecond = now + 1;
+    char today[16];
+    char later[32];
+    strftime(today, sizeof(today), "%Y-%m-%d", gmtime(&now));
+    strftime(later, sizeof(later), "%Y-%m-%d %H:%M:%S", gmtime(&nextSecond));
+    cout << "Balance at the start of today = " << chequing.getBalanceAsOf(today).value_or(-1) << endl;
+    cout << "Balance now = " << chequing.getBalanceAsOf("9999-12-31").value_or(-1) << ", should be " << chequing.getBalance() << endl;
+    cout << "Balance in 2000 = " << chequing.getBalanceAsOf("2000-01-01").value_or(-1) << endl;
+    cout << "Balance at " << later << " = " << chequing.getBalanceAsOf(later).value_or(-1) << endl;
+
+    // The background writer fills in yesterday when it starts, once the days written so far are gone
+    db.exec("DELETE FROM balanceCheckpoints;");
+    {
+        checkpointWriter checkpoints;
+        this_thread::sleep_for(chrono::milliseconds(500));
+    }
+    cout << "Days the writer checkpointed = " << db.queryValue<int>("SELECT COUNT(DISTINCT day) FROM balanceCheckpoints;").value_or(-1) << endl;
+    return 1;
+}
@@ -0,0 +1,20 @@
+#include <cstdlib>
+#include "bankConfig.h"
+using namespace std;
+
+int main() {
+    // The file turns durability down, and the environment then overrides one of its settings
+    ofstream("test.conf") << "# Throughput over durability\nsynchronous = off\ncacheSize = -65536\nschedulerBatchSize = 20000\njournalMode = sideways\n";
+    setenv("BANK_CACHE_SIZE", "-8192", 1);
+
+    bankConfig config;
+    cout << "Every line valid = " << config.load("test.conf") << endl;
+    config.loadEnvironment();
+    cout << "synchronous = " << config.synchronous << ", journalMode = " << config.journalMode << endl;
+    cout << "cacheSize = " << config.cacheSize << ", schedulerBatchSize = " << config.schedulerBatchSize << endl;
+
+    database db;
+    cout << "Opened with pragmas = " << config.open(db) << endl;
+    cout << "cache_size = " << db.queryValue<int>("PRAGMA cache_size;").value_or(0) << endl;
+    return 1;
+}
@@ -0,0 +1,42 @@
+#include "changeLog.h"
+#include "customer.h"
+#include <fstream>
+using namespace std;
+
+int main() {
+    // Starts following the log at its current end, so only the writes below are printed
+    changeLogReader reader("changes", changeFeed().getEndOffset());
+
+    customer user1("user001");
+    account *chequing = user1.getAccount(1);
+    if (chequing != nullptr) {
+        chequing->deposit(25);
+        chequing->withdraw(10);
+    }
+    user1.transaction(1, 2, 5);
+
+    changeRecord record;
+    while (reader.next(record, chrono::milliseconds(100))) {
+        cout << record.offset << " " << changeTypeName(record.type) << " " << record.username << " account " << record.accountID;
+        if (record.otherAccountID != 0) {
+            cout << " to " << record.otherAccountID;
+        }
+        cout << " amount " << record.amount << endl;
+    }
+    cout << "Resume from offset " << reader.getOffset() << endl;
+
+    // A writer that died between committing and appending leaves its commit marked in the lock file, which is counted as lost
+    changeLog crashed("changesCrashed");
+    unsigned long long lost = crashed.getLostCount();
+    {
+        fstream lockFile("changesCrashed/lock", ios::in | ios::out | ios::binary);
+        lockFile.put('p');
+    }
+    unsigned long long lostAfterCrash = crashed.getLostCount();
+    cout << "Counted as lost = " << (lostAfterCrash > lost) << endl;
+    database db("bankDatabase.db");
+    db.exec("BEGIN;");
+    bool committed = crashed.commit(db, {{changeType::deposit, 1, 0, 1, "user001"}});
+    cout << "Committed = " << committed << ", counted again = " << (crashed.getLostCount() != lostAfterCrash) << endl;
+    return 1;
+}
@@ -0,0 +1,27 @@
+#include "columnarAnalytics.h"
+#include <iomanip>
+using namespace std;
+
+int main() {
+    columnarAnalytics dashboard;
+
+    cout << "Num users = " << dashboard.getNumUsers() << endl;
+    cout << "balance user1 = " << fixed << setprecision(2) << showpoint << dashboard.getBalance("user001") << endl;
+    cout << "balance NONEXISTANT = " << dashboard.getBalance("ua89sdhas") << endl;
+    cout << "average bal = " << dashboard.getAverageBalance() << endl;
+    cout << "numTransactions = " << dashboard.getNumTransactions() << endl;
+    cout << "spending user1 = " << dashboard.getSpending("user001") << endl;
+    cout << "gained user1 = " << dashboard.getGained("user001") << endl;
+
+    map<string, double> byType = dashboard.getTotalByType();
+    for (map<string, double>::iterator it = byType.begin(); it != byType.end(); it++) {
+        cout << "total " << it->first << " = " << it->second << endl;
+    }
+    map<string, double> byDay = dashboard.getTotalByDay("deposit");
+    for (map<string, double>::iterator it = byDay.begin(); it != byDay.end(); it++) {
+        cout << "deposits on " << it->first << " = " << it->second << endl;
+    }
+
+    cout << "new transactions = " << dashboard.refresh() << endl;
+    return 1;
+}
@@ -0,0 +1,24 @@
+#include <fstream>
+#include "currency.h"
+#include "customer.h"
+using namespace std;
+
+int main() {
+    ofstream("rates.txt") << "# CAD is the base currency\nUSD 1.25\nEUR 1.5\n";
+    currencyRates().refresh();
+
+    // Opens a USD account for user003, then sends it 100 CAD from user001's first account
+    customer user3("user003");
+    cout << "Opened XYZ account = " << user3.createAccount("chequing", 0, "XYZ") << endl;
+    cout << "Opened USD account = " << user3.createAccount("chequing", 0, "USD") << endl;
+    customer user1("user001");
+    int receiverAccountID = user3.getAccounts().back().getID();
+    cout << "Sent 100 CAD = " << user1.transaction(1, receiverAccountID, 100) << endl;
+
+    // The receiver gets 80 USD, which is still worth 100 CAD
+    customer reloaded("user003");
+    account received = reloaded.getAccounts().back();
+    cout << "USD balance = " << received.getBalance() << endl;
+    cout << "Total in CAD = " << reloaded.getMoney() << endl;
+    return 1;
+}
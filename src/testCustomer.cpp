@@ -0,0 +1,81 @@
+#include "customer.h"
+#include <set>
+using namespace std;
+
+// Checks that getAccount finds every account the customer holds, at its place in the accounts vector
+static bool indexMatches(customer &holder) {
+    bool matches = true;
+    for (const account &stored : holder.getAccounts()) {
+        matches = matches && holder.getAccount(stored.getID()) == &stored;
+    }
+    return matches;
+}
+
+static set<int> accountIDs(customer &holder) {
+    set<int> ids;
+    for (const account &stored : holder.getAccounts()) {
+        ids.insert(stored.getID());
+    }
+    return ids;
+}
+
+int main() {
+    // Corporate customers hold many accounts of each type, added here straight to the table
+    {
+        database db("bankDatabase.db");
+        addUserIDs(db);
+        int userID = userIDs().find(db, "user003");
+        for (int i = 0; i < 6; i++) {
+            db.run("INSERT INTO accounts (userID, accountType, initialBalance, balance) VALUES (?, ?, ?, ?);",
+                   userID, i % 2 == 0 ? "chequing" : "savings", 100.0 * (i + 1), 100.0 * (i + 1));
+        }
+    }
+
+    customer user3("user003");
+    set<int> before = accountIDs(user3);
+    cout << "accounts = " << before.size() << ", index matches = " << indexMatches(user3) << endl;
+    cout << "chequing = " << user3.checkAccountBalance(accountKind::chequing) << ", savings = " << user3.checkAccountBalance(accountKind::savings) << endl;
+
+    // Deleting an account from the middle moves the last one into its place
+    double savings = user3.checkAccountBalance(accountKind::savings);
+    cout << "delete chequing = " << user3.deleteAccount(accountKind::chequing) << endl;
+    set<int> after = accountIDs(user3);
+    int deleted = -1;
+    for (int id : before) {
+        deleted = after.count(id) == 0 ? id : deleted;
+    }
+    cout << "accounts = " << after.size() << ", index matches = " << indexMatches(user3) << ", deleted account found = " << (user3.getAccount(deleted) != nullptr) << endl;
+    cout << "chequing = " << user3.checkAccountBalance(accountKind::chequing) << ", savings = " << user3.checkAccountBalance(accountKind::savings)
+         << ", should be " << savings << endl;
+
+    // A new account is added at the end and indexed by its type
+    cout << "create chequing = " << user3.createAccount(accountKind::chequing, 42) << endl;
+    cout << "accounts = " << user3.getAccounts().size() << ", index matches = " << indexMatches(user3) << ", chequing = " << user3.checkAccountBalance(accountKind::chequing) << endl;
+    cout << "create chequing again = " << user3.createAccount(accountKind::chequing, 1) << endl;
+
+    cout << "delete savings = " << user3.deleteAccount(accountKind::savings) << endl;
+    cout << "accounts = " << user3.getAccounts().size() << ", index matches = " << indexMatches(user3) << ", savings = " << user3.checkAccountBalance(accountKind::savings) << endl;
+    cout << "delete savings again = " << user3.deleteAccount(accountKind::savings) << endl;
+
+    // Accounts are built in place, by loadAccounts and by createAccount, with the owner's name and currency
+    bool built = true;
+    for (const account &stored : user3.getAccounts()) {
+        built = built && stored.getUserName() == "user003" && stored.getCurrency() == baseCurrency;
+    }
+    cout << "accounts built in place = " << built << endl;
+
+    // Moving a customer hands over its accounts, indexes and connection without copying them
+    customer moved(move(user3));
+    cout << "moved accounts = " << moved.getAccounts().size() << ", left behind = " << user3.getAccounts().size() << ", index matches = " << indexMatches(moved) << endl;
+    customer assigned("user001");
+    assigned = move(moved);
+    cout << "assigned accounts = " << assigned.getAccounts().size() << ", index matches = " << indexMatches(assigned)
+         << ", chequing = " << assigned.checkAccountBalance(accountKind::chequing) << endl;
+
+    // An account moves with its strings, and still reads its balance through the customer's connection
+    account copy = assigned.getAccounts().front();
+    account movedAccount(move(copy));
+    cout << "moved account " << movedAccount.getID() << " of " << movedAccount.getUserName() << " in " << movedAccount.getCurrency()
+         << " = " << movedAccount.getBalance() << endl;
+    return 1;
+}
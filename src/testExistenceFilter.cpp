@@ -0,0 +1,39 @@
+#include "login.h"
+#include "customer.h"
+#include "administrator.h"
+using namespace std;
+
+int main() {
+    // Opening the bank reads every account ID and username into the filters
+    login page;
+
+    // Accounts and users that were never created are turned away without reading the database
+    cout << "Account 1 might exist = " << existenceFilters().mightHaveAccount(1) << endl;
+    cout << "Account 999999 might exist = " << existenceFilters().mightHaveAccount(999999) << endl;
+    cout << "user001 might exist = " << existenceFilters().mightHaveUser("user001") << endl;
+    cout << "nobody might exist = " << existenceFilters().mightHaveUser("nobody") << endl;
+
+    // New users and accounts reach the filters through the change log
+    administrator admin;
+    admin.createUser("Alice", "user004", "fouruser");
+    cout << "user004 might exist = " << existenceFilters().mightHaveUser("user004") << endl;
+    customer user4("user004");
+    user4.createAccount(accountKind::chequing, 10);
+    int accountID = user4.getAccounts().front().getID();
+    cout << "Account " << accountID << " might exist = " << existenceFilters().mightHaveAccount(accountID) << endl;
+
+    // Removing the user closes the account too
+    admin.removeUser("user004");
+    cout << "user004 might exist = " << existenceFilters().mightHaveUser("user004") << endl;
+    cout << "Account " << accountID << " might exist = " << existenceFilters().mightHaveAccount(accountID) << endl;
+
+    // A user added without a record in the log is missed, until the log counts the lost commit and the filters are built again
+    database db("bankDatabase.db");
+    db.run("INSERT INTO users (username, password, name, userType) VALUES ('user005', 'fiveuser', 'Bob', 'customer');");
+    cout << "user005 might exist = " << existenceFilters().mightHaveUser("user005") << endl;
+    FILE *lost = fopen((bankSettings().changeLogDirectory + "/lost").c_str(), "a");
+    fputc('x', lost);
+    fclose(lost);
+    cout << "user005 might exist = " << existenceFilters().mightHaveUser("user005") << endl;
+    return 1;
+}
@@ -0,0 +1,34 @@
+#include "fraudScoring.h"
+using namespace std;
+
+int main() {
+    fraudScorer scorer;
+    const char *names[] = {"allow", "hold", "reject"};
+
+    // Builds up a history of small transfers from account 1 to account 2
+    for (int i = 0; i < 10; i++) {
+        scorer.screen(1, 2, 20 + i);
+    }
+
+    fraudVerdict verdict = scorer.screen(1, 2, 25);
+    cout << "usual amount: " << names[(int)verdict.decision] << endl;
+    verdict = scorer.screen(1, 2, 100);
+    cout << "large amount: " << names[(int)verdict.decision] << " (" << verdict.reason << ")" << endl;
+    verdict = scorer.screen(1, 3, 500);
+    cout << "huge amount to a new account: " << names[(int)verdict.decision] << " (" << verdict.reason << ")" << endl;
+
+    // Goes over the velocity limit
+    for (int i = 0; i < 10; i++) {
+        verdict = scorer.screen(1, 2, 20);
+    }
+    cout << "twenty second transfer in a minute: " << names[(int)verdict.decision] << " (" << verdict.reason << ")" << endl;
+
+    // Times screening for many accounts
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < 1000000; i++) {
+        scorer.screen(100 + i % 5000, 7, 10 + i % 13);
+    }
+    chrono::duration<double, micro> taken = chrono::steady_clock::now() - start;
+    cout << "microseconds per transfer = " << taken.count() / 1000000 << endl;
+    return 1;
+}
@@ -0,0 +1,26 @@
+#include "customer.h"
+using namespace std;
+
+int main() {
+    customer user1("user001");
+    account chequing = user1.getAccounts().front();
+    cout << "Balance = " << chequing.getBalance() << ", available = " << chequing.getAvailableBalance() << endl;
+
+    // Authorizations hold funds without posting anything
+    long long first = chequing.authorize(100);
+    long long second = chequing.authorize(50);
+    cout << "Holds " << first << " and " << second << endl;
+    cout << "Balance = " << chequing.getBalance() << ", available = " << chequing.getAvailableBalance() << endl;
+
+    // Held funds can't be withdrawn, or authorized again
+    cout << "Withdrew everything = " << chequing.withdraw(chequing.getBalance()) << endl;
+    cout << "Authorized everything = " << (chequing.authorize(chequing.getBalance()) >= 0) << endl;
+
+    // The first hold is posted and the second freed, each in one batch
+    database db("bankDatabase.db");
+    cout << "Captured = " << authorizationHolds().capture(db, {first}) << endl;
+    cout << "Released = " << authorizationHolds().release(db, {second}) << endl;
+    cout << "Balance = " << chequing.getBalance() << ", available = " << chequing.getAvailableBalance() << endl;
+    cout << "Holds kept = " << db.queryValue<int>("SELECT COUNT(*) FROM holds;").value_or(0) << endl;
+    return 1;
+}
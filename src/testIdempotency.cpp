@@ -0,0 +1,28 @@
+#include "login.h"
+#include "customer.h"
+#include "asyncBank.h"
+using namespace std;
+
+int main() {
+    login page;
+    customer user1("user001");
+    account chequing = user1.getAccounts().front();
+    cout << "Balance = " << chequing.getBalance() << endl;
+
+    // The second deposit with the same key is a retry, so it returns true without depositing again
+    cout << "Deposited 50 = " << chequing.deposit(50, "deposit-0001") << endl;
+    cout << "Retried = " << chequing.deposit(50, "deposit-0001") << endl;
+    cout << "Balance = " << chequing.getBalance() << endl;
+
+    // A key can't be used again for a different request
+    cout << "Withdrew 10 with the same key = " << chequing.withdraw(10, "deposit-0001") << endl;
+
+    // Transfers are the same, whether they are retried here or on the asynchronous bank
+    cout << "Sent 20 = " << user1.transaction(1, 3, 20, "transfer-0001") << endl;
+    asyncBank bank;
+    task<bool> retry = bank.transferAsync("user001", 1, 3, 20, "transfer-0001");
+    cout << "Retried = " << bank.getPool().wait(retry) << endl;
+    database db("bankDatabase.db");
+    cout << "Transfers = " << db.queryValue<int>("SELECT COUNT(*) FROM journal WHERE entryType = 'transfer';").value_or(0) << endl;
+    return 1;
+}
@@ -0,0 +1,17 @@
+#include "interest.h"
+using namespace std;
+
+int main() {
+    bankConfig config = bankSettings();
+    config.interestChunkSize = 1000;
+    interest dailyInterest(0.02, config);
+
+    cout << "Run date = " << dailyInterest.getRunDate() << endl;
+    cout << "Accounts credited = " << dailyInterest.postDailyInterest() << endl;
+
+    // Running again on the same day finds the finished run and credits nothing twice
+    interest rerun(0.02, config);
+    int creditedBefore = rerun.getAccountsPosted();
+    cout << "Accounts credited on rerun = " << rerun.postDailyInterest() - creditedBefore << endl;
+    return 1;
+}
@@ -0,0 +1,23 @@
+#include "ledger.h"
+#include "customer.h"
+using namespace std;
+
+int main() {
+    // Opening the bank moves any rows of the old transactions table into the journal
+    database db("bankDatabase.db");
+    cout << "Journal created = " << createLedger(db) << endl;
+
+    // A deposit and a transfer are one entry each
+    customer user1("user001");
+    account chequing = user1.getAccounts().front();
+    cout << "Deposited 50 = " << chequing.deposit(50) << endl;
+    cout << "Sent 20 = " << user1.transaction(1, 3, 20) << endl;
+
+    // Money entering the bank comes from the system accounts, so the journal balances with them left in
+    cout << "Entries = " << db.queryValue<int>("SELECT COUNT(*) FROM journal;").value_or(0) << endl;
+    cout << "Cash paid in = " << db.queryValue<double>("SELECT total(amount) FROM journal WHERE debitAccountID = ?;", cashAccountID).value_or(0)
+         << endl;
+    cout << "Last transfer = " << db.queryValue<string>("SELECT debitAccountID || ' -> ' || creditAccountID FROM journal "
+                                                        "WHERE entryType = 'transfer' ORDER BY entryID DESC LIMIT 1;").value_or("none") << endl;
+    return 1;
+}
@@ -0,0 +1,22 @@
+#include "paymentScheduler.h"
+#include "customer.h"
+using namespace std;
+
+int main() {
+    customer user1("user001");
+    paymentScheduler scheduler(bankSettings(), false);
+
+    // A monthly payment on the 31st, and a one-off payment too large for the account
+    long long rent = user1.schedulePayment(1, 3, 100, "2026-01-31 09:00:00", "monthly", 3);
+    long long large = user1.schedulePayment(1, 3, 1000000, "2026-01-31 09:00:00", "once");
+    cout << "Scheduled payments " << rent << " and " << large << endl;
+
+    // Runs the scheduler on the days the payments fall due. The large payment is tried three times and given up on.
+    const char *days[] = {"2026-01-31 09:00:00", "2026-01-31 10:00:00", "2026-01-31 11:00:00", "2026-02-28 09:00:00", "2026-03-31 09:00:00", "2026-04-30 09:00:00"};
+    for (const char *day : days) {
+        cout << day << ": made " << scheduler.runDue(parseTime(day)) << " payments" << endl;
+    }
+    cout << "Payments still waiting = " << scheduler.getLoaded() << endl;
+    cout << "Cancelled finished payment = " << user1.cancelPayment(rent) << endl;
+    return 1;
+}
@@ -0,0 +1,40 @@
+#include "requestArena.h"
+#include "customer.h"
+#include "analytics.h"
+#include "sessionManager.h"
+using namespace std;
+
+int main() {
+    requestArena arena;
+    cout << "empty arena = " << arena.size() << endl;
+
+    // A customer built in the arena takes its accounts and their strings from it
+    {
+        pmr::polymorphic_allocator<customer> allocator(arena.get());
+        customer *user1 = allocator.new_object<customer>("user001", arena.get());
+        cout << "accounts = " << user1->getAccounts().size() << ", arena after customer = " << arena.size() << endl;
+        user1->~customer();
+    }
+    arena.reset();
+    cout << "arena after reset = " << arena.size() << endl;
+
+    // analytics takes each call's list of currency totals from it
+    {
+        analytics analyticsPage(arena.get());
+        double balance = analyticsPage.getBalance("user001");
+        cout << "balance user1 = " << balance << ", arena after analytics = " << arena.size() << endl;
+    }
+    arena.reset();
+
+    // A session whose customer has used more than the limit gets it rebuilt, and it still sees the user's accounts
+    bankConfig config = bankSettings();
+    config.sessionArenaBytes = 1;
+    sessionManager sessions(config);
+    string token = sessions.startSession("user003", "threeuser");
+    size_t accounts = sessions.getCustomer(token)->getAccounts().size();
+    sessions.getCustomer(token)->createAccount(accountKind::chequing, 10);
+    cout << "accounts after opening one = " << sessions.getCustomer(token)->getAccounts().size() << endl;
+    sessions.getCustomer(token)->deleteAccount(accountKind::chequing);
+    cout << "accounts after rebuilds = " << sessions.getCustomer(token)->getAccounts().size() << ", should be " << accounts << endl;
+    return 1;
+}
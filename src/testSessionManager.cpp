@@ -0,0 +1,44 @@
+#include "sessionManager.h"
+#include <thread>
+using namespace std;
+
+int main() {
+    bankConfig config = bankSettings();
+    config.sessionCapacity = 2;
+    config.sessionIdleSeconds = 1;
+    sessionManager sessions(config);
+
+    // Tokens are issued only for a correct login, and look the session up afterwards
+    string user1 = sessions.startSession("user001", "oneuser");
+    cout << "token = " << user1 << " (" << user1.size() << " characters)" << endl;
+    cout << "wrong password token = \"" << sessions.startSession("user001", "wrong") << "\"" << endl;
+    cout << "username = " << sessions.getUserName(user1) << ", type = " << sessions.getUserType(user1) << endl;
+    cout << "unknown token username = \"" << sessions.getUserName("not a token") << "\"" << endl;
+
+    // At the limit, the least recently used session is dropped
+    string user3 = sessions.startSession("user003", "threeuser");
+    sessions.getUserName(user1);
+    string admin = sessions.startSession("admin001", "adminpassword");
+    cout << "sessions = " << sessions.size() << ", user1 kept = " << (sessions.getCustomer(user1) != nullptr)
+         << ", user3 kept = " << (sessions.getCustomer(user3) != nullptr) << endl;
+
+    // Invalidating a user rebuilds their customer from the database on the next request
+    size_t accounts = sessions.getCustomer(user1)->getAccounts().size();
+    {
+        database db("bankDatabase.db");
+        db.run("DELETE FROM accounts WHERE accountID = ?;", sessions.getCustomer(user1)->getAccounts().back().getID());
+    }
+    cout << "accounts before invalidating = " << sessions.getCustomer(user1)->getAccounts().size() << " of " << accounts << endl;
+    sessions.invalidateUser("user001");
+    cout << "accounts after invalidating = " << sessions.getCustomer(user1)->getAccounts().size() << " of " << accounts << endl;
+
+    // A removed user's sessions end, and other sessions carry on
+    sessions.getAdministrator(admin)->removeUser("user001");
+    cout << "removed user's customer = " << (sessions.getCustomer(user1) != nullptr) << ", name = \"" << sessions.getUserName(user1) << "\"" << endl;
+    cout << "admin still logged in = " << (sessions.getAdministrator(admin) != nullptr) << ", sessions = " << sessions.size() << endl;
+
+    // Sessions left idle too long expire
+    this_thread::sleep_for(chrono::seconds(2));
+    cout << "admin after idling = " << (sessions.getAdministrator(admin) != nullptr) << ", sessions = " << sessions.size() << endl;
+    return 1;
+}
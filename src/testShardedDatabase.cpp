@@ -0,0 +1,35 @@
+#include "shardedDatabase.h"
+using namespace std;
+
+int main() {
+    shardedDatabase bank("bankShard", 4);
+
+    bank.createUser("user001", "oneuser", "bob", "regular");
+    bank.createUser("user002", "twouser", "jannet", "regular");
+    bank.createUser("user003", "threeuser", "sarah", "regular");
+    cout << "user001 in shard " << bank.shardFor("user001") << ", user002 in shard " << bank.shardFor("user002") << endl;
+    cout << "login user001 = " << bank.verifyLogin("user001", "oneuser") << endl;
+
+    int chequing = bank.createAccount("user001", accountKind::chequing, 1000);
+    int savings = bank.createAccount("user002", accountKind::savings, 500);
+    cout << "account " << chequing << " in shard " << bank.shardOfAccount(chequing) << ", account " << savings << " in shard " << bank.shardOfAccount(savings) << endl;
+
+    // user001 and user002 may be in different shards, in which case both files are written in one transaction
+    bank.transfer(chequing, savings, 250);
+    bank.transfer(chequing, savings, 5000);
+    cout << "balance " << chequing << " = " << bank.getBalance(chequing) << endl;
+    cout << "balance " << savings << " = " << bank.getBalance(savings) << endl;
+
+    // A transfer within one shard doesn't wait on a writer in another shard
+    int second = bank.createAccount("user001", accountKind::savings, 0);
+    int busy = (bank.shardOfAccount(chequing) + 1) % bank.getNumShards();
+    bank.shard(busy).exec("BEGIN IMMEDIATE;");
+    bool moved = bank.transfer(chequing, second, 50);
+    cout << "transfer while shard " << busy << " is locked = " << moved << endl;
+    bank.shard(busy).exec("COMMIT;");
+
+    cout << "Num users = " << bank.getNumUsers() << endl;
+    cout << "numTransactions = " << bank.getNumTransactions() << endl;
+    cout << "average bal = " << bank.getAverageBalance() << endl;
+    return 1;
+}
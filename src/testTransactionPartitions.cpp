@@ -0,0 +1,40 @@
+#include "transactionPartitions.h"
+#include "budgeting.h"
+using namespace std;
+
+int main() {
+    transactionPartitions partitions;
+
+    // Seals every month before this one into its own read-only file
+    cout << "Months sealed = " << partitions.sealCompletedMonths() << endl;
+
+    vector<string> months = partitions.getSealedMonths();
+    for (size_t i = 0; i < months.size(); i++) {
+        cout << "Sealed " << months[i] << endl;
+    }
+
+    // Rewrites the oldest month as a columnar archive, which is still readable by date range
+    if (!months.empty()) {
+        cout << "Archived " << months[0] << " = " << partitions.archiveMonth(months[0]) << endl;
+    }
+
+    int count = 0;
+    double total = 0;
+    partitions.forEachInRange("2000-01-01 00:00:00", "2100-01-01 00:00:00", [&](const transactionRecord &row) {
+        count++;
+        total += row.amount;
+    });
+    cout << "Transactions in range = " << count << ", total = " << total << endl;
+
+    cout << "Statement for account 1:" << endl;
+    partitions.forEachForAccount(1, "2000-01-01 00:00:00", "2100-01-01 00:00:00", [](const transactionRecord &row) {
+        // A transfer between currencies credits the receiver a different amount than it debits the sender
+        cout << "  " << row.transactionTime << " " << row.transactionType << " " << (row.receiverAccountID == 1 ? row.creditAmount : row.amount) << endl;
+    });
+
+    // Budgeting still counts the sealed months
+    budgeting user1("user001");
+    cout << "spending user1 = " << user1.getSpending() << endl;
+    cout << "gained user1 = " << user1.getGained() << endl;
+    return 1;
+}
@@ -0,0 +1,24 @@
+#include "login.h"
+#include "customer.h"
+#include "budgeting.h"
+using namespace std;
+
+int main() {
+    // Opening the bank keys users by userID, rebuilding tables made before it
+    login page;
+    cout << "user001 logged in = " << page.verifyLogin("user001", "oneuser") << endl;
+
+    // The login remembered the ID, so the customer and budgeting page don't look the username up again
+    database db("bankDatabase.db");
+    int userID = userIDs().find(db, "user001");
+    cout << "user001 is user " << userID << endl;
+
+    customer user1("user001");
+    for (const account &owned : user1.getAccounts()) {
+        cout << "Account " << owned.getID() << " belongs to user " << owned.getUserID() << endl;
+    }
+    budgeting page1("user001");
+    cout << "Initial balance = " << page1.getInitialBalance() << endl;
+    cout << "Unknown user = " << userIDs().find(db, "nobody") << endl;
+    return 1;
+}
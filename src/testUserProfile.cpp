@@ -0,0 +1,24 @@
+#include "administrator.h"
+using namespace std;
+
+int main() {
+    administrator admin;
+
+    // Every field of a user comes back from one query
+    optional<userProfile> profile = admin.getUserProfile("user001");
+    if (profile) {
+        cout << profile->username << " (" << profile->userID << ") " << profile->name << ", credit " << profile->creditScore
+             << ", debt " << profile->loanDebt << ", " << profile->userType << endl;
+    }
+
+    // Several users are read together, and users that don't exist are left empty
+    vector<optional<userProfile>> profiles = admin.getUserProfiles({"user002", "nobody", "admin001"});
+    for (const optional<userProfile> &found : profiles) {
+        cout << (found ? found->username + " is " + found->userType : "not found") << endl;
+    }
+
+    // Changing a user drops the kept profile, so the next read sees the change
+    admin.updateCreditScore("user001", 720);
+    cout << "CREDIT = " << admin.getUserCreditScore("user001") << endl;
+    return 1;
+}
@@ -0,0 +1,438 @@
+/** @brief Splits transaction history into one sealed file per month.
+ *
+ *  This class keeps only the current month in the live journal. Each finished month is moved into its own database file, which
+ *  is then made read-only, and the totals of each account for that month are kept in the small monthlyTotals table so budgeting can add up
+ *  the whole history without opening old months. Sealed months are attached only when a query asks for a date range that covers them.
+ *  Once a month is older than the archive age it is rewritten as a compressed columnar archive, which is read in place through mmap.
+ *  Scans of the live journal stay the same size however long the bank runs.
+ *
+ *  A month's file keeps each journal entry as one row, the debited account as the sender and the credited one as the receiver, with the
+ *  amount credited in the receiver's currency. Months sealed before the journal was added have a send row and a receive row for each
+ *  transfer instead, and are read as they are. Files sealed before credited amounts were kept are read as crediting the amount debited.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file transactionPartitions.cpp
+ *  @class transactionPartitions "../include/transactionPartitions.h"
+ */
+
+#include "transactionPartitions.h"
+
+using namespace std;
+
+// A query result holding only a month
+struct monthRow
+{
+	string month;
+	static auto columns() { return make_tuple(&monthRow::month); }
+};
+
+/** @brief Returns the month after a month
+ *
+ *  @param month Represents a month, as YYYY-MM
+ *  @return returns the following month, as YYYY-MM
+ */
+static string nextMonth(const string &month)
+{
+	int year = stoi(month.substr(0, 4));
+	int number = stoi(month.substr(5, 2)) + 1;
+	if (number > 12)
+	{
+		number = 1;
+		year++;
+	}
+	char result[32];
+	snprintf(result, sizeof(result), "%04d-%02d", year, number);
+	return result;
+}
+
+/** @brief Opens the live database and the partition catalog
+ *
+ *  @param config Represents the settings the database holding the live journal is opened with, and the folder the monthly
+ *  files are written to
+ */
+transactionPartitions::transactionPartitions(const bankConfig &config)
+{
+	directory = config.partitionDirectory;
+
+	config.open(DB);
+	createLedger(DB);
+
+	// One row for each sealed month
+	DB.exec("create table if not exists partitions ("
+			"month varchar(7) PRIMARY KEY, "
+			"path TEXT NOT NULL, "
+			"rows INTEGER DEFAULT 0, "
+			"archived INTEGER DEFAULT 0);");
+
+	// Each account's total for each transaction type in each sealed month. A transfer counts as a send for the account it was debited
+	// from and a receive for the account it was credited to, as budgeting adds them up.
+	DB.exec("create table if not exists monthlyTotals ("
+			"month varchar(7), "
+			"accountID INTEGER, "
+			"transactionType varchar(10), "
+			"total decimal(15,2) DEFAULT 0, "
+			"count INTEGER DEFAULT 0, "
+			"PRIMARY KEY (month, accountID, transactionType));");
+}
+
+/** @brief Seals every finished month
+ *
+ *  Moves each month before beforeMonth out of the live journal into its own file, one month per database transaction.
+ *  @param beforeMonth Represents the first month that stays live, as YYYY-MM, or "" for the current month
+ *  @return returns the number of months sealed, or -1 if one failed
+ */
+int transactionPartitions::sealCompletedMonths(string beforeMonth)
+{
+	if (beforeMonth.empty())
+	{
+		char month[8];
+		time_t now = time(nullptr);
+		strftime(month, sizeof(month), "%Y-%m", gmtime(&now)); // entryTime is stored in UTC
+		beforeMonth = month;
+	}
+
+	vector<string> months;
+	DB.forEach<monthRow>("SELECT DISTINCT substr(entryTime, 1, 7) FROM journal WHERE entryTime < ? ORDER BY 1;",
+						 [&](const monthRow &row)
+						 { months.push_back(row.month); },
+						 beforeMonth + "-01 00:00:00");
+
+	for (size_t i = 0; i < months.size(); i++)
+	{
+		if (!sealMonth(months[i]))
+		{
+			return -1;
+		}
+	}
+	return (int)months.size();
+}
+
+/** @brief Archives every month older than an age
+ *
+ *  Seals every finished month first, then rewrites each sealed month that ended more than days ago as a columnar archive.
+ *  @param days Represents the age, in days, after which a month is archived
+ *  @return returns the number of months archived, or -1 if one failed
+ */
+int transactionPartitions::archiveOlderThan(int days)
+{
+	if (sealCompletedMonths() < 0)
+	{
+		return -1;
+	}
+
+	time_t cutoff = time(nullptr) - (time_t)days * 86400;
+	vector<string> months;
+	DB.forEach<monthRow>("SELECT month FROM partitions WHERE archived = 0 ORDER BY month;", [&](const monthRow &row)
+						 { months.push_back(row.month); });
+
+	int archived = 0;
+	for (size_t i = 0; i < months.size(); i++)
+	{
+		if (parseTime(nextMonth(months[i]) + "-01 00:00:00") > cutoff)
+		{
+			break;
+		}
+		if (!archiveMonth(months[i]))
+		{
+			return -1;
+		}
+		archived++;
+	}
+	return archived;
+}
+
+/** @brief Rewrites a sealed month as a columnar archive
+ *
+ *  The archive is read back and its row count checked before the month's database file is removed. The month can still be read by
+ *  forEachInRange and forEachForAccount.
+ *  @param month Represents the month, as YYYY-MM
+ *  @return returns true if the month is archived, false if it isn't sealed or could not be written
+ */
+bool transactionPartitions::archiveMonth(string month)
+{
+	optional<int> archived = DB.queryValue<int>("SELECT archived FROM partitions WHERE month = ?;", month);
+	if (!archived)
+	{
+		cout << "Month " << month << " is not sealed" << endl;
+		return false;
+	}
+	if (*archived == 1)
+	{
+		return true;
+	}
+
+	if (!attachPartition(month))
+	{
+		return false;
+	}
+	vector<archivedTransaction> rows;
+	string credited = hasCreditColumn(month) ? "COALESCE(creditAmount, amount)" : "amount";
+	bool ok = DB.forEach<archivedTransaction>("SELECT transactionID, senderAccountID, receiverAccountID, transactionType, amount, " + credited +
+												  ", CAST(strftime('%s', transactionTime) AS INTEGER) FROM " + schemaName(month) +
+												  ".transactions ORDER BY transactionID;",
+											  [&](const archivedTransaction &row)
+											  { rows.push_back(row); });
+	detachPartition(month);
+
+	string path = archivePath(month);
+	columnarArchive check;
+	if (!ok || !columnarArchive::write(path, rows) || !check.open(path) || check.getRowCount() != rows.size())
+	{
+		cout << "Could not archive " << month << endl;
+		remove(path.c_str());
+		return false;
+	}
+	if (!DB.run("UPDATE partitions SET archived = 1, path = ? WHERE month = ?;", path, month))
+	{
+		remove(path.c_str());
+		return false;
+	}
+
+	string sealedPath = partitionPath(month);
+	chmod(sealedPath.c_str(), 0644);
+	remove(sealedPath.c_str());
+	return true;
+}
+
+/** @brief Returns the sealed months
+ *
+ *  @return returns every sealed month, oldest first, as YYYY-MM
+ */
+vector<string> transactionPartitions::getSealedMonths()
+{
+	vector<string> months;
+	DB.forEach<monthRow>("SELECT month FROM partitions ORDER BY month;", [&](const monthRow &row)
+						 { months.push_back(row.month); });
+	return months;
+}
+
+/** @brief Reads every transaction in a time range
+ *
+ *  Only the sealed months that overlap the range are opened, one at a time, followed by the live table.
+ *  @param fromTime Represents the start of the range, included, as YYYY-MM-DD HH:MM:SS
+ *  @param toTime Represents the end of the range, not included, as YYYY-MM-DD HH:MM:SS
+ *  @param visit Called with each transaction, oldest month first
+ *  @return returns true if every month in the range was read, false otherwise
+ */
+bool transactionPartitions::forEachInRange(string fromTime, string toTime, function<void(const transactionRecord &)> visit)
+{
+	return readRange(fromTime, toTime, -1, visit);
+}
+
+/** @brief Reads an account's statement for a time range
+ *
+ *  Reads every transaction that debits or credits the account, from sealed, archived and live history, so both sides of a transfer
+ *  appear. Archive blocks that hold no rows for the account are skipped.
+ *  @param accountID Represents the account
+ *  @param fromTime Represents the start of the range, included, as YYYY-MM-DD HH:MM:SS
+ *  @param toTime Represents the end of the range, not included, as YYYY-MM-DD HH:MM:SS
+ *  @param visit Called with each transaction, oldest month first
+ *  @return returns true if every month in the range was read, false otherwise
+ */
+bool transactionPartitions::forEachForAccount(int accountID, string fromTime, string toTime, function<void(const transactionRecord &)> visit)
+{
+	return readRange(fromTime, toTime, accountID, visit);
+}
+
+/** @brief Reads transactions in a time range from wherever they are stored
+ *
+ *  @param fromTime Represents the start of the range, included, as YYYY-MM-DD HH:MM:SS
+ *  @param toTime Represents the end of the range, not included, as YYYY-MM-DD HH:MM:SS
+ *  @param accountID Represents the account to read, or -1 for every account
+ *  @param visit Called with each transaction, oldest month first
+ *  @return returns true if every month in the range was read, false otherwise
+ */
+bool transactionPartitions::readRange(const string &fromTime, const string &toTime, int accountID, const function<void(const transactionRecord &)> &visit)
+{
+	struct partitionRow
+	{
+		string month;
+		string path;
+		int archived;
+		static auto columns() { return make_tuple(&partitionRow::month, &partitionRow::path, &partitionRow::archived); }
+	};
+
+	vector<partitionRow> months;
+	DB.forEach<partitionRow>("SELECT month, path, archived FROM partitions WHERE month >= substr(?, 1, 7) AND month <= substr(?, 1, 7) ORDER BY month;",
+							 [&](const partitionRow &row)
+							 { months.push_back(row); },
+							 fromTime, toTime);
+
+	// Every query binds accountID. When no account is asked for, the extra condition is always true. Old send rows have a receive row
+	// under the receiver, so only the sender matches them.
+	string sealedFilter = accountID >= 0 ? " AND (senderAccountID = ?3 OR (receiverAccountID = ?3 AND transactionType <> 'send'))" : " AND ?3 < 0";
+	string liveFilter = accountID >= 0 ? " AND (debitAccountID = ?3 OR creditAccountID = ?3)" : " AND ?3 < 0";
+
+	bool ok = true;
+	for (size_t i = 0; i < months.size() && ok; i++)
+	{
+		if (months[i].archived == 1)
+		{
+			columnarArchive archive;
+			ok = archive.open(months[i].path) && archive.forEach(parseTime(fromTime), parseTime(toTime), accountID, visit);
+			if (!ok)
+			{
+				cout << "Could not read " << months[i].path << endl;
+			}
+			continue;
+		}
+		if (!attachPartition(months[i].month))
+		{
+			return false;
+		}
+		string credited = hasCreditColumn(months[i].month) ? "COALESCE(creditAmount, amount)" : "amount";
+		ok = DB.forEach<transactionRecord>("SELECT transactionID, senderAccountID, receiverAccountID, transactionType, amount, " + credited +
+											   ", transactionTime FROM " + schemaName(months[i].month) +
+											   ".transactions WHERE transactionTime >= ?1 AND transactionTime < ?2" + sealedFilter + " ORDER BY transactionID;",
+										   visit, fromTime, toTime, accountID);
+		detachPartition(months[i].month);
+	}
+
+	return ok && DB.forEach<transactionRecord>("SELECT entryID, debitAccountID, creditAccountID, entryType, amount, creditAmount, entryTime "
+											   "FROM journal WHERE entryTime >= ?1 AND entryTime < ?2" +
+												   liveFilter + " ORDER BY entryID;",
+											   visit, fromTime, toTime, accountID);
+}
+
+/** @brief Returns the file a month is sealed into
+ *
+ *  @param month Represents the month, as YYYY-MM
+ *  @return returns the path of the month's database file
+ */
+string transactionPartitions::partitionPath(const string &month)
+{
+	return directory + "/transactions_" + month + ".db";
+}
+
+/** @brief Returns the file a month is archived into
+ *
+ *  @param month Represents the month, as YYYY-MM
+ *  @return returns the path of the month's columnar archive
+ */
+string transactionPartitions::archivePath(const string &month)
+{
+	return directory + "/transactions_" + month + ".bca";
+}
+
+/** @brief Returns the name a month is attached under
+ *
+ *  @param month Represents the month, as YYYY-MM
+ *  @return returns a schema name such as p2024_01
+ */
+string transactionPartitions::schemaName(const string &month)
+{
+	return "p" + month.substr(0, 4) + "_" + month.substr(5, 2);
+}
+
+/** @brief Attaches a sealed month
+ *
+ *  @param month Represents the month, as YYYY-MM, which must not be archived
+ *  @return returns true if the month is attached, false otherwise
+ */
+bool transactionPartitions::attachPartition(const string &month)
+{
+	string path = partitionPath(month);
+	if (!DB.run("ATTACH DATABASE ? AS " + schemaName(month) + ";", path))
+	{
+		cout << "Could not attach " << path << ": " << DB.getError() << endl;
+		return false;
+	}
+	return true;
+}
+
+/** @brief Detaches a sealed month
+ *
+ *  @param month Represents the month, as YYYY-MM
+ */
+void transactionPartitions::detachPartition(const string &month)
+{
+	DB.exec(("DETACH DATABASE " + schemaName(month) + ";").c_str());
+}
+
+/** @brief Checks whether an attached month's file keeps the amount credited to the receiver
+ *
+ *  @param month Represents the month, as YYYY-MM
+ *  @return returns true if its transactions table has a creditAmount column
+ */
+bool transactionPartitions::hasCreditColumn(const string &month)
+{
+	return DB.queryValue<int>("SELECT COUNT(*) FROM pragma_table_info('transactions', ?) WHERE name = 'creditAmount';", schemaName(month)).value_or(0) > 0;
+}
+
+/** @brief Moves one month out of the live table
+ *
+ *  SQLite only commits several files atomically with a rollback journal, and the live database may use WAL, so each database transaction
+ *  here writes one file. The first copies the month's journal entries into its file, skipping entries already there. The second adds the
+ *  entries found in the file to monthlyTotals, records them in the catalog, and deletes them from the live journal. A crash between the
+ *  two leaves the entries in both files, and sealing the month again finishes the move. The file is then made read-only. A month sealed
+ *  before gets any rows added since appended to it.
+ *  @param month Represents the month, as YYYY-MM
+ *  @return returns true if the month was sealed, false otherwise
+ */
+bool transactionPartitions::sealMonth(const string &month)
+{
+	string path = partitionPath(month);
+	string schema = schemaName(month);
+	string from = month + "-01 00:00:00";
+	string to = nextMonth(month) + "-01 00:00:00";
+
+	if (DB.queryValue<int>("SELECT archived FROM partitions WHERE month = ?;", month).value_or(0) == 1)
+	{
+		cout << "Month " << month << " is archived and can't take new rows" << endl;
+		return false;
+	}
+
+	chmod(path.c_str(), 0644);
+	if (!DB.run("ATTACH DATABASE ? AS " + schema + ";", path))
+	{
+		cout << "Could not attach " << path << ": " << DB.getError() << endl;
+		return false;
+	}
+
+	// Copies the month into its file. Only the file is written, and entries copied by an earlier, interrupted seal are skipped.
+	bool ok = DB.exec("BEGIN;") &&
+			  DB.exec(("create table if not exists " + schema + ".transactions ("
+															   "transactionID INTEGER PRIMARY KEY, "
+															   "senderAccountID INTEGER, "
+															   "receiverAccountID INTEGER, "
+															   "transactionType varchar(10) NOT NULL, "
+															   "amount decimal(15,2) NOT NULL, "
+															   "transactionTime DATETIME NOT NULL, "
+															   "creditAmount decimal(15,2));")
+						  .c_str()) &&
+			  (hasCreditColumn(month) || DB.exec(("ALTER TABLE " + schema + ".transactions ADD COLUMN creditAmount decimal(15,2);").c_str())) &&
+			  DB.exec(("create index if not exists " + schema + ".transactionsBySender on transactions(senderAccountID);").c_str()) &&
+			  DB.run("INSERT OR IGNORE INTO " + schema + ".transactions (transactionID, senderAccountID, receiverAccountID, transactionType, amount, "
+														 "transactionTime, creditAmount) SELECT entryID, debitAccountID, creditAccountID, entryType, amount, entryTime, "
+														 "creditAmount FROM main.journal WHERE entryTime >= ? AND entryTime < ?;",
+					 from, to) &&
+			  DB.exec("COMMIT;");
+	bool copied = ok;
+
+	// Moves every entry now in the file out of the live journal. Only the live database is written.
+	string inFile = " AND entryID IN (SELECT transactionID FROM " + schema + ".transactions)";
+	ok = ok && DB.exec("BEGIN IMMEDIATE;");
+	int moved = ok ? DB.queryValue<int>("SELECT COUNT(*) FROM main.journal WHERE entryTime >= ? AND entryTime < ?" + inFile + ";", from, to).value_or(-1) : 0;
+	ok = ok && moved >= 0 &&
+		 DB.run("INSERT INTO monthlyTotals (month, accountID, transactionType, total, count) "
+				"SELECT ?1, accountID, transactionType, SUM(amount), COUNT(*) FROM ("
+				"SELECT debitAccountID AS accountID, CASE entryType WHEN 'transfer' THEN 'send' ELSE entryType END AS transactionType, amount "
+				"FROM main.journal WHERE entryTime >= ?2 AND entryTime < ?3 AND debitAccountID >= 0" + inFile + " "
+				"UNION ALL SELECT creditAccountID, CASE entryType WHEN 'transfer' THEN 'receive' ELSE entryType END, creditAmount "
+				"FROM main.journal WHERE entryTime >= ?2 AND entryTime < ?3 AND creditAccountID >= 0" + inFile + ") "
+				"GROUP BY accountID, transactionType "
+				"ON CONFLICT (month, accountID, transactionType) DO UPDATE SET total = total + excluded.total, count = count + excluded.count;",
+				month, from, to) &&
+		 DB.run("INSERT INTO partitions (month, path, rows) VALUES (?, ?, ?) ON CONFLICT (month) DO UPDATE SET rows = rows + excluded.rows;",
+				month, path, moved) &&
+		 DB.run("DELETE FROM main.journal WHERE entryTime >= ? AND entryTime < ?" + inFile + ";", from, to) &&
+		 DB.exec("COMMIT;");
+
+	if (!ok)
+	{
+		cout << "Could not " << (copied ? "seal " : "copy ") << month << ": " << DB.getError() << endl;
+		DB.exec("ROLLBACK;");
+	}
+	DB.exec(("DETACH DATABASE " + schema + ";").c_str());
+	chmod(path.c_str(), 0444);
+	return ok;
+}
@@ -0,0 +1,155 @@
+/** @brief Resolves usernames to the integer IDs users are keyed by.
+ *
+ *  Accounts refer to their owner by userID, so loading a customer's accounts, and every budgeting and analytics join, compares integers
+ *  through a small index instead of username strings. A username is read from the users table once, and this class remembers its ID for
+ *  the rest of the process. IDs are never reused, so a remembered ID can't come to mean another user.
+ *  @authors Yazan Marwan Alazraq, Rami Istwani, Abdulrehman Khan, You-Chia Kuo, Patrick Rocha
+ *  @file userDirectory.cpp
+ *  @class userDirectory "../include/userDirectory.h"
+ */
+
+#include "userDirectory.h"
+
+using namespace std;
+
+/** @brief Rebuilds the users and accounts tables around an integer userID
+ *
+ *  Databases made before userIDs keyed users by username, and accounts by their owner's username. SQLite can't change a table's key, so
+ *  both tables are copied into new ones, in username order, and the old ones dropped, all in one database transaction. Account IDs are
+ *  kept, and so is the highest account ID ever given out, so deleted accounts' IDs are still never reused. Foreign keys are turned off
+ *  while the tables are swapped, so dropping the old users table doesn't cascade. Accounts made before currencies are given their column
+ *  first.
+ *  @param db Represents the database the tables are in
+ *  @return returns true if the tables are keyed by userID afterwards
+ */
+bool addUserIDs(database &db)
+{
+	const char *findUserID = "SELECT COUNT(*) FROM pragma_table_info('users') WHERE name = 'userID';";
+	if (db.queryValue<int>(findUserID).value_or(0) > 0)
+	{
+		return true;
+	}
+	if (!addCurrencyColumn(db))
+	{
+		return false;
+	}
+
+	int foreignKeys = db.queryValue<int>("PRAGMA foreign_keys;").value_or(0);
+	db.exec("PRAGMA foreign_keys = OFF;");
+
+	// Another process may have rebuilt the tables while this one waited for the lock
+	bool ok = db.exec("BEGIN IMMEDIATE;");
+	if (ok && db.queryValue<int>(findUserID).value_or(0) > 0)
+	{
+		ok = db.exec("COMMIT;");
+		db.exec(foreignKeys == 1 ? "PRAGMA foreign_keys = ON;" : "PRAGMA foreign_keys = OFF;");
+		return ok;
+	}
+
+	ok = ok &&
+		 db.exec("create table usersByID ("
+				 "userID INTEGER PRIMARY KEY AUTOINCREMENT, "
+				 "username varchar(20) NOT NULL UNIQUE, "
+				 "password varchar(20) NOT NULL, "
+				 "name varchar(20), "
+				 "creditScore INTEGER DEFAULT 300, "
+				 "loanDebt decimal(15,2) DEFAULT 0, "
+				 "userType varchar(10) NOT NULL);") &&
+		 db.exec("INSERT INTO usersByID (username, password, name, creditScore, loanDebt, userType) "
+				 "SELECT username, password, name, creditScore, loanDebt, userType FROM users WHERE username IS NOT NULL ORDER BY username;") &&
+		 db.exec("create table accountsByID ("
+				 "accountID INTEGER PRIMARY KEY AUTOINCREMENT, "
+				 "userID INTEGER NOT NULL, "
+				 "accountType varchar(15) NOT NULL, "
+				 "initialBalance decimal(15,2), "
+				 "balance decimal(15,2), "
+				 "currency varchar(3) NOT NULL DEFAULT 'CAD', "
+				 "FOREIGN KEY (userID) REFERENCES users(userID) ON DELETE CASCADE);") &&
+		 db.exec("INSERT INTO accountsByID (accountID, userID, accountType, initialBalance, balance, currency) "
+				 "SELECT a.accountID, u.userID, a.accountType, a.initialBalance, a.balance, a.currency FROM accounts AS a, usersByID AS u "
+				 "WHERE a.username = u.username;") &&
+		 db.exec("DELETE FROM sqlite_sequence WHERE name = 'accountsByID';") &&
+		 db.exec("INSERT INTO sqlite_sequence (name, seq) SELECT 'accountsByID', MAX(seq) FROM ("
+				 "SELECT seq FROM sqlite_sequence WHERE name = 'accounts' UNION ALL SELECT MAX(accountID) FROM accountsByID) HAVING MAX(seq) IS NOT NULL;") &&
+		 db.exec("DROP TABLE accounts;") &&
+		 db.exec("DROP TABLE users;") &&
+		 db.exec("ALTER TABLE usersByID RENAME TO users;") &&
+		 db.exec("ALTER TABLE accountsByID RENAME TO accounts;") &&
+		 db.exec("create index if not exists accountsByUser on accounts(userID);") &&
+		 db.exec("COMMIT;");
+	if (!ok)
+	{
+		cout << "Could not key users by userID: " << db.getError() << endl;
+		db.exec("ROLLBACK;");
+	}
+	db.exec(foreignKeys == 1 ? "PRAGMA foreign_keys = ON;" : "PRAGMA foreign_keys = OFF;");
+	return ok;
+}
+
+/** @brief Returns a user's ID
+ *
+ *  A username the existence filters have never seen isn't looked up, so customers and analytics asking for users that don't exist
+ *  don't reach the database.
+ *  @param db Represents the database the user is read from, if their ID isn't known yet
+ *  @param username Represents the user's username
+ *  @return returns the user's ID, or -1 if there is no such user
+ */
+int userDirectory::find(database &db, string_view username)
+{
+	{
+		shared_lock<shared_mutex> reading(lock);
+		auto found = ids.find(username);
+		if (found != ids.end())
+		{
+			return found->second;
+		}
+	}
+	if (!existenceFilters().mightHaveUser(username))
+	{
+		return -1;
+	}
+
+	optional<int> userID = db.queryValue<int>("SELECT userID FROM users WHERE username = ?;", username);
+	if (!userID)
+	{
+		return -1;
+	}
+	remember(username, *userID);
+	return *userID;
+}
+
+/** @brief Records a user's ID
+ *
+ *  @param username Represents the user's username
+ *  @param userID Represents the ID read for them
+ */
+void userDirectory::remember(string_view username, int userID)
+{
+	unique_lock<shared_mutex> writing(lock);
+	ids.insert_or_assign(string(username), userID);
+}
+
+/** @brief Forgets a user's ID
+ *
+ *  Called when a user is removed, since a new user can then sign up with the same username and will be given a new ID.
+ *  @param username Represents the user's username
+ */
+void userDirectory::forget(string_view username)
+{
+	unique_lock<shared_mutex> writing(lock);
+	auto found = ids.find(username);
+	if (found != ids.end())
+	{
+		ids.erase(found);
+	}
+}
+
+/** @brief Returns the directory this process resolves usernames through
+ *
+ *  @return returns the directory, created the first time it is asked for
+ */
+userDirectory &userIDs()
+{
+	static userDirectory directory;
+	return directory;
+}